@@ -0,0 +1,226 @@
+// --- analyze: 局面を1行ずつ流し読みして解析結果を書き出す（SDL 不要） ---
+// 使い方:
+//   analyze [file|-] [--out file] [--threads T] [--batch N] [--eval] [--depth D] [--hash MB] [--tb dir]
+// 入力は serializeBoard の65文字（64マス + 手番）を1行に1局面。ファイルを省略するか - なら標準入力。
+// 出力は入力と同じ順に1行ずつ:
+//   <局面> check=0|1 threat=0|1 moves=N <手>:<反転数>[!] ... [eval=cp] [tb=win|loss|draw] [score=cp best=手 depth=D]
+//   check  = 手番側のキングが取られる／挟まれる状態
+//   threat = 手番側が次の一手で相手キングを取れる／挟める状態
+//   !      = 相手キングを取る／反転させる手
+//   tb     = --tb の表にある局面の、手番側から見た結果（探索も表を引く）
+// 読めない行は "<行> error"、手番側のキングがない局面は "<局面> over" になる。
+// 入力を N 行ずつの塊に分けてスレッドプールに投げ、書き出しは先頭の塊が終わるのを待って
+// 順番に行う。同時に抱える塊は一定数までなので、何百万行あってもメモリは増えない。
+#include "search.h"
+#include "eval.h"
+#include "thread_pool.h"
+#include "tablebase.h"
+#include "attacks.h"
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+
+struct AnalyzeOptions {
+    int threads = 0;
+    int batch = 4096;
+    bool eval = false;
+    int depth = 0;               // 0 = 探索しない
+    int hashMb = 4;
+    const Tablebases* tablebases = nullptr;
+};
+
+// --- 固定長バッファで行を切り出す（行全体は std::string に写す） ---
+class LineReader {
+public:
+    explicit LineReader(FILE* f) : file(f), buf(1 << 20) {}
+    bool next(std::string& line){
+        line.clear();
+        for(;;){
+            if(pos == len){
+                len = std::fread(buf.data(), 1, buf.size(), file);
+                pos = 0;
+                if(len == 0) return !line.empty();
+            }
+            const char* start = buf.data() + pos;
+            const char* nl = (const char*)std::memchr(start, '\n', len - pos);
+            size_t n = nl ? size_t(nl - start) : len - pos;
+            line.append(start, n);
+            pos += n;
+            if(nl){ pos++; return true; }
+        }
+    }
+private:
+    FILE* file;
+    std::vector<char> buf;
+    size_t pos = 0, len = 0;
+};
+
+struct Batch {
+    std::vector<std::string> lines;
+    size_t count = 0;            // lines のうち今回使う行数（文字列の領域は使い回す）
+    std::string out;
+    bool done = false;
+};
+
+static void analyzeLine(std::string& line, const AnalyzeOptions& opt, TranspositionTable* tt, std::string& out){
+    while(!line.empty() && (line.back() == '\r' || line.back() == ' ' || line.back() == '\t')) line.pop_back();
+    Position pos;
+    if(line.size() != 65 || !parseBoard(line, pos)){
+        out += line;
+        out += " error\n";
+        return;
+    }
+    out += line;
+    if(isGameOver(pos)){
+        out += " over\n";
+        return;
+    }
+
+    Position probe = pos;
+    Undo nullUndo;
+    makeNullMove(probe, nullUndo);
+    bool threat = inCheck(probe);
+
+    MoveList list;
+    generateMoves(pos, list);
+    out += inCheck(pos) ? " check=1" : " check=0";
+    out += threat ? " threat=1" : " threat=0";
+    out += " moves=";
+    out += std::to_string(list.size);
+    for(Move m : list){
+        Position child = pos;
+        MoveInfo info;
+        makeMove(child, m, &info);
+        out += ' ';
+        out += moveToString(m);
+        out += ':';
+        out += std::to_string(popcount(info.flips));
+        if(info.captured == KING || info.kingFlipped) out += '!';
+    }
+    if(opt.eval){
+        out += " eval=";
+        out += std::to_string(evaluate(pos));
+    }
+    TbValue tbv;
+    if(opt.tablebases && opt.tablebases->probe(pos, tbv))
+        out += tbv == TB_WIN ? " tb=win" : tbv == TB_LOSS ? " tb=loss" : " tb=draw";
+    if(tt && list.size){
+        GameHistory history;
+        history.reset(pos);
+        SearchLimits limits;
+        limits.maxDepth = opt.depth;
+        limits.timeMs = 0;
+        limits.tablebases = opt.tablebases;
+        tt->newSearch();
+        SearchResult r = searchBestMove(*tt, pos, history, limits);
+        out += " score=" + std::to_string(r.score) + " best=" + moveToString(r.best)
+             + " depth=" + std::to_string(r.depth);
+    }
+    out += '\n';
+}
+
+int main(int argc, char* argv[]){
+    initAttacks();
+    AnalyzeOptions opt;
+    std::string inPath = "-", outPath, tbDir;
+    for(int i=1;i<argc;i++){
+        std::string a = argv[i];
+        if(a == "--out" && i+1 < argc) outPath = argv[++i];
+        else if(a == "--threads" && i+1 < argc) opt.threads = std::atoi(argv[++i]);
+        else if(a == "--batch" && i+1 < argc) opt.batch = std::max(1, std::atoi(argv[++i]));
+        else if(a == "--eval") opt.eval = true;
+        else if(a == "--depth" && i+1 < argc) opt.depth = std::atoi(argv[++i]);
+        else if(a == "--hash" && i+1 < argc) opt.hashMb = std::atoi(argv[++i]);
+        else if(a == "--tb" && i+1 < argc) tbDir = argv[++i];
+        else if(a.size() > 1 && a[0] == '-' && a != "-"){
+            std::cerr << "usage: analyze [file|-] [--out file] [--threads T] [--batch N] [--eval] [--depth D] [--hash MB] [--tb dir]\n";
+            return 1;
+        }
+        else inPath = a;
+    }
+
+    FILE* in = inPath == "-" ? stdin : std::fopen(inPath.c_str(), "rb");
+    if(!in){ std::cerr << "cannot open " << inPath << "\n"; return 1; }
+    FILE* out = outPath.empty() ? stdout : std::fopen(outPath.c_str(), "wb");
+    if(!out){ std::cerr << "cannot write " << outPath << "\n"; return 1; }
+
+    Tablebases tablebases;
+    if(!tbDir.empty()){
+        std::string err;
+        if(tablebases.open(tbDir, &err) == 0){ std::cerr << (err.empty() ? "no tables in " + tbDir : err) << "\n"; return 1; }
+        opt.tablebases = &tablebases;
+    }
+
+    ThreadPool pool(opt.threads);
+    std::vector<std::unique_ptr<TranspositionTable>> tts;
+    if(opt.depth > 0)
+        for(int i=0;i<pool.size();i++) tts.push_back(std::make_unique<TranspositionTable>(opt.hashMb));
+
+    // --- 読み込み → 並列解析 → 順番どおりに書き出し ---
+    // inflight は入力順。先頭が終わるまで後ろの塊の出力は溜めておく
+    const size_t window = size_t(pool.size()) * 2 + 2;
+    std::deque<std::unique_ptr<Batch>> inflight, spare;
+    std::mutex doneMutex;
+    std::condition_variable doneCv;
+    LineReader reader(in);
+    uint64_t lines = 0;
+    bool eof = false, writeError = false;
+    auto start = std::chrono::steady_clock::now();
+
+    auto writeFront = [&]{
+        std::unique_ptr<Batch> b = std::move(inflight.front());
+        inflight.pop_front();
+        {
+            std::unique_lock<std::mutex> lk(doneMutex);
+            doneCv.wait(lk, [&]{ return b->done; });
+        }
+        if(std::fwrite(b->out.data(), 1, b->out.size(), out) != b->out.size()) writeError = true;
+        spare.push_back(std::move(b));
+    };
+
+    while(!eof && !writeError){
+        std::unique_ptr<Batch> b;
+        if(!spare.empty()){ b = std::move(spare.back()); spare.pop_back(); }
+        else b = std::make_unique<Batch>();
+        if(b->lines.size() < size_t(opt.batch)) b->lines.resize(opt.batch);
+        b->count = 0;
+        b->out.clear();
+        b->done = false;
+        while(b->count < size_t(opt.batch) && reader.next(b->lines[b->count])) b->count++;
+        eof = b->count < size_t(opt.batch);
+        if(b->count == 0){ spare.push_back(std::move(b)); break; }
+        lines += b->count;
+
+        Batch* task = b.get();
+        pool.submit([&, task]{
+            int w = ThreadPool::currentWorker();
+            TranspositionTable* tt = tts.empty() ? nullptr : tts[w].get();
+            for(size_t i=0;i<task->count;i++) analyzeLine(task->lines[i], opt, tt, task->out);
+            { std::lock_guard<std::mutex> lk(doneMutex); task->done = true; }
+            doneCv.notify_all();
+        });
+        inflight.push_back(std::move(b));
+        if(inflight.size() >= window) writeFront();
+    }
+    while(!inflight.empty()) writeFront();
+    pool.wait();
+
+    if(in != stdin) std::fclose(in);
+    if(std::fflush(out) != 0) writeError = true;
+    if(out != stdout) std::fclose(out);
+    if(writeError){ std::cerr << "write failed\n"; return 1; }
+
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cerr << lines << " positions on " << pool.size() << " threads in " << std::fixed
+              << std::setprecision(2) << secs << "s (" << (uint64_t)(secs > 0 ? lines / secs : 0)
+              << " positions/s)\n";
+    return 0;
+}
@@ -0,0 +1,162 @@
+#include "assets.h"
+#include <SDL_image.h>
+#include <iostream>
+#include <iomanip>
+
+static const char* SOUND_PATHS[4] = {
+    "./sound/move.mp3", "./sound/capture.mp3", "./sound/gameover.mp3", "./sound/flip.mp3",
+};
+static const char* BGM_PATH = "./sound/bgm.mp3";
+static const char* KIND_NAMES[ASSET_KIND_COUNT] = { "pieces", "scenes", "sounds", "bgm" };
+
+static double msSince(std::chrono::steady_clock::time_point t){
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t).count();
+}
+
+double StartupTimer::mark(const std::string& name){
+    double ms = msSince(start);
+    marks.push_back({ name, ms });
+    return ms;
+}
+
+void StartupTimer::print(std::ostream& os) const {
+    os << "startup (ms since launch / since previous mark):\n";
+    double prev = 0;
+    for(const auto& m : marks){
+        os << "  " << std::left << std::setw(22) << m.first << std::right << std::fixed << std::setprecision(1)
+           << std::setw(8) << m.second << std::setw(9) << m.second - prev << "\n";
+        prev = m.second;
+    }
+}
+
+void destroyGameAssets(GameAssets& assets){
+    destroyPieceAtlas(assets.atlas);
+    destroySceneAssets(assets.scenes);
+    SoundBank& s = assets.sounds;
+    for(Mix_Chunk** c : { &s.move, &s.capture, &s.gameOver, &s.flip }){
+        if(*c) Mix_FreeChunk(*c);
+        *c = nullptr;
+    }
+    if(s.bgm) Mix_FreeMusic(s.bgm);
+    s.bgm = nullptr;
+}
+
+SDL_Surface* loadScaledImage(const std::string& path, int w, int h, std::string& error){
+    SDL_Surface* img = IMG_Load(path.c_str());
+    if(!img){ error = "Failed to load " + path + ": " + IMG_GetError(); return nullptr; }
+    SDL_Surface* out = SDL_CreateRGBSurfaceWithFormat(0, w, h, 32, SDL_PIXELFORMAT_RGBA32);
+    if(out){
+        // 元画像は 2048px と大きいので、転送前にここで縮小しておく
+        SDL_SetSurfaceBlendMode(img, SDL_BLENDMODE_NONE);
+        SDL_BlitScaled(img, nullptr, out, nullptr);
+    } else {
+        error = std::string("Failed to create surface: ") + SDL_GetError();
+    }
+    SDL_FreeSurface(img);
+    return out;
+}
+
+AssetLoader::AssetLoader(SDL_Renderer* ren, GameAssets& assets, StartupTimer& timer)
+    : ren(ren), assets(assets), timer(timer) {}
+
+AssetLoader::~AssetLoader(){ stop(); }
+
+void AssetLoader::submit(AssetKind kind, int index, std::function<void(Decoded&)> work){
+    remaining++;
+    kindRemaining[kind]++;
+    pool->submit([this, kind, index, work]{
+        auto t0 = std::chrono::steady_clock::now();
+        Decoded d;
+        d.kind = kind;
+        d.index = index;
+        work(d);
+        d.ms = msSince(t0);
+        {
+            std::lock_guard<std::mutex> lk(readyMutex);
+            ready.push_back(std::move(d));
+        }
+        if(wakeEvent){
+            SDL_Event ev{};
+            ev.type = wakeEvent;
+            SDL_PushEvent(&ev);
+        }
+    });
+}
+
+void AssetLoader::start(int tile, int sceneW, int sceneH, bool audio, Uint32 wake){
+    wakeEvent = wake;
+    pool.reset(new ThreadPool());
+    createPieceAtlas(ren, tile, assets.atlas);
+
+    // 最初に見える画面から順に積む（ワーカーは他人のキューを前から盗む）
+    for(int i=0;i<SCENE_COUNT;i++)
+        submit(ASSET_SCENE, i, [sceneW, sceneH](Decoded& d){
+            d.surface = loadScaledImage(sceneImagePath(SceneId(d.index)), sceneW, sceneH, d.error);
+        });
+    if(audio){
+        submit(ASSET_BGM, 0, [](Decoded& d){
+            d.music = Mix_LoadMUS_RW(SDL_RWFromFile(BGM_PATH, "rb"), 1);
+            if(!d.music) d.error = std::string("Failed to load BGM: ") + Mix_GetError();
+        });
+        for(int i=0;i<4;i++)
+            submit(ASSET_SOUND, i, [](Decoded& d){
+                d.chunk = Mix_LoadWAV(SOUND_PATHS[d.index]);
+                if(!d.chunk) d.error = std::string("Failed to load sound: ") + Mix_GetError();
+            });
+    }
+    for(int c=0;c<2;c++)
+        for(int t=0;t<6;t++)
+            submit(ASSET_PIECE, c * 6 + t, [tile, c, t](Decoded& d){
+                d.surface = loadScaledImage("./img/" + pieceImageName(c, t), tile, tile, d.error);
+            });
+}
+
+unsigned AssetLoader::pump(){
+    if(remaining == 0) return 0;
+    std::vector<Decoded> batch;
+    {
+        std::lock_guard<std::mutex> lk(readyMutex);
+        batch.swap(ready);
+    }
+    unsigned arrived = 0;
+    for(Decoded& d : batch){
+        if(!d.error.empty()) std::cerr << d.error << "\n";
+        switch(d.kind){
+        case ASSET_PIECE: uploadPieceTile(assets.atlas, d.index / 6, d.index % 6, d.surface); break;
+        case ASSET_SCENE: uploadSceneImage(ren, assets.scenes, SceneId(d.index), d.surface); break;
+        case ASSET_SOUND: {
+            Mix_Chunk** slots[4] = { &assets.sounds.move, &assets.sounds.capture, &assets.sounds.gameOver, &assets.sounds.flip };
+            *slots[d.index] = d.chunk;
+            break;
+        }
+        case ASSET_BGM: assets.sounds.bgm = d.music; break;
+        default: break;
+        }
+        if(d.surface) SDL_FreeSurface(d.surface);
+        arrived |= 1u << d.kind;
+        decodeMs += d.ms;
+        remaining--;
+        if(--kindRemaining[d.kind] == 0) timer.mark(std::string(KIND_NAMES[d.kind]) + " ready");
+    }
+    if(!batch.empty() && remaining == 0){
+        timer.mark("all assets ready");
+        timer.print(std::cout);
+        std::cout << "  decode time " << std::fixed << std::setprecision(1) << decodeMs
+                  << " ms on " << pool->size() << " threads\n";
+        pool.reset();
+    }
+    return arrived;
+}
+
+void AssetLoader::stop(){
+    if(!pool) return;
+    pool->wait();
+    pool.reset();
+    for(Decoded& d : ready){
+        if(d.surface) SDL_FreeSurface(d.surface);
+        if(d.chunk) Mix_FreeChunk(d.chunk);
+        if(d.music) Mix_FreeMusic(d.music);
+    }
+    ready.clear();
+    remaining = 0;
+}
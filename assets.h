@@ -0,0 +1,88 @@
+#pragma once
+#include <SDL.h>
+#include <SDL_mixer.h>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "piece_atlas.h"
+#include "scene.h"
+#include "thread_pool.h"
+
+// --- 起動時間の計測 ---
+struct StartupTimer {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::vector<std::pair<std::string, double>> marks;   // (区間名, 起動からのミリ秒)
+
+    double mark(const std::string& name);                // 戻り値は起動からのミリ秒
+    void print(std::ostream& os) const;
+};
+
+struct SoundBank {
+    Mix_Chunk* move = nullptr;
+    Mix_Chunk* capture = nullptr;
+    Mix_Chunk* gameOver = nullptr;
+    Mix_Chunk* flip = nullptr;
+    Mix_Music* bgm = nullptr;       // ストリーミング再生（全体をデコードしない）
+};
+
+struct GameAssets {
+    PieceAtlas atlas;
+    SceneAssets scenes;
+    SoundBank sounds;
+};
+
+void destroyGameAssets(GameAssets& assets);
+
+// PNG を読み込んで w x h の RGBA32 に縮小する。どのスレッドから呼んでもよい
+SDL_Surface* loadScaledImage(const std::string& path, int w, int h, std::string& error);
+
+// --- 素材の非同期読み込み ---
+// PNG のデコード・縮小と効果音のデコードはスレッドプールで並列に行い、
+// テクスチャへの転送は描画スレッドの pump() で届いた順に行う。
+// BGM は Mix_Music としてワーカーで開くだけで、再生しながら読む。
+enum AssetKind { ASSET_PIECE, ASSET_SCENE, ASSET_SOUND, ASSET_BGM, ASSET_KIND_COUNT };
+
+class AssetLoader {
+public:
+    AssetLoader(SDL_Renderer* ren, GameAssets& assets, StartupTimer& timer);
+    ~AssetLoader();
+    AssetLoader(const AssetLoader&) = delete;
+    AssetLoader& operator=(const AssetLoader&) = delete;
+
+    // デコードを投入する。audio は Mix_OpenAudio が成功したか（効果音の変換先が要る）。
+    // wakeEvent が 0 でなければ、1つデコードが終わるたびにその SDL イベントを積む
+    void start(int tile, int sceneW, int sceneH, bool audio, Uint32 wakeEvent);
+    // 届いた素材を反映する（描画スレッドから呼ぶ）。戻り値は届いた AssetKind のビット集合
+    unsigned pump();
+    bool done() const { return remaining == 0; }
+    // 実行中のデコードを待って、反映していない結果を捨てる
+    void stop();
+
+private:
+    struct Decoded {
+        AssetKind kind;
+        int index = 0;
+        SDL_Surface* surface = nullptr;
+        Mix_Chunk* chunk = nullptr;
+        Mix_Music* music = nullptr;
+        double ms = 0;               // デコードにかかった時間
+        std::string error;
+    };
+    void submit(AssetKind kind, int index, std::function<void(Decoded&)> work);
+
+    SDL_Renderer* ren;
+    GameAssets& assets;
+    StartupTimer& timer;
+    std::unique_ptr<ThreadPool> pool;
+    Uint32 wakeEvent = 0;
+
+    std::mutex readyMutex;
+    std::vector<Decoded> ready;      // ワーカー → 描画スレッド
+
+    int remaining = 0;               // 描画スレッドだけが触る
+    int kindRemaining[ASSET_KIND_COUNT] = {};
+    double decodeMs = 0;
+};
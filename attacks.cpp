@@ -0,0 +1,104 @@
+#include "attacks.h"
+#include <cstddef>
+#include <vector>
+
+SliderEntry ROOK_SLIDERS[64];
+SliderEntry BISHOP_SLIDERS[64];
+
+// 各マスの表を詰めて並べる（ルーク 102400、ビショップ 5248 エントリ）
+static Bitboard rookTable[102400];
+static Bitboard bishopTable[5248];
+
+static const int ROOK_DIRS[4] = { N, W, E, S };
+static const int BISHOP_DIRS[4] = { NW, NE, SW, SE };
+
+static Bitboard slide(int sq, const int dirs[4], Bitboard occ){
+    Bitboard a = 0;
+    for(int i=0;i<4;i++) a |= rayAttacks(sq, dirs[i], occ);
+    return a;
+}
+
+// 盤端のマスは駒がいてもいなくても利きが変わらないので外す
+static Bitboard relevantMask(int sq, const int dirs[4]){
+    Bitboard m = 0;
+    for(int i=0;i<4;i++){
+        Bitboard ray = rayAttacks(sq, dirs[i], 0);
+        for(Bitboard r = ray; r; ){
+            int s = popLsb(r);
+            if(shiftDir(bit(s), dirs[i])) m |= bit(s);
+        }
+    }
+    return m;
+}
+
+#ifndef USE_PEXT
+static uint64_t xorshift64(uint64_t& s){
+    s ^= s >> 12; s ^= s << 25; s ^= s >> 27;
+    return s * 2685821657736338717ULL;
+}
+#endif
+
+static void initSliders(SliderEntry* entries, Bitboard* table, const int dirs[4]){
+    std::vector<Bitboard> occs, refs;
+#ifndef USE_PEXT
+    std::vector<int> epoch(4096, 0);
+    int attempt = 0;
+    uint64_t seed = 0x9E3779B97F4A7C15ULL;
+#endif
+    Bitboard* next = table;
+    for(int sq=0;sq<64;sq++){
+        SliderEntry& e = entries[sq];
+        e.mask = relevantMask(sq, dirs);
+        e.shift = 64 - popcount(e.mask);
+        e.attacks = next;
+        size_t size = size_t(1) << popcount(e.mask);
+        next += size;
+
+        // mask の部分集合をすべて列挙する（Carry-Rippler）
+        occs.clear(); refs.clear();
+        Bitboard b = 0;
+        do {
+            occs.push_back(b);
+            refs.push_back(slide(sq, dirs, b));
+            b = (b - e.mask) & e.mask;
+        } while(b);
+
+#ifdef USE_PEXT
+        e.magic = 0;
+        for(size_t i=0;i<occs.size();i++) table[e.attacks - table + e.index(occs[i])] = refs[i];
+#else
+        // 衝突しない乗数が見つかるまで疎な乱数を試す（シード固定なので毎回同じ結果）
+        Bitboard* out = next - size;
+        for(;;){
+            do e.magic = xorshift64(seed) & xorshift64(seed) & xorshift64(seed);
+            while(popcount((e.mask * e.magic) >> 56) < 6);
+            attempt++;
+            size_t i = 0;
+            for(; i<occs.size(); i++){
+                unsigned idx = e.index(occs[i]);
+                if(epoch[idx] < attempt){ epoch[idx] = attempt; out[idx] = refs[i]; }
+                else if(out[idx] != refs[i]) break;
+            }
+            if(i == occs.size()) break;
+        }
+#endif
+    }
+}
+
+// 静的初期化の順序に頼らないよう、表は main から明示的に作る（2回目以降は何もしない）
+void initAttacks(){
+    static const bool ready = []{
+        initSliders(ROOK_SLIDERS, rookTable, ROOK_DIRS);
+        initSliders(BISHOP_SLIDERS, bishopTable, BISHOP_DIRS);
+        return true;
+    }();
+    (void)ready;
+}
+
+const char* sliderLookupName(){
+#ifdef USE_PEXT
+    return "pext";
+#else
+    return "magic";
+#endif
+}
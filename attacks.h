@@ -0,0 +1,137 @@
+#pragma once
+#include "bitboard.h"
+#if defined(__BMI2__) && !defined(NO_PEXT)
+#include <immintrin.h>
+#define USE_PEXT 1
+#endif
+
+// --- 駒の利きテーブル ---
+// ナイト・キング・ポーンはコンパイル時に作る。
+// 飛び駒はマジックビットボード（BMI2 があれば PEXT）で1回の表引きにする。
+// PEXT が遅い CPU（Zen2 以前）では -DNO_PEXT でマジックに切り替えられる。
+struct LeaperTables {
+    Bitboard knight[64];
+    Bitboard king[64];
+    Bitboard pawn[2][64];     // [Color][sq]: sq にいるポーンが取れるマス
+};
+
+constexpr Bitboard knightSpread(Bitboard b){
+    Bitboard l1 = (b >> 1) & NOT_H, l2 = (b >> 2) & ~(FILE_H | (FILE_H >> 1));
+    Bitboard r1 = (b << 1) & NOT_A, r2 = (b << 2) & ~(FILE_A | (FILE_A << 1));
+    Bitboard h1 = l1 | r1, h2 = l2 | r2;
+    return (h1 << 16) | (h1 >> 16) | (h2 << 8) | (h2 >> 8);
+}
+
+constexpr LeaperTables makeLeaperTables(){
+    LeaperTables t{};
+    for(int sq=0;sq<64;sq++){
+        Bitboard b = bit(sq);
+        t.knight[sq] = knightSpread(b);
+        for(int d=0;d<8;d++) t.king[sq] |= shiftDir(b, d);
+        t.pawn[0][sq] = shiftDir(b, NW) | shiftDir(b, NE);     // 白は上へ
+        t.pawn[1][sq] = shiftDir(b, SW) | shiftDir(b, SE);
+    }
+    return t;
+}
+
+inline constexpr LeaperTables LEAPERS = makeLeaperTables();
+
+struct SliderEntry {
+    Bitboard mask;            // 利きに影響するマス（盤端を除く）
+    Bitboard magic;
+    const Bitboard* attacks;
+    int shift;
+
+    unsigned index(Bitboard occ) const {
+#ifdef USE_PEXT
+        return (unsigned)_pext_u64(occ, mask);
+#else
+        return (unsigned)(((occ & mask) * magic) >> shift);
+#endif
+    }
+};
+
+extern SliderEntry ROOK_SLIDERS[64];
+extern SliderEntry BISHOP_SLIDERS[64];
+
+// 飛び駒の表を作る。手を生成する前（各プログラムの main の最初）に呼ぶこと。
+// 何度呼んでもよく、スレッドから同時に呼んでも1回だけ作る
+void initAttacks();
+
+inline Bitboard knightAttacks(int sq){ return LEAPERS.knight[sq]; }
+inline Bitboard kingAttacks(int sq){ return LEAPERS.king[sq]; }
+inline Bitboard pawnAttacks(int color, int sq){ return LEAPERS.pawn[color][sq]; }
+inline Bitboard rookAttacks(int sq, Bitboard occ){
+    const SliderEntry& e = ROOK_SLIDERS[sq];
+    return e.attacks[e.index(occ)];
+}
+inline Bitboard bishopAttacks(int sq, Bitboard occ){
+    const SliderEntry& e = BISHOP_SLIDERS[sq];
+    return e.attacks[e.index(occ)];
+}
+inline Bitboard queenAttacks(int sq, Bitboard occ){ return rookAttacks(sq, occ) | bishopAttacks(sq, occ); }
+
+const char* sliderLookupName();     // "pext" / "magic"
+
+// --- 任意の大きさの盤の利き（Geometry<R, C>） ---
+// 跳ぶ駒と各方向の盤端までの利きをコンパイル時に表にし、飛び駒は方向ごとに
+// 最初に当たる駒から先の利きを消す（正方向は lsb、負方向は msb で当たる駒を引く）。
+// 8x8 だけは下の特殊化で上の PEXT / マジックの表引きを使う
+template<class G>
+struct Attacks {
+    typedef typename G::Board Board;
+
+    struct Tables {
+        Board knight[G::SQUARES];
+        Board king[G::SQUARES];
+        Board pawn[2][G::SQUARES];
+        Board ray[8][G::SQUARES];     // [Dir][sq]: 盤端までの利き（起点は含まない）
+    };
+
+    static constexpr Board step(int sq, int dr, int dc){
+        int r = G::rowOf(sq) + dr, c = G::colOf(sq) + dc;
+        return r >= 0 && r < G::ROWS && c >= 0 && c < G::COLS ? G::bit(G::sqOf(r, c)) : Board{};
+    }
+
+    static constexpr Tables makeTables(){
+        constexpr int KNIGHT_DR[8] = { -2, -2, -1, -1, 1, 1, 2, 2 };
+        constexpr int KNIGHT_DC[8] = { -1, 1, -2, 2, -2, 2, -1, 1 };
+        Tables t{};
+        for(int sq=0;sq<G::SQUARES;sq++){
+            for(int i=0;i<8;i++) t.knight[sq] |= step(sq, KNIGHT_DR[i], KNIGHT_DC[i]);
+            for(int d=0;d<8;d++){
+                t.king[sq] |= step(sq, DIR_DR[d], DIR_DC[d]);
+                for(int k=1;k<G::ROWS || k<G::COLS;k++) t.ray[d][sq] |= step(sq, k * DIR_DR[d], k * DIR_DC[d]);
+            }
+            t.pawn[0][sq] = step(sq, -1, -1) | step(sq, -1, 1);     // 白は上へ
+            t.pawn[1][sq] = step(sq, 1, -1) | step(sq, 1, 1);
+        }
+        return t;
+    }
+
+    static constexpr Tables T = makeTables();
+
+    // d 方向の利き。G::DELTA[d] > 0（E, SW, S, SE）ならマス番号の小さい側から当たる
+    static Board slide(int sq, int d, Board occ){
+        Board a = T.ray[d][sq], blockers = a & occ;
+        if(blockers) a ^= T.ray[d][G::DELTA[d] > 0 ? lsb(blockers) : msb(blockers)];
+        return a;
+    }
+
+    static Board knight(int sq){ return T.knight[sq]; }
+    static Board king(int sq){ return T.king[sq]; }
+    static Board pawn(int color, int sq){ return T.pawn[color][sq]; }
+    static Board rook(int sq, Board occ){ return slide(sq, N, occ) | slide(sq, W, occ) | slide(sq, E, occ) | slide(sq, S, occ); }
+    static Board bishop(int sq, Board occ){ return slide(sq, NW, occ) | slide(sq, NE, occ) | slide(sq, SW, occ) | slide(sq, SE, occ); }
+    static Board queen(int sq, Board occ){ return rook(sq, occ) | bishop(sq, occ); }
+};
+
+template<>
+struct Attacks<Geometry8> {
+    static Bitboard knight(int sq){ return knightAttacks(sq); }
+    static Bitboard king(int sq){ return kingAttacks(sq); }
+    static Bitboard pawn(int color, int sq){ return pawnAttacks(color, sq); }
+    static Bitboard rook(int sq, Bitboard occ){ return rookAttacks(sq, occ); }
+    static Bitboard bishop(int sq, Bitboard occ){ return bishopAttacks(sq, occ); }
+    static Bitboard queen(int sq, Bitboard occ){ return queenAttacks(sq, occ); }
+};
@@ -0,0 +1,98 @@
+// --- bench: 探索速度とスレッド数ごとのスケーリングを測る（SDL 不要） ---
+// 使い方:
+//   bench [--threads N] [--depth D] [--movetime ms] [--hash MB]
+//   bench --scaling [--threads N] [--depth D]   1,2,4..N スレッドで同じ探索をして比較
+#include "search.h"
+#include "attacks.h"
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <cstdlib>
+#include <thread>
+#include <algorithm>
+
+static const char* BENCH_POSITIONS[] = {
+    nullptr,
+    "rnb0kbnr0q0p00p0ppP000000000ppnpN0000000000000P0P0PPPP0PR0BQKB0R1",
+    "r0b0k0nr00pp0q000p000p0pp0n0P0p00000P000PPb00PP000PN000PR0BQKBNR1",
+    "rnb0k0n00q0000p0ppp0000000000pnrN00p000pb000B0P000PQPP0PR000KB0R1",
+    "r00000000p00kp0000000000pBp0bb0pP0P00nnp0000p000Q0000PP0000KB00R1",
+};
+
+struct BenchTotals {
+    uint64_t nodes = 0;
+    double seconds = 0;
+    std::vector<uint64_t> threadNodes;
+};
+
+static BenchTotals runBench(const SearchLimits& limits, int hashMb, bool verbose){
+    BenchTotals total;
+    total.threadNodes.assign(limits.threads, 0);
+    for(const char* s : BENCH_POSITIONS){
+        Position pos;
+        if(s) parseBoard(s, pos); else setStartPosition(pos);
+        GameHistory history;
+        history.reset(pos);
+        TranspositionTable tt(hashMb);
+        SearchResult r = searchBestMove(tt, pos, history, limits);
+        total.nodes += r.nodes;
+        total.seconds += r.seconds;
+        for(size_t i=0;i<r.threadNodes.size();i++) total.threadNodes[i] += r.threadNodes[i];
+        if(verbose)
+            std::cout << serializeBoard(pos) << "  best " << moveToString(r.best)
+                      << "  depth " << r.depth << "  score " << r.score
+                      << "  nodes " << r.nodes << "  " << std::fixed << std::setprecision(3) << r.seconds << "s\n";
+    }
+    return total;
+}
+
+int main(int argc, char* argv[]){
+    initAttacks();
+    SearchLimits limits;
+    limits.timeMs = 0;
+    limits.maxDepth = 9;
+    limits.threads = 1;
+    int hashMb = 64;
+    bool scaling = false;
+    for(int i=1;i<argc;i++){
+        std::string a = argv[i];
+        if(a == "--threads" && i+1 < argc) limits.threads = std::max(1, std::atoi(argv[++i]));
+        else if(a == "--depth" && i+1 < argc) limits.maxDepth = std::atoi(argv[++i]);
+        else if(a == "--movetime" && i+1 < argc){ limits.timeMs = std::atoi(argv[++i]); limits.maxDepth = 64; }
+        else if(a == "--hash" && i+1 < argc) hashMb = std::atoi(argv[++i]);
+        else if(a == "--scaling") scaling = true;
+        else {
+            std::cerr << "usage: bench [--threads N] [--depth D] [--movetime ms] [--hash MB] [--scaling]\n";
+            return 1;
+        }
+    }
+
+    if(!scaling){
+        BenchTotals t = runBench(limits, hashMb, true);
+        std::cout << "threads " << limits.threads << "  nodes " << t.nodes
+                  << "  time " << std::fixed << std::setprecision(3) << t.seconds << "s"
+                  << "  nps " << (uint64_t)(t.seconds > 0 ? t.nodes / t.seconds : 0) << "\n";
+        for(size_t i=0;i<t.threadNodes.size();i++)
+            std::cout << "  thread " << i << ": " << t.threadNodes[i] << " nodes\n";
+        return 0;
+    }
+
+    // --- スレッド数ごとの比較（固定深さでの所要時間と nps） ---
+    int maxThreads = limits.threads > 1 ? limits.threads : (int)std::thread::hardware_concurrency();
+    if(maxThreads < 1) maxThreads = 1;
+    double baseTime = 0, baseNps = 0;
+    std::cout << "threads      nodes     time(s)        nps  time-speedup  nps-speedup\n";
+    for(int n=1; n<=maxThreads; n = n < maxThreads && n*2 > maxThreads ? maxThreads : n*2){
+        limits.threads = n;
+        BenchTotals t = runBench(limits, hashMb, false);
+        double nps = t.seconds > 0 ? t.nodes / t.seconds : 0;
+        if(n == 1){ baseTime = t.seconds; baseNps = nps; }
+        std::cout << std::setw(7) << n << std::setw(11) << t.nodes
+                  << std::setw(12) << std::fixed << std::setprecision(3) << t.seconds
+                  << std::setw(11) << (uint64_t)nps
+                  << std::setw(14) << std::setprecision(2) << (t.seconds > 0 ? baseTime / t.seconds : 0)
+                  << std::setw(13) << (baseNps > 0 ? nps / baseNps : 0) << "\n";
+        if(n == maxThreads) break;
+    }
+    return 0;
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include "geometry.h"
+
+// --- ビットボード基本定義（通常の 8x8 盤） ---
+// マス番号 sq = row*8 + col（row 0 が画面上端 = 黒の初期段）。
+// 他の大きさの盤は geometry.h の Geometry<R, C> で扱い、ここは 8x8 専用の表
+// （PEXT の飛び駒表・AVX2 の反転・終盤データベース）が使う定義を置く
+typedef Geometry8::Board Bitboard;
+
+const int ROWS = 8;
+const int COLS = 8;
+const int SQUARES = ROWS * COLS;
+
+constexpr int sqOf(int row, int col){ return row * COLS + col; }
+constexpr int rowOf(int sq){ return sq >> 3; }
+constexpr int colOf(int sq){ return sq & 7; }
+constexpr Bitboard bit(int sq){ return 1ULL << sq; }
+
+constexpr Bitboard FILE_A = 0x0101010101010101ULL;   // col 0
+constexpr Bitboard FILE_H = FILE_A << 7;             // col 7
+constexpr Bitboard ROW_0  = 0xFFULL;                 // 黒の初期段
+constexpr Bitboard ROW_7  = ROW_0 << 56;             // 白の初期段
+constexpr Bitboard NOT_A  = ~FILE_A;
+constexpr Bitboard NOT_H  = ~FILE_H;
+
+// --- 8方向（並びは geometry.h の Dir） ---
+constexpr int DIR_DELTA[8] = { -9, -8, -7, -1, 1, 7, 8, 9 };
+// シフト後に端を跨いだビットを落とすマスク
+constexpr Bitboard DIR_MASK[8] = { NOT_H, ~0ULL, NOT_A, NOT_H, NOT_A, NOT_H, ~0ULL, NOT_A };
+
+constexpr Bitboard shiftDir(Bitboard b, int d){
+    int s = DIR_DELTA[d];
+    b = s > 0 ? b << s : b >> -s;
+    return b & DIR_MASK[d];
+}
+
+// 遮られるまで d 方向に伸ばした利き（起点は含まない）
+constexpr Bitboard rayAttacks(int sq, int d, Bitboard occ){
+    Bitboard ray = 0, b = shiftDir(bit(sq), d);
+    while(b){
+        ray |= b;
+        if(b & occ) break;
+        b = shiftDir(b, d);
+    }
+    return ray;
+}
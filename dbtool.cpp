@@ -0,0 +1,167 @@
+// --- dbtool: 対局データベースと定跡の作成・検索（SDL 不要） ---
+// 使い方:
+//   dbtool build out.odb games.bin... [--book-plies N] [--book-min N] [--threads T]
+//   dbtool info db.odb
+//   dbtool query db.odb [e2e4 e7e5 ...]     開始局面から手を進めた局面を引く
+//   dbtool bench db.odb [--queries N]        索引にある局面をランダムに引いて1回あたりの時間を測る
+// games.bin は selfplay --out で書き出した対局記録。
+#include "gamedb.h"
+#include "zobrist.h"
+#include "attacks.h"
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <cstdlib>
+#include <chrono>
+
+static double secondsSince(std::chrono::steady_clock::time_point t){
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - t).count();
+}
+
+static int usage(){
+    std::cerr << "usage: dbtool build out.odb games.bin... [--book-plies N] [--book-min N] [--threads T]\n"
+                 "       dbtool info db.odb\n"
+                 "       dbtool query db.odb [moves...]\n"
+                 "       dbtool bench db.odb [--queries N]\n";
+    return 1;
+}
+
+static int build(int argc, char* argv[]){
+    GameDbBuildOptions opt;
+    std::string out;
+    std::vector<std::string> inputs;
+    for(int i=0;i<argc;i++){
+        std::string a = argv[i];
+        if(a == "--book-plies" && i+1 < argc) opt.bookPlies = std::atoi(argv[++i]);
+        else if(a == "--book-min" && i+1 < argc) opt.bookMinGames = std::atoi(argv[++i]);
+        else if(a == "--threads" && i+1 < argc) opt.threads = std::atoi(argv[++i]);
+        else if(out.empty()) out = a;
+        else inputs.push_back(a);
+    }
+    if(out.empty() || inputs.empty()) return usage();
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<GameRecord> games;
+    GameRecord rec;
+    for(const std::string& path : inputs){
+        FILE* f = std::fopen(path.c_str(), "rb");
+        if(!f){ std::cerr << "cannot open " << path << "\n"; return 1; }
+        while(readGameRecord(f, rec)) games.push_back(rec);
+        std::fclose(f);
+    }
+    double readSecs = secondsSince(start);
+    std::string err;
+    if(!buildGameDb(games, out, opt, &err)){ std::cerr << err << "\n"; return 1; }
+    double total = secondsSince(start);
+    GameDb db;
+    if(!db.open(out, &err)){ std::cerr << err << "\n"; return 1; }
+    std::cout << games.size() << " games, " << db.positionCount() << " positions, "
+              << db.bookCount() << " book moves  (read " << std::fixed << std::setprecision(2)
+              << readSecs << "s, build " << total - readSecs << "s)\n";
+    return 0;
+}
+
+static void printStats(const std::vector<MoveStat>& stats){
+    std::cout << "  move      games   white   black    draw\n";
+    for(const MoveStat& s : stats)
+        std::cout << "  " << std::left << std::setw(8) << moveToString(s.move) << std::right
+                  << std::setw(7) << s.games << std::setw(8) << s.results[RESULT_WHITE_WINS]
+                  << std::setw(8) << s.results[RESULT_BLACK_WINS] << std::setw(8) << s.results[RESULT_DRAW] << "\n";
+}
+
+static int query(const GameDb& db, int argc, char* argv[]){
+    Position pos;
+    setStartPosition(pos);
+    for(int i=0;i<argc;i++){
+        Move m = parseMove(pos, argv[i]);
+        if(!m){ std::cerr << "illegal move " << argv[i] << "\n"; return 1; }
+        makeMove(pos, m);
+    }
+    std::cout << serializeBoard(pos) << "\n";
+
+    auto t0 = std::chrono::steady_clock::now();
+    std::vector<uint32_t> games;
+    size_t total = db.gamesReaching(pos.key, games, 10);
+    double gamesUs = secondsSince(t0) * 1e6;
+    t0 = std::chrono::steady_clock::now();
+    std::vector<MoveStat> stats;
+    db.moveStats(pos.key, stats);
+    double statsUs = secondsSince(t0) * 1e6;
+
+    std::cout << total << " games reach this position (" << std::fixed << std::setprecision(1) << gamesUs << " us)\n";
+    for(uint32_t g : games){
+        const GameDbGame& gm = db.game(g);
+        std::cout << "  game " << gm.recordIndex << "  " << gm.plies << " plies  "
+                  << terminationName(Termination(gm.termination)) << "\n";
+    }
+    std::cout << "moves played (" << statsUs << " us)\n";
+    printStats(stats);
+    auto book = db.bookMoves(pos.key);
+    if(book.first != book.second){
+        std::cout << "book:";
+        for(const BookEntry* e = book.first; e != book.second; e++) std::cout << " " << moveToString(unpackMove(e->move)) << "(" << e->games << ")";
+        std::cout << "  pick " << moveToString(pickBookMove(db, pos)) << "\n";
+    }
+    return 0;
+}
+
+static int bench(const GameDb& db, int argc, char* argv[]){
+    int queries = 100000;
+    for(int i=0;i<argc;i++){
+        std::string a = argv[i];
+        if(a == "--queries" && i+1 < argc) queries = std::atoi(argv[++i]);
+        else return usage();
+    }
+    if(db.positionCount() == 0){ std::cerr << "empty database\n"; return 1; }
+    // 索引に実在する局面を引くため、ランダムな対局をランダムな手数まで進めた局面を使う
+    std::vector<uint64_t> keys;
+    uint64_t rng = 12345;
+    while((int)keys.size() < queries){
+        uint32_t g = uint32_t(splitmix64(rng) % db.gameCount());
+        const GameDbGame& gm = db.game(g);
+        int ply = int(splitmix64(rng) % (gm.plies + 1));
+        Position pos;
+        setStartPosition(pos);
+        for(int i=0;i<ply;i++) makeMove(pos, unpackMove(db.moves(g)[i]));
+        keys.push_back(pos.key);
+    }
+
+    std::vector<uint32_t> games;
+    std::vector<MoveStat> stats;
+    uint64_t found = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    for(uint64_t k : keys) found += db.gamesReaching(k, games, 16);
+    double gamesSecs = secondsSince(t0);
+    t0 = std::chrono::steady_clock::now();
+    for(uint64_t k : keys){ db.moveStats(k, stats); found += stats.size(); }
+    double statsSecs = secondsSince(t0);
+    t0 = std::chrono::steady_clock::now();
+    for(int i=0;i<queries;i++) found += db.find(splitmix64(rng)).second != nullptr;
+    double missSecs = secondsSince(t0);
+
+    std::cout << queries << " queries on " << db.positionCount() << " positions\n" << std::fixed << std::setprecision(2)
+              << "  games reaching  " << gamesSecs / queries * 1e6 << " us/query\n"
+              << "  move stats      " << statsSecs / queries * 1e6 << " us/query\n"
+              << "  random miss     " << missSecs / queries * 1e6 << " us/query\n"
+              << "  (checksum " << found << ")\n";
+    return 0;
+}
+
+int main(int argc, char* argv[]){
+    initAttacks();
+    if(argc < 3) return usage();
+    std::string cmd = argv[1];
+    if(cmd == "build") return build(argc - 2, argv + 2);
+
+    GameDb db;
+    std::string err;
+    if(!db.open(argv[2], &err)){ std::cerr << err << "\n"; return 1; }
+    if(cmd == "info"){
+        std::cout << db.gameCount() << " games, " << db.positionCount() << " positions, "
+                  << db.bookCount() << " book moves (first " << db.bookPlies() << " plies)\n";
+        return 0;
+    }
+    if(cmd == "query") return query(db, argc - 3, argv + 3);
+    if(cmd == "bench") return bench(db, argc - 3, argv + 3);
+    return usage();
+}
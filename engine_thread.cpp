@@ -0,0 +1,97 @@
+#include "engine_thread.h"
+#include "mcts.h"
+
+template<class G>
+BasicAsyncEngine<G>::BasicAsyncEngine(size_t hashMb) : tt(hashMb) {
+    worker = std::thread([this]{ run(); });
+}
+
+template<class G>
+BasicAsyncEngine<G>::~BasicAsyncEngine(){
+    cancel();
+    quit.store(true);
+    { std::lock_guard<std::mutex> lk(wakeMutex); }
+    wake.notify_one();
+    worker.join();
+}
+
+template<class G>
+uint64_t BasicAsyncEngine<G>::search(const Position& pos, const GameHistory& history, const SearchLimits& limits){
+    return submit(pos, history, limits, false);
+}
+
+template<class G>
+uint64_t BasicAsyncEngine<G>::ponder(const Position& pos, const GameHistory& history, const SearchLimits& limits){
+    // MCTS は探索ごとに木を捨てるので先読みしても次の探索に残らない
+    if(limits.engine == ENGINE_MCTS) return 0;
+    SearchLimits l = limits;
+    l.timeMs = 0;
+    l.maxNodes = 0;
+    return submit(pos, history, l, true);
+}
+
+template<class G>
+uint64_t BasicAsyncEngine<G>::submit(const Position& pos, const GameHistory& history, const SearchLimits& limits, bool ponder){
+    EngineRequest<G> req;
+    req.id = nextId;
+    req.pos = pos;
+    req.history = history;
+    req.limits = limits;
+    req.ponder = ponder;
+    req.stop = std::make_shared<std::atomic<bool>>(false);
+    if(!requests.push(req)) return 0;
+    nextId++;
+    pending.push_back({ req.id, req.stop });
+    // push より後にロックを取るので起こし損ねない
+    { std::lock_guard<std::mutex> lk(wakeMutex); }
+    wake.notify_one();
+    return req.id;
+}
+
+template<class G>
+void BasicAsyncEngine<G>::cancel(){
+    for(auto& p : pending) p.second->store(true, std::memory_order_relaxed);
+}
+
+template<class G>
+bool BasicAsyncEngine<G>::poll(EngineReply& out){
+    if(!replies.pop(out)) return false;
+    for(size_t i=0;i<pending.size();i++)
+        if(pending[i].first == out.id){ pending.erase(pending.begin() + i); break; }
+    return true;
+}
+
+template<class G>
+void BasicAsyncEngine<G>::run(){
+    for(;;){
+        EngineRequest<G> req;
+        if(!requests.pop(req)){
+            std::unique_lock<std::mutex> lk(wakeMutex);
+            wake.wait(lk, [this]{ return quit.load() || !requests.empty(); });
+            if(quit.load() && requests.empty()) return;
+            continue;
+        }
+
+        EngineReply rep;
+        rep.id = req.id;
+        rep.key = req.pos.key;
+        rep.ponder = req.ponder;
+        Move bookMove = !req.ponder && book ? pickBookMove(*book, req.pos, req.pos.key ^ req.id) : MOVE_NONE;
+        if(bookMove) rep.result.best = bookMove;
+        else if(!req.stop->load()){
+            SearchLimits l = req.limits;
+            l.stop = req.stop.get();
+            rep.result = l.engine == ENGINE_MCTS ? mctsBestMove(req.pos, req.history, l)
+                                                 : searchBestMove(tt, req.pos, req.history, l);
+        }
+        rep.cancelled = req.stop->load();
+        while(!replies.push(rep)){
+            if(quit.load()) return;
+            std::this_thread::yield();
+        }
+        if(onReply) onReply();
+    }
+}
+
+#define INSTANTIATE_ENGINE(G) template class BasicAsyncEngine<G>;
+FOR_EACH_GEOMETRY(INSTANTIATE_ENGINE)
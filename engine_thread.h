@@ -0,0 +1,80 @@
+#pragma once
+#include "search.h"
+#include "gamedb.h"
+#include "spsc_queue.h"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+#include <vector>
+#include <functional>
+
+// --- バックグラウンド探索 ---
+// 探索は専用のワーカースレッドで行い、結果はロックフリーキューで描画ループに返す。
+// cancel() は中断フラグを立てるだけで待たないので、フレームを止めない。
+// 盤の大きさ G ごとの型（8x8 は AsyncEngine）。
+template<class G>
+struct EngineRequest {
+    uint64_t id = 0;
+    BasicPosition<G> pos;
+    GameHistory history;
+    SearchLimits limits;
+    bool ponder = false;
+    std::shared_ptr<std::atomic<bool>> stop;
+};
+
+struct EngineReply {
+    uint64_t id = 0;
+    uint64_t key = 0;            // 探索した局面（古い結果の取り違え防止）
+    bool ponder = false;
+    bool cancelled = false;
+    SearchResult result;
+};
+
+template<class G>
+class BasicAsyncEngine {
+public:
+    typedef BasicPosition<G> Position;
+    explicit BasicAsyncEngine(size_t hashMb = 64);
+    ~BasicAsyncEngine();
+    BasicAsyncEngine(const BasicAsyncEngine&) = delete;
+    BasicAsyncEngine& operator=(const BasicAsyncEngine&) = delete;
+
+    // 手を決める探索を依頼する（戻り値は要求 ID、キューが満杯なら 0）
+    uint64_t search(const Position& pos, const GameHistory& history, const SearchLimits& limits);
+    // 相手の手番中に先読みして置換表を温める（時間無制限、cancel で止める）。
+    // MCTS では何もせず 0 を返す
+    uint64_t ponder(const Position& pos, const GameHistory& history, const SearchLimits& limits);
+    // 実行中・待機中の要求をすべて中断する（待たない）
+    void cancel();
+    // 届いた結果を1つ取り出す（描画ループから毎フレーム呼ぶ）
+    bool poll(EngineReply& out);
+    bool busy() const { return !pending.empty(); }
+    // 結果をキューに積んだ直後にワーカースレッドから呼ばれる（描画ループを起こす用）。
+    // 最初の search/ponder より前に設定すること
+    void setReplyCallback(std::function<void()> cb){ onReply = std::move(cb); }
+    // 定跡にある局面では探索せずに定跡手を返す（book は engine より長生きさせる。8x8 のみ）。
+    // 最初の search/ponder より前に設定すること
+    void setBook(const GameDb* db){ book = db; }
+
+private:
+    uint64_t submit(const Position& pos, const GameHistory& history, const SearchLimits& limits, bool ponder);
+    void run();
+
+    TranspositionTable tt;
+    SpscQueue<EngineRequest<G>, 16> requests;  // 描画スレッド → ワーカー
+    SpscQueue<EngineReply, 16> replies;        // ワーカー → 描画スレッド
+
+    // 描画スレッドだけが触る: 返事待ちの要求とその中断フラグ
+    std::vector<std::pair<uint64_t, std::shared_ptr<std::atomic<bool>>>> pending;
+    uint64_t nextId = 1;
+    std::function<void()> onReply;
+    const GameDb* book = nullptr;
+
+    std::mutex wakeMutex;                      // ワーカーを眠らせる／起こすためだけに使う
+    std::condition_variable wake;
+    std::atomic<bool> quit{false};
+    std::thread worker;
+};
+
+typedef BasicAsyncEngine<Geometry8> AsyncEngine;
@@ -0,0 +1,234 @@
+#include "eval.h"
+#include "attacks.h"
+#include "flip.h"
+#include <cstring>
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace {
+
+const int PHASE_MAX = 24;
+
+// 中央ほど高い（8x8 で 0..6）
+template<class G>
+int centerBonus(int sq){
+    const int R = G::ROWS, C = G::COLS;
+    int r = G::rowOf(sq), c = G::colOf(sq);
+    int dr = r < R / 2 ? r : R - 1 - r, dc = c < C / 2 ? c : C - 1 - c;
+    return dr + dc;
+}
+
+// --- 重み行 ---
+// rows[c][t][sq] は両色ぶん 16 レーンで、c 側の半分だけに値が入っている
+template<class G>
+struct EvalWeights {
+    alignas(32) int16_t rows[2][6][G::SQUARES][2 * ACC_LANES];
+};
+
+template<class G>
+EvalWeights<G> buildWeights(){
+    const int R = G::ROWS, C = G::COLS, SQ = G::SQUARES;
+    static const int EG_VALUE[6] = { 0, 900, 520, 330, 300, 120 };
+    static const int PHASE[6]    = { 0, 4, 2, 1, 1, 0 };
+    static const int STABLE[6]   = { 12, 20, 12, 8, 8, 2 };   // 挟まれたときの痛さの目安
+    EvalWeights<G> w;
+    std::memset(&w, 0, sizeof w);
+    for(int c=0;c<2;c++)
+        for(int t=0;t<6;t++)
+            for(int sq=0;sq<SQ;sq++){
+                // 自分から見たマス（自陣が最後の段）
+                int rel = c == WHITE ? sq : G::sqOf(R - 1 - G::rowOf(sq), G::colOf(sq));
+                int row = G::rowOf(rel), center = centerBonus<G>(rel);
+                int mg = PIECE_VALUE[t], eg = EG_VALUE[t];
+                switch(t){
+                case KING:   mg += row == R - 1 ? 10 : -4 * (R - 1 - row); eg += 6 * center; break;
+                case PAWN:   mg += 3 * (R - 2 - row); eg += 8 * (R - 2 - row); break;
+                case ROOK:   eg += center; break;
+                default:     mg += 4 * center; eg += 3 * center; break;
+                }
+                bool corner = (sq == 0 || sq == C - 1 || sq == SQ - C || sq == SQ - 1);
+                bool edge = row == 0 || row == R - 1 || G::colOf(sq) == 0 || G::colOf(sq) == C - 1;
+                int16_t* r = &w.rows[c][t][sq][c * ACC_LANES];
+                r[LANE_MG] = int16_t(mg);
+                r[LANE_EG] = int16_t(eg);
+                r[LANE_PHASE] = int16_t(PHASE[t]);
+                r[LANE_STABLE] = int16_t(corner ? 4 * STABLE[t] : edge ? STABLE[t] : 0);
+            }
+    return w;
+}
+
+template<class G>
+const EvalWeights<G> WEIGHTS = buildWeights<G>();
+
+inline void addRow(Accumulator& a, const int16_t* row){
+#if defined(__AVX2__)
+    __m256i* p = reinterpret_cast<__m256i*>(a.v);
+    _mm256_store_si256(p, _mm256_add_epi16(_mm256_load_si256(p), _mm256_load_si256(reinterpret_cast<const __m256i*>(row))));
+#elif defined(__SSE2__)
+    __m128i* p = reinterpret_cast<__m128i*>(a.v);
+    const __m128i* q = reinterpret_cast<const __m128i*>(row);
+    _mm_store_si128(p, _mm_add_epi16(_mm_load_si128(p), _mm_load_si128(q)));
+    _mm_store_si128(p + 1, _mm_add_epi16(_mm_load_si128(p + 1), _mm_load_si128(q + 1)));
+#else
+    int16_t* v = &a.v[0][0];
+    for(int i=0;i<2*ACC_LANES;i++) v[i] += row[i];
+#endif
+}
+
+inline void subRow(Accumulator& a, const int16_t* row){
+#if defined(__AVX2__)
+    __m256i* p = reinterpret_cast<__m256i*>(a.v);
+    _mm256_store_si256(p, _mm256_sub_epi16(_mm256_load_si256(p), _mm256_load_si256(reinterpret_cast<const __m256i*>(row))));
+#elif defined(__SSE2__)
+    __m128i* p = reinterpret_cast<__m128i*>(a.v);
+    const __m128i* q = reinterpret_cast<const __m128i*>(row);
+    _mm_store_si128(p, _mm_sub_epi16(_mm_load_si128(p), _mm_load_si128(q)));
+    _mm_store_si128(p + 1, _mm_sub_epi16(_mm_load_si128(p + 1), _mm_load_si128(q + 1)));
+#else
+    int16_t* v = &a.v[0][0];
+    for(int i=0;i<2*ACC_LANES;i++) v[i] -= row[i];
+#endif
+}
+
+template<class G>
+inline const int16_t* row(int c, int t, int sq){ return WEIGHTS<G>.rows[c][t][sq]; }
+
+// --- 挟まれやすい駒 ---
+// 相手駒 → 自分の駒の連なり → 空きマス と一直線に並んでいれば、相手がその空きマスに
+// 来るだけで連なりごと反転される。8方向を反転カーネルの塗りつぶし（flip.h）で調べる。
+template<class G, int I, class Board = typename G::Board>
+Board exposedDir(Board own, Board opp, Board empty){
+    typedef BoardFill<G> F;
+    constexpr int s = F::SHIFT[I];
+    Board proL = own & F::LMASK[I], proR = own & F::RMASK[I];
+    // 相手駒から正方向に続く自分の駒 と 空きマスから負方向に続く自分の駒
+    Board fromOppL = F::template left<I>(proL & (opp << s), proL);
+    Board fromEmptyR = F::template right<I>(proR & (empty >> s), proR);
+    Board fromOppR = F::template right<I>(proR & (opp >> s), proR);
+    Board fromEmptyL = F::template left<I>(proL & (empty << s), proL);
+    return (fromOppL & fromEmptyR) | (fromOppR & fromEmptyL);
+}
+
+template<class G, class Board = typename G::Board>
+Board exposedPieces(Board own, Board opp, Board empty){
+    return exposedDir<G, 0>(own, opp, empty) | exposedDir<G, 1>(own, opp, empty)
+         | exposedDir<G, 2>(own, opp, empty) | exposedDir<G, 3>(own, opp, empty);
+}
+
+template<class G>
+int materialOf(const BasicPosition<G>& pos, int color, typename G::Board mask){
+    int v = 0;
+    for(int t=QUEEN;t<=PAWN;t++) v += PIECE_VALUE[t] * popcount(pos.pieces[color][t] & mask);
+    return v;
+}
+
+// --- 利きの数（自分の駒がいないマス） ---
+template<class G>
+int mobility(const BasicPosition<G>& pos, int color){
+    typedef Attacks<G> A;
+    typedef typename G::Board Board;
+    Board occ = pos.occupied(), notOwn = ~pos.byColor[color];
+    int m = 0;
+    for(Board b = pos.pieces[color][KNIGHT]; b; ) m += 4 * popcount(A::knight(popLsb(b)) & notOwn);
+    for(Board b = pos.pieces[color][BISHOP]; b; ) m += 4 * popcount(A::bishop(popLsb(b), occ) & notOwn);
+    for(Board b = pos.pieces[color][ROOK]; b; )   m += 2 * popcount(A::rook(popLsb(b), occ) & notOwn);
+    for(Board b = pos.pieces[color][QUEEN]; b; )  m += popcount(A::queen(popLsb(b), occ) & notOwn);
+    return m;
+}
+
+}
+
+template<class G>
+void refreshAccumulator(const BasicPosition<G>& pos, Accumulator& acc){
+    std::memset(&acc, 0, sizeof acc);
+    for(int c=0;c<2;c++)
+        for(int t=0;t<6;t++)
+            for(typename G::Board b = pos.pieces[c][t]; b; ) addRow(acc, row<G>(c, t, popLsb(b)));
+}
+
+template<class G>
+void updateAccumulator(const Accumulator& parent, const BasicPosition<G>& after, const BasicUndo<G>& undo, Accumulator& out){
+    const int C = G::COLS;
+    out = parent;
+    Move m = undo.move;
+    if(m == MOVE_NONE) return;
+    int us = after.sideToMove ^ 1, them = us ^ 1;
+    int from = moveFrom(m), to = moveTo(m), flag = moveFlag(m);
+    int type = after.pieceAt(to);
+    subRow(out, row<G>(us, flag == MF_PROMOTION ? PAWN : type, from));
+    addRow(out, row<G>(us, type, to));
+    if(undo.captured != NO_PIECE){
+        int sq = flag == MF_EN_PASSANT ? to + (us == WHITE ? C : -C) : to;
+        subRow(out, row<G>(them, undo.captured, sq));
+    }
+    if(flag == MF_CASTLE){
+        // ルークは盤端の列からキングの隣へ
+        int rookFrom = G::sqOf(G::rowOf(from), to > from ? C - 1 : 0), rookTo = to > from ? from + 1 : from - 1;
+        subRow(out, row<G>(us, ROOK, rookFrom));
+        addRow(out, row<G>(us, ROOK, rookTo));
+    }
+    for(typename G::Board f = undo.flips; f; ){
+        int sq = popLsb(f);
+        int t = after.pieceAt(sq);
+        subRow(out, row<G>(them, t, sq));
+        addRow(out, row<G>(us, t, sq));
+    }
+}
+
+template<class G>
+int evaluate(const BasicPosition<G>& pos, const Accumulator& acc){
+    typedef typename G::Board Board;
+    int us = pos.sideToMove, them = us ^ 1;
+    const int16_t* a = acc.v[us];
+    const int16_t* b = acc.v[them];
+
+    // 駒割りと位置は中盤・終盤の値をフェーズで混ぜる
+    int phase = a[LANE_PHASE] + b[LANE_PHASE];
+    if(phase > PHASE_MAX) phase = PHASE_MAX;
+    int mg = a[LANE_MG] - b[LANE_MG], eg = a[LANE_EG] - b[LANE_EG];
+    int score = (mg * phase + eg * (PHASE_MAX - phase)) / PHASE_MAX;
+    score += a[LANE_STABLE] - b[LANE_STABLE];
+
+    score += mobility(pos, us) - mobility(pos, them);
+
+    // 挟まれやすい駒: 相手の番なら次の一手で取られうるので重く、自分の番なら軽く見る
+    Board empty = G::ALL & ~pos.occupied();
+    Board ourExposed = exposedPieces<G>(pos.byColor[us], pos.byColor[them], empty);
+    Board theirExposed = exposedPieces<G>(pos.byColor[them], pos.byColor[us], empty);
+    score -= materialOf(pos, us, ourExposed) / 16;
+    score += materialOf(pos, them, theirExposed) / 4;
+
+    // キングが挟まれる形は、反転されたら負けなので別に重く見る
+    if(ourExposed & pos.pieces[us][KING]) score -= 60;
+    if(theirExposed & pos.pieces[them][KING]) score += 150;
+    // キングの隣の相手駒は挟みの端になりうる
+    Board kings = pos.pieces[us][KING], theirKings = pos.pieces[them][KING];
+    if(kings) score -= 8 * popcount(Attacks<G>::king(lsb(kings)) & pos.byColor[them]);
+    if(theirKings) score += 8 * popcount(Attacks<G>::king(lsb(theirKings)) & pos.byColor[us]);
+    return score;
+}
+
+template<class G>
+int evaluate(const BasicPosition<G>& pos){
+    Accumulator acc;
+    refreshAccumulator(pos, acc);
+    return evaluate(pos, acc);
+}
+
+const char* evalSimdName(){
+#if defined(__AVX2__)
+    return "avx2";
+#elif defined(__SSE2__)
+    return "sse2";
+#else
+    return "scalar";
+#endif
+}
+
+#define INSTANTIATE_EVAL(G) \
+    template void refreshAccumulator(const BasicPosition<G>&, Accumulator&); \
+    template void updateAccumulator(const Accumulator&, const BasicPosition<G>&, const BasicUndo<G>&, Accumulator&); \
+    template int evaluate(const BasicPosition<G>&, const Accumulator&); \
+    template int evaluate(const BasicPosition<G>&);
+FOR_EACH_GEOMETRY(INSTANTIATE_EVAL)
@@ -0,0 +1,36 @@
+#pragma once
+#include "position.h"
+#include <cstdint>
+
+// --- 評価関数（手番側から見たセンチポーン） ---
+const int PIECE_VALUE[6] = { 0, 900, 500, 330, 320, 100 };   // KING, QUEEN, ROOK, BISHOP, KNIGHT, PAWN
+
+// --- 特徴量アキュムレータ（NNUE 風） ---
+// 特徴は (色, 駒種, マス) の 12 × マス数 個（8x8 で 768）。各特徴の重みは int16 の行で、色ごとに
+// ACC_LANES レーン（SSE 1本分）を持つ。駒が動く・取られる・反転するたびに
+// その行を足し引きするだけで更新でき、両色ぶん 16 レーンを AVX2 1命令で処理する。
+// 線形に書ける項（駒割り・駒の位置・フェーズ・安定度）をここに入れ、
+// 盤面の形に依存する項（利き・挟まれやすさ・キングの危険）は評価時にビットボードで数える。
+const int ACC_LANES = 8;
+enum AccLane {
+    LANE_MG,          // 駒割り + 位置（中盤）
+    LANE_EG,          // 駒割り + 位置（終盤）
+    LANE_PHASE,       // ナイト・ビショップ 1、ルーク 2、クイーン 4
+    LANE_STABLE,      // 隅・端の駒（挟まれにくい）
+};
+
+struct alignas(32) Accumulator {
+    int16_t v[2][ACC_LANES];     // [Color][AccLane]
+};
+
+// 局面から作り直す
+template<class G> void refreshAccumulator(const BasicPosition<G>& pos, Accumulator& acc);
+// makeMove の直後に呼ぶ。parent は指す前の局面のアキュムレータ、after は指した後の局面
+template<class G> void updateAccumulator(const Accumulator& parent, const BasicPosition<G>& after, const BasicUndo<G>& undo, Accumulator& out);
+
+template<class G> int evaluate(const BasicPosition<G>& pos, const Accumulator& acc);
+// アキュムレータを作り直して評価する（探索以外の単発の呼び出し用）
+template<class G> int evaluate(const BasicPosition<G>& pos);
+
+// 使っているベクトル命令（"avx2" / "sse2" / "scalar"）
+const char* evalSimdName();
@@ -0,0 +1,59 @@
+#include "flip.h"
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+// --- スカラー版（相手駒の連なりを flip.h の塗りつぶしで伸ばす） ---
+Bitboard othelloFlipsScalar(int sq, Bitboard own, Bitboard opp){
+    return fillFlips<Geometry8>(sq, own, opp);
+}
+
+#if defined(__AVX2__)
+// --- AVX2 版: 4方向を1本の __m256i で同時に伸ばす ---
+Bitboard othelloFlipsAvx2(int sq, Bitboard own, Bitboard opp){
+    const __m256i s1 = _mm256_set_epi64x(9, 8, 7, 1);
+    const __m256i s2 = _mm256_add_epi64(s1, s1);
+    const __m256i s4 = _mm256_add_epi64(s2, s2);
+    const __m256i lmask = _mm256_set_epi64x((long long)NOT_A, -1LL, (long long)NOT_H, (long long)NOT_A);
+    const __m256i rmask = _mm256_set_epi64x((long long)NOT_H, -1LL, (long long)NOT_A, (long long)NOT_H);
+    const __m256i seed = _mm256_set1_epi64x((long long)bit(sq));
+    const __m256i vopp = _mm256_set1_epi64x((long long)opp);
+    const __m256i vown = _mm256_set1_epi64x((long long)own);
+    const __m256i zero = _mm256_setzero_si256();
+
+    // 正方向
+    __m256i pro = _mm256_and_si256(vopp, lmask);
+    __m256i gen = seed;
+    gen = _mm256_or_si256(gen, _mm256_and_si256(pro, _mm256_sllv_epi64(gen, s1)));
+    pro = _mm256_and_si256(pro, _mm256_sllv_epi64(pro, s1));
+    gen = _mm256_or_si256(gen, _mm256_and_si256(pro, _mm256_sllv_epi64(gen, s2)));
+    pro = _mm256_and_si256(pro, _mm256_sllv_epi64(pro, s2));
+    gen = _mm256_or_si256(gen, _mm256_and_si256(pro, _mm256_sllv_epi64(gen, s4)));
+    __m256i end = _mm256_and_si256(_mm256_and_si256(_mm256_sllv_epi64(gen, s1), lmask), vown);
+    __m256i flips = _mm256_andnot_si256(_mm256_cmpeq_epi64(end, zero), _mm256_xor_si256(gen, seed));
+
+    // 負方向
+    pro = _mm256_and_si256(vopp, rmask);
+    gen = seed;
+    gen = _mm256_or_si256(gen, _mm256_and_si256(pro, _mm256_srlv_epi64(gen, s1)));
+    pro = _mm256_and_si256(pro, _mm256_srlv_epi64(pro, s1));
+    gen = _mm256_or_si256(gen, _mm256_and_si256(pro, _mm256_srlv_epi64(gen, s2)));
+    pro = _mm256_and_si256(pro, _mm256_srlv_epi64(pro, s2));
+    gen = _mm256_or_si256(gen, _mm256_and_si256(pro, _mm256_srlv_epi64(gen, s4)));
+    end = _mm256_and_si256(_mm256_and_si256(_mm256_srlv_epi64(gen, s1), rmask), vown);
+    flips = _mm256_or_si256(flips,
+        _mm256_andnot_si256(_mm256_cmpeq_epi64(end, zero), _mm256_xor_si256(gen, seed)));
+
+    // 4レーンを OR で畳む
+    __m128i x = _mm_or_si128(_mm256_castsi256_si128(flips), _mm256_extracti128_si256(flips, 1));
+    return (Bitboard)_mm_cvtsi128_si64(x) | (Bitboard)_mm_extract_epi64(x, 1);
+}
+#endif
+
+const char* flipKernelName(){
+#if defined(__AVX2__)
+    return "avx2";
+#else
+    return "scalar";
+#endif
+}
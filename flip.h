@@ -0,0 +1,131 @@
+#pragma once
+#include "bitboard.h"
+
+// --- オセロ反転カーネル ---
+// sq に置いた own 側の駒と、8方向の先にある own 側の駒で挟まれた opp 側の駒を
+// Kogge-Stone の並列プレフィックスシフトで一度に求める。
+// AVX2 が使えるときは4方向ずつベクトル化し、それ以外はスカラー版を使う。
+
+// --- Kogge-Stone の塗りつぶし（評価関数の挟まれやすい駒の判定でも使う） ---
+// 4方向のシフト量と、シフト後に端を跨いだビットを落とすマスク。
+// 正方向（<<）: E(+1) SW(+C-1) S(+C) SE(+C+1)、負方向（>>）: W NE N NW。
+// 倍々のシフトを STEPS 回で 2^STEPS - 1 マス先まで伸ばすので、盤の一辺が 8 なら 3 回
+template<class G>
+struct BoardFill {
+    typedef typename G::Board Board;
+    static constexpr int STEPS = G::ROWS <= 8 && G::COLS <= 8 ? 3 : 4;
+    static_assert(G::ROWS <= 16 && G::COLS <= 16, "fills reach at most 15 squares");
+    static constexpr int SHIFT[4] = { 1, G::COLS - 1, G::COLS, G::COLS + 1 };
+    static constexpr Board LMASK[4] = { G::NOT_FIRST_FILE, G::NOT_LAST_FILE, G::ALL, G::NOT_FIRST_FILE };
+    static constexpr Board RMASK[4] = { G::NOT_LAST_FILE, G::NOT_FIRST_FILE, G::ALL, G::NOT_LAST_FILE };
+
+    // gen: 起点から pro（伝播できるマス）の連なりを伸ばした集合。I は SHIFT の添字で、
+    // シフト量を定数にしておくと多語のビットボードでも語をまたぐ分岐が消える
+    template<int I>
+    static Board left(Board gen, Board pro){
+        constexpr int s = SHIFT[I];
+        gen |= pro & (gen << s);
+        pro &= pro << s;
+        gen |= pro & (gen << 2 * s);
+        pro &= pro << 2 * s;
+        gen |= pro & (gen << 4 * s);
+        if constexpr(STEPS > 3){
+            pro &= pro << 4 * s;
+            gen |= pro & (gen << 8 * s);
+        }
+        return gen;
+    }
+    template<int I>
+    static Board right(Board gen, Board pro){
+        constexpr int s = SHIFT[I];
+        gen |= pro & (gen >> s);
+        pro &= pro >> s;
+        gen |= pro & (gen >> 2 * s);
+        pro &= pro >> 2 * s;
+        gen |= pro & (gen >> 4 * s);
+        if constexpr(STEPS > 3){
+            pro &= pro >> 4 * s;
+            gen |= pro & (gen >> 8 * s);
+        }
+        return gen;
+    }
+};
+
+// スカラー版の本体（相手駒の連なりを4方向の塗りつぶしで伸ばす）
+template<class G, int I>
+inline typename G::Board fillFlipsDir(typename G::Board seed, typename G::Board own, typename G::Board opp){
+    typedef BoardFill<G> F;
+    constexpr int s = F::SHIFT[I];
+    typename G::Board flips{};
+    typename G::Board gen = F::template left<I>(seed, opp & F::LMASK[I]);
+    if((gen << s) & F::LMASK[I] & own) flips |= gen ^ seed;
+    gen = F::template right<I>(seed, opp & F::RMASK[I]);
+    if((gen >> s) & F::RMASK[I] & own) flips |= gen ^ seed;
+    return flips;
+}
+
+template<class G>
+inline typename G::Board fillFlips(int sq, typename G::Board own, typename G::Board opp){
+    typename G::Board seed = G::bit(sq);
+    return fillFlipsDir<G, 0>(seed, own, opp) | fillFlipsDir<G, 1>(seed, own, opp)
+         | fillFlipsDir<G, 2>(seed, own, opp) | fillFlipsDir<G, 3>(seed, own, opp);
+}
+
+Bitboard othelloFlipsScalar(int sq, Bitboard own, Bitboard opp);
+#if defined(__AVX2__)
+Bitboard othelloFlipsAvx2(int sq, Bitboard own, Bitboard opp);
+#endif
+
+inline Bitboard othelloFlips(int sq, Bitboard own, Bitboard opp){
+#if defined(__AVX2__)
+    return othelloFlipsAvx2(sq, own, opp);
+#else
+    return othelloFlipsScalar(sq, own, opp);
+#endif
+}
+
+// 多語のビットボード版。語をまたぐシフトは重いので、倍々の塗りつぶしではなく 8 方向に
+// 1マスずつ辿る（隣が相手の駒でない方向はすぐ打ち切るので、ほとんどの手は 8 回の判定で済む）
+template<class G>
+inline typename G::Board walkFlips(int sq, typename G::Board own, typename G::Board opp){
+    typename G::Board flips{};
+    int row = G::rowOf(sq), col = G::colOf(sq);
+    for(int d=0;d<8;d++){
+        typename G::Board run{};
+        int r = row + DIR_DR[d], c = col + DIR_DC[d];
+        for(; r >= 0 && r < G::ROWS && c >= 0 && c < G::COLS; r += DIR_DR[d], c += DIR_DC[d]){
+            typename G::Board b = G::bit(G::sqOf(r, c));
+            if(opp & b){ run |= b; continue; }
+            if(own & b) flips |= run;
+            break;
+        }
+    }
+    return flips;
+}
+
+// 盤ごとの反転。8x8 だけ AVX2 / スカラーの専用版、他の盤は walkFlips
+template<class G>
+struct FlipKernel {
+    static typename G::Board flips(int sq, typename G::Board own, typename G::Board opp){ return walkFlips<G>(sq, own, opp); }
+};
+
+template<>
+struct FlipKernel<Geometry8> {
+    static Bitboard flips(int sq, Bitboard own, Bitboard opp){ return othelloFlips(sq, own, opp); }
+};
+
+template<class G>
+struct BasicFlipResult {
+    typename G::Board flips;
+    bool kingSandwiched;     // 反転対象に相手キングが含まれる
+};
+
+template<class G>
+inline BasicFlipResult<G> computeFlips(int sq, typename G::Board own, typename G::Board opp, typename G::Board oppKings){
+    typename G::Board f = FlipKernel<G>::flips(sq, own, opp);
+    return { f, bool(f & oppKings) };
+}
+
+typedef BasicFlipResult<Geometry8> FlipResult;
+
+const char* flipKernelName();
@@ -0,0 +1,288 @@
+#include "gamedb.h"
+#include "thread_pool.h"
+#include "zobrist.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+// --- 書き出し ---
+
+static bool indexLess(const GameDbIndexEntry& a, const GameDbIndexEntry& b){
+    if(a.key != b.key) return a.key < b.key;
+    if(a.game != b.game) return a.game < b.game;
+    return a.ply < b.ply;
+}
+
+// 1つの局面の索引エントリ [first, last) から定跡エントリを作って out に足す。
+// エントリは対局順に並んでいるので、同じ対局で繰り返し現れた局面から同じ手を指しても1局と数える
+static void appendBook(const GameDbIndexEntry* first, const GameDbIndexEntry* last,
+                       const std::vector<GameRecord>& games, const GameDbBuildOptions& opt,
+                       std::vector<BookEntry>& out){
+    std::vector<BookEntry> moves;
+    std::vector<uint32_t> lastGame;       // moves と同じ並びで、最後に数えた対局
+    for(const GameDbIndexEntry* e = first; e != last; e++){
+        if(e->ply >= opt.bookPlies || e->next == MOVE_NONE) continue;
+        size_t i = 0;
+        while(i < moves.size() && moves[i].move != e->next) i++;
+        if(i == moves.size()){
+            moves.push_back(BookEntry());
+            std::memset(&moves[i], 0, sizeof moves[i]);
+            moves[i].key = e->key;
+            moves[i].move = e->next;
+            lastGame.push_back(UINT32_MAX);
+        }
+        if(lastGame[i] == e->game) continue;
+        lastGame[i] = e->game;
+        BookEntry* b = &moves[i];
+        b->games++;
+        int r = games[e->game].result;
+        if(r <= RESULT_DRAW) b->results[r]++;
+    }
+    std::sort(moves.begin(), moves.end(), [](const BookEntry& a, const BookEntry& b){
+        return a.games != b.games ? a.games > b.games : a.move < b.move;
+    });
+    for(const BookEntry& b : moves)
+        if(int(b.games) >= opt.bookMinGames) out.push_back(b);
+}
+
+template <class T>
+static bool writeArray(FILE* f, const T* data, size_t count){
+    return count == 0 || std::fwrite(data, sizeof(T), count, f) == count;
+}
+
+bool buildGameDb(const std::vector<GameRecord>& records, const std::string& path,
+                 const GameDbBuildOptions& opt, std::string* error){
+    GameDbHeader h;
+    std::memset(&h, 0, sizeof h);
+    std::memcpy(h.magic, "OCDB", 4);
+    h.version = GAME_DB_VERSION;
+    h.gameCount = uint32_t(records.size());
+    h.bookPlies = uint32_t(opt.bookPlies);
+    h.radixBits = uint32_t(opt.radixBits);
+
+    // --- 対局表と手 ---
+    std::vector<GameDbGame> games(records.size());
+    std::vector<uint64_t> firstEntry(records.size() + 1, 0);
+    uint64_t moveCount = 0;
+    for(size_t g=0;g<records.size();g++){
+        const GameRecord& r = records[g];
+        if(r.moves.size() > 0xFFFF){ if(error) *error = "game too long"; return false; }
+        if(r.boardSize != 8){ if(error) *error = "only 8x8 games can be indexed"; return false; }
+        games[g].firstMove = moveCount;
+        games[g].plies = uint16_t(r.moves.size());
+        games[g].result = r.result;
+        games[g].termination = r.termination;
+        games[g].recordIndex = r.index;
+        moveCount += r.moves.size();
+        firstEntry[g + 1] = firstEntry[g] + r.moves.size() + 1;
+    }
+    h.moveCount = moveCount;
+    h.indexCount = firstEntry.back();
+
+    // --- 索引: 対局ごとに並列で再生してエントリを作る ---
+    ThreadPool pool(opt.threads);
+    std::vector<GameDbIndexEntry> entries(h.indexCount);
+    for(size_t g=0;g<records.size();g++)
+        pool.submit([&, g]{
+            const GameRecord& r = records[g];
+            Position pos;
+            setStartPosition(pos);
+            GameDbIndexEntry* out = &entries[firstEntry[g]];
+            for(size_t ply=0; ply<=r.moves.size(); ply++){
+                out[ply].key = pos.key;
+                out[ply].game = uint32_t(g);
+                out[ply].ply = uint16_t(ply);
+                out[ply].next = ply < r.moves.size() ? packMove(r.moves[ply]) : PackedMove(MOVE_NONE);
+                if(ply < r.moves.size()) makeMove(pos, r.moves[ply]);
+            }
+        });
+    pool.wait();
+
+    // --- 上位ビットで振り分け（これがそのまま基数表になる）、バケットごとに並列で整列 ---
+    const int shift = 64 - opt.radixBits;
+    const size_t buckets = size_t(1) << opt.radixBits;
+    std::vector<uint64_t> radix(buckets + 1, 0);
+    for(const GameDbIndexEntry& e : entries) radix[(e.key >> shift) + 1]++;
+    for(size_t b=0;b<buckets;b++) radix[b + 1] += radix[b];
+    std::vector<GameDbIndexEntry> sorted(entries.size());
+    {
+        std::vector<uint64_t> fill(radix.begin(), radix.end() - 1);
+        for(const GameDbIndexEntry& e : entries) sorted[fill[e.key >> shift]++] = e;
+    }
+    std::vector<GameDbIndexEntry>().swap(entries);
+    const size_t chunk = std::max<size_t>(1, buckets / 256);
+    for(size_t b0=0;b0<buckets;b0+=chunk)
+        pool.submit([&, b0]{
+            for(size_t b=b0; b<std::min(buckets, b0 + chunk); b++)
+                std::sort(sorted.begin() + radix[b], sorted.begin() + radix[b + 1], indexLess);
+        });
+    pool.wait();
+
+    // --- 定跡: 局面ごとに手を集計 ---
+    std::vector<BookEntry> book;
+    for(size_t i=0;i<sorted.size();){
+        size_t j = i;
+        while(j < sorted.size() && sorted[j].key == sorted[i].key) j++;
+        appendBook(&sorted[i], &sorted[0] + j, records, opt, book);
+        i = j;
+    }
+    h.bookCount = book.size();
+
+    // --- 配置を決めて書き出す ---
+    auto align8 = [](uint64_t x){ return (x + 7) & ~uint64_t(7); };
+    h.gamesOffset = sizeof(GameDbHeader);
+    h.movesOffset = h.gamesOffset + games.size() * sizeof(GameDbGame);
+    h.indexOffset = align8(h.movesOffset + moveCount * sizeof(PackedMove));
+    h.bookOffset = h.indexOffset + h.indexCount * sizeof(GameDbIndexEntry);
+    h.radixOffset = h.bookOffset + h.bookCount * sizeof(BookEntry);
+
+    FILE* f = std::fopen(path.c_str(), "wb");
+    if(!f){ if(error) *error = "cannot write " + path; return false; }
+    bool ok = writeArray(f, &h, 1) && writeArray(f, games.data(), games.size());
+    std::vector<PackedMove> packed;
+    for(const GameRecord& r : records){
+        packed.resize(r.moves.size());
+        for(size_t i=0;i<r.moves.size();i++) packed[i] = packMove(r.moves[i]);
+        ok = ok && writeArray(f, packed.data(), packed.size());
+    }
+    static const uint8_t zeros[8] = {};
+    ok = ok && writeArray(f, zeros, size_t(h.indexOffset - (h.movesOffset + moveCount * sizeof(PackedMove))));
+    ok = ok && writeArray(f, sorted.data(), sorted.size())
+            && writeArray(f, book.data(), book.size())
+            && writeArray(f, radix.data(), radix.size());
+    ok = std::fclose(f) == 0 && ok;
+    if(!ok && error) *error = "write failed: " + path;
+    return ok;
+}
+
+// --- 読み込み ---
+
+bool GameDb::open(const std::string& path, std::string* error){
+    close();
+    if(!file.open(path, error)) return false;
+    const uint8_t* p = file.data();
+    size_t n = file.size();
+    auto fail = [&](const char* why){
+        if(error) *error = path + ": " + why;
+        close();
+        return false;
+    };
+    if(n < sizeof(GameDbHeader)) return fail("too small");
+    const GameDbHeader* h = reinterpret_cast<const GameDbHeader*>(p);
+    if(std::memcmp(h->magic, "OCDB", 4) != 0) return fail("not a game database");
+    if(h->version != GAME_DB_VERSION) return fail("unsupported version");
+    if(h->radixBits < 1 || h->radixBits > 24) return fail("bad radix table");
+    uint64_t radixCount = (uint64_t(1) << h->radixBits) + 1;
+    // 各セクションがファイル内に収まり、8バイト境界に揃っているか
+    auto inside = [&](uint64_t off, uint64_t count, uint64_t size){
+        return off % 8 == 0 && off <= n && count <= (n - off) / size;
+    };
+    if(!inside(h->gamesOffset, h->gameCount, sizeof(GameDbGame))
+       || !inside(h->movesOffset, h->moveCount, sizeof(PackedMove))
+       || !inside(h->indexOffset, h->indexCount, sizeof(GameDbIndexEntry))
+       || !inside(h->bookOffset, h->bookCount, sizeof(BookEntry))
+       || !inside(h->radixOffset, radixCount, sizeof(uint64_t)))
+        return fail("truncated or corrupt");
+    header = h;
+    games = reinterpret_cast<const GameDbGame*>(p + h->gamesOffset);
+    moveData = reinterpret_cast<const PackedMove*>(p + h->movesOffset);
+    index = reinterpret_cast<const GameDbIndexEntry*>(p + h->indexOffset);
+    book = reinterpret_cast<const BookEntry*>(p + h->bookOffset);
+    radix = reinterpret_cast<const uint64_t*>(p + h->radixOffset);
+    if(radix[radixCount - 1] != h->indexCount) return fail("bad radix table");
+    file.adviseRandom();
+    return true;
+}
+
+void GameDb::close(){
+    file.close();
+    header = nullptr;
+    games = nullptr;
+    moveData = nullptr;
+    index = nullptr;
+    book = nullptr;
+    radix = nullptr;
+}
+
+std::pair<const GameDbIndexEntry*, const GameDbIndexEntry*> GameDb::find(uint64_t key) const {
+    if(!header) return { nullptr, nullptr };
+    uint64_t b = key >> (64 - header->radixBits);
+    const GameDbIndexEntry* lo = index + radix[b];
+    const GameDbIndexEntry* hi = index + radix[b + 1];
+    lo = std::lower_bound(lo, hi, key, [](const GameDbIndexEntry& e, uint64_t k){ return e.key < k; });
+    const GameDbIndexEntry* end = lo;
+    while(end != hi && end->key == key) end++;
+    return { lo, end };
+}
+
+size_t GameDb::gamesReaching(uint64_t key, std::vector<uint32_t>& out, size_t limit) const {
+    out.clear();
+    auto range = find(key);
+    size_t total = 0;
+    uint32_t last = UINT32_MAX;
+    for(const GameDbIndexEntry* e = range.first; e != range.second; e++){
+        if(e->game == last) continue;     // 同じ対局で繰り返し現れた局面
+        last = e->game;
+        if(total++ < limit) out.push_back(e->game);
+    }
+    return total;
+}
+
+void GameDb::moveStats(uint64_t key, std::vector<MoveStat>& out) const {
+    out.clear();
+    auto range = find(key);
+    std::vector<uint32_t> lastGame;       // out と同じ並びで、最後に数えた対局（gamesReaching と同じ数え方）
+    for(const GameDbIndexEntry* e = range.first; e != range.second; e++){
+        if(e->next == MOVE_NONE) continue;
+        size_t i = 0;
+        Move next = unpackMove(e->next);
+        while(i < out.size() && out[i].move != next) i++;
+        if(i == out.size()){
+            out.push_back(MoveStat());
+            out[i].move = next;
+            lastGame.push_back(UINT32_MAX);
+        }
+        if(lastGame[i] == e->game) continue;
+        lastGame[i] = e->game;
+        MoveStat* s = &out[i];
+        s->games++;
+        int r = games[e->game].result;
+        if(r <= RESULT_DRAW) s->results[r]++;
+    }
+    std::sort(out.begin(), out.end(), [](const MoveStat& a, const MoveStat& b){
+        return a.games != b.games ? a.games > b.games : a.move < b.move;
+    });
+}
+
+std::pair<const BookEntry*, const BookEntry*> GameDb::bookMoves(uint64_t key) const {
+    if(!header) return { nullptr, nullptr };
+    const BookEntry* end = book + header->bookCount;
+    const BookEntry* lo = std::lower_bound(book, end, key, [](const BookEntry& e, uint64_t k){ return e.key < k; });
+    const BookEntry* hi = lo;
+    while(hi != end && hi->key == key) hi++;
+    return { lo, hi };
+}
+
+Move pickBookMove(const GameDb& db, const Position& pos, uint64_t seed){
+    auto range = db.bookMoves(pos.key);
+    if(range.first == range.second) return MOVE_NONE;
+    MoveList legal;
+    generateMoves(pos, legal);
+    // キーの衝突に備えて合法手と突き合わせる
+    const BookEntry* candidates[MAX_MOVES];
+    int n = 0;
+    uint64_t total = 0;
+    for(const BookEntry* e = range.first; e != range.second; e++)
+        if(std::find(legal.begin(), legal.end(), unpackMove(e->move)) != legal.end()){
+            candidates[n++] = e;
+            total += e->games;
+        }
+    if(n == 0) return MOVE_NONE;
+    if(seed == 0) return unpackMove(candidates[0]->move);
+    uint64_t r = splitmix64(seed) % total;
+    for(int i=0;i<n;i++){
+        if(r < candidates[i]->games) return unpackMove(candidates[i]->move);
+        r -= candidates[i]->games;
+    }
+    return unpackMove(candidates[0]->move);
+}
@@ -0,0 +1,117 @@
+#pragma once
+#include "position.h"
+#include "gamerecord.h"
+#include "mapped_file.h"
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <utility>
+
+// --- 対局データベース（メモリマップでそのまま読むバイナリ） ---
+//   ヘッダ | 対局表 GameDbGame[gameCount] | 手 PackedMove[moveCount]（8バイト境界まで詰める）
+//   | 索引 GameDbIndexEntry[indexCount]（key, game, ply の順に整列）
+//   | 定跡 BookEntry[bookCount]（key 順、同じ key の中は対局数の多い順）
+//   | 基数表 u64[2^radixBits + 1]（key の上位ビットごとの索引の開始位置）
+// 全フィールドはリトルエンディアンで、読み込み時に解析はしない。
+// 局面は Zobrist キーで引く。キーは一様に散らばるので、上位ビットの基数表で
+// 範囲を数十件まで絞ってから二分探索する。
+// 8x8 の対局専用で、手は 16 ビットの PackedMove（position.h）で持つ。
+const uint32_t GAME_DB_VERSION = 1;
+
+struct GameDbHeader {
+    char magic[4];               // "OCDB"
+    uint32_t version;
+    uint32_t gameCount;
+    uint32_t bookPlies;          // 定跡に入れた手数（この手数未満の局面）
+    uint32_t radixBits;
+    uint32_t reserved;
+    uint64_t moveCount;
+    uint64_t indexCount;
+    uint64_t bookCount;
+    uint64_t gamesOffset, movesOffset, indexOffset, bookOffset, radixOffset;
+};
+
+struct GameDbGame {
+    uint64_t firstMove;          // 手の配列での位置
+    uint16_t plies;
+    uint8_t result;              // GameResult
+    uint8_t termination;         // Termination
+    uint32_t recordIndex;        // 元の対局記録の番号
+};
+
+struct GameDbIndexEntry {
+    uint64_t key;
+    uint32_t game;
+    uint16_t ply;                // この局面までに指した手数
+    PackedMove next;             // この局面で指した手（終局なら MOVE_NONE）
+};
+
+struct BookEntry {
+    uint64_t key;
+    PackedMove move;
+    uint16_t reserved;
+    uint32_t games;
+    uint32_t results[3];         // [GameResult]（白勝ち・黒勝ち・引き分け）
+    uint32_t reserved2;
+};
+
+static_assert(sizeof(GameDbHeader) == 88, "GameDbHeader layout");
+static_assert(sizeof(GameDbGame) == 16, "GameDbGame layout");
+static_assert(sizeof(GameDbIndexEntry) == 16, "GameDbIndexEntry layout");
+static_assert(sizeof(BookEntry) == 32, "BookEntry layout");
+
+struct MoveStat {
+    Move move = MOVE_NONE;
+    uint32_t games = 0;
+    uint32_t results[3] = {0, 0, 0};
+};
+
+struct GameDbBuildOptions {
+    int bookPlies = 16;
+    int bookMinGames = 2;        // これより少ない手は定跡に入れない
+    int radixBits = 16;
+    int threads = 0;             // 索引の整列に使うスレッド数（0 = 全コア）
+};
+
+// 対局記録からデータベースファイルを作る（8x8 の記録だけ）
+bool buildGameDb(const std::vector<GameRecord>& games, const std::string& path,
+                 const GameDbBuildOptions& opt, std::string* error = nullptr);
+
+class GameDb {
+public:
+    bool open(const std::string& path, std::string* error = nullptr);
+    void close();
+    bool isOpen() const { return file.isOpen(); }
+
+    uint32_t gameCount() const { return header ? header->gameCount : 0; }
+    uint64_t positionCount() const { return header ? header->indexCount : 0; }
+    uint64_t bookCount() const { return header ? header->bookCount : 0; }
+    int bookPlies() const { return header ? int(header->bookPlies) : 0; }
+    const GameDbGame& game(uint32_t i) const { return games[i]; }
+    const PackedMove* moves(uint32_t i) const { return moveData + games[i].firstMove; }
+
+    // key の局面の索引エントリ [first, last)
+    std::pair<const GameDbIndexEntry*, const GameDbIndexEntry*> find(uint64_t key) const;
+    // その局面を通った対局の番号（重複なし、昇順、最大 limit 件）。戻り値は全件数
+    size_t gamesReaching(uint64_t key, std::vector<uint32_t>& out, size_t limit = SIZE_MAX) const;
+    // その局面で指された手ごとの対局数と結果（対局数の多い順）
+    void moveStats(uint64_t key, std::vector<MoveStat>& out) const;
+    // 定跡手（対局数の多い順）
+    std::pair<const BookEntry*, const BookEntry*> bookMoves(uint64_t key) const;
+
+private:
+    MappedFile file;
+    const GameDbHeader* header = nullptr;
+    const GameDbGame* games = nullptr;
+    const PackedMove* moveData = nullptr;
+    const GameDbIndexEntry* index = nullptr;
+    const BookEntry* book = nullptr;
+    const uint64_t* radix = nullptr;
+};
+
+// 定跡から手を1つ選ぶ（現局面で合法な手だけ）。seed が 0 なら最も多く指された手、
+// それ以外は対局数に比例した確率で選ぶ。定跡になければ MOVE_NONE
+Move pickBookMove(const GameDb& db, const Position& pos, uint64_t seed = 0);
+// 棋譜データベースは 8x8 だけなので、ほかの盤では定跡を引かない
+template<class G>
+inline Move pickBookMove(const GameDb&, const BasicPosition<G>&, uint64_t = 0){ return MOVE_NONE; }
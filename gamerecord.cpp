@@ -0,0 +1,133 @@
+#include "gamerecord.h"
+#include <cstring>
+
+template<class G>
+Termination terminationAfter(const BasicPosition<G>& pos, const GameHistory& history, const BasicMoveInfo<G>& info){
+    if(info.captured == KING) return TERM_KING_CAPTURED;
+    if(info.kingFlipped) return TERM_KING_FLIPPED;
+    BasicMoveList<G> list;
+    generateMoves(pos, list);
+    if(list.size == 0) return inCheck(pos) ? TERM_CHECKMATE : TERM_STALEMATE;
+    if(isThreefold(history, pos)) return TERM_THREEFOLD;
+    if(isFiftyMoveDraw(pos)) return TERM_FIFTY_MOVES;
+    return TERM_NONE;
+}
+
+GameResult resultOf(Termination t, int mover){
+    switch(t){
+    case TERM_NONE: return RESULT_UNFINISHED;
+    case TERM_KING_CAPTURED:
+    case TERM_KING_FLIPPED:
+    case TERM_CHECKMATE: return mover == WHITE ? RESULT_WHITE_WINS : RESULT_BLACK_WINS;
+    default: return RESULT_DRAW;
+    }
+}
+
+const char* terminationName(Termination t){
+    static const char* NAMES[] = { "none", "king captured", "king flipped", "threefold",
+                                   "fifty moves", "no moves", "max plies", "checkmate", "stalemate" };
+    return t <= TERM_STALEMATE ? NAMES[t] : "?";
+}
+
+// --- リトルエンディアンで読み書き ---
+static void putLE(uint8_t* p, uint64_t v, int bytes){
+    for(int i=0;i<bytes;i++) p[i] = uint8_t(v >> (8 * i));
+}
+static uint64_t getLE(const uint8_t* p, int bytes){
+    uint64_t v = 0;
+    for(int i=0;i<bytes;i++) v |= uint64_t(p[i]) << (8 * i);
+    return v;
+}
+
+// 1手のバイト数（8x8 は 6|6|4 の 16 ビット、大きい盤は from, to, flag を1バイトずつ）
+static int moveBytes(int boardSize){ return boardSize == 8 ? 2 : 3; }
+
+void encodeGameRecord(const GameRecord& rec, std::vector<uint8_t>& out){
+    size_t base = out.size();
+    int mb = moveBytes(rec.boardSize);
+    out.resize(base + GAME_RECORD_HEADER_SIZE + mb * rec.moves.size());
+    uint8_t* p = out.data() + base;
+    std::memset(p, 0, GAME_RECORD_HEADER_SIZE);
+    std::memcpy(p, "OCGR", 4);
+    p[4] = GAME_RECORD_VERSION;
+    p[5] = rec.result;
+    p[6] = rec.termination;
+    p[7] = rec.boardSize;
+    putLE(p + 8, rec.moves.size(), 2);
+    putLE(p + 12, rec.index, 4);
+    putLE(p + 16, rec.seed, 8);
+    p += GAME_RECORD_HEADER_SIZE;
+    for(Move m : rec.moves){
+        if(mb == 2) putLE(p, packMove(m), 2);
+        else { p[0] = uint8_t(moveFrom(m)); p[1] = uint8_t(moveTo(m)); p[2] = uint8_t(moveFlag(m)); }
+        p += mb;
+    }
+}
+
+bool writeGameRecord(FILE* f, const GameRecord& rec){
+    std::vector<uint8_t> buf;
+    encodeGameRecord(rec, buf);
+    return std::fwrite(buf.data(), 1, buf.size(), f) == buf.size();
+}
+
+bool readGameRecord(FILE* f, GameRecord& rec){
+    uint8_t h[GAME_RECORD_HEADER_SIZE];
+    if(std::fread(h, 1, sizeof(h), f) != sizeof(h)) return false;
+    if(std::memcmp(h, "OCGR", 4) != 0 || h[4] < 1 || h[4] > GAME_RECORD_VERSION) return false;
+    if(h[5] > RESULT_UNFINISHED || h[6] > TERM_STALEMATE) return false;
+    int size = h[4] == 1 ? 8 : h[7];
+    if(!isBoardSize(size)) return false;
+    rec.boardSize = uint8_t(size);
+    rec.result = GameResult(h[5]);
+    rec.termination = Termination(h[6]);
+    size_t n = getLE(h + 8, 2);
+    rec.index = uint32_t(getLE(h + 12, 4));
+    rec.seed = getLE(h + 16, 8);
+    int mb = moveBytes(size);
+    std::vector<uint8_t> body(mb * n);
+    if(n && std::fread(body.data(), 1, body.size(), f) != body.size()) return false;
+    rec.moves.resize(n);
+    for(size_t i=0;i<n;i++){
+        const uint8_t* q = &body[mb * i];
+        rec.moves[i] = mb == 2 ? unpackMove(PackedMove(getLE(q, 2))) : moveOf(q[0], q[1], q[2]);
+    }
+    return true;
+}
+
+template<class G>
+bool replayGameRecord(const GameRecord& rec, BasicPosition<G>& pos, std::string* error){
+    auto fail = [&](const std::string& msg){ if(error) *error = msg; return false; };
+    if(rec.boardSize != G::ROWS) return fail("board size " + std::to_string(rec.boardSize) + " does not match");
+    setStartPosition(pos);
+    GameHistory history;
+    history.reset(pos);
+    Termination term = TERM_NONE;
+    int mover = WHITE;
+    for(size_t i=0;i<rec.moves.size();i++){
+        if(term != TERM_NONE) return fail("moves after game end at ply " + std::to_string(i));
+        Move m = rec.moves[i];
+        BasicMoveList<G> list;
+        generateMoves(pos, list);
+        bool found = false;
+        for(Move x : list) if(x == m){ found = true; break; }
+        if(!found) return fail("illegal move " + moveToString<G>(m) + " at ply " + std::to_string(i));
+        BasicMoveInfo<G> info;
+        mover = pos.sideToMove;
+        makeMove(pos, m, &info);
+        history.push(pos);
+        term = terminationAfter(pos, history, info);
+    }
+    // 手数上限・手詰まりは記録側の判断なので、ルール上の終局と食い違わないことだけ見る
+    if(term != TERM_NONE && term != rec.termination)
+        return fail(std::string("termination mismatch: replay says ") + terminationName(term));
+    if(term == TERM_NONE && rec.termination != TERM_MAX_PLIES && rec.termination != TERM_NO_MOVES
+       && rec.termination != TERM_NONE)
+        return fail(std::string("record says ") + terminationName(rec.termination) + " but the game is not over");
+    if(term != TERM_NONE && resultOf(term, mover) != rec.result) return fail("result mismatch");
+    return true;
+}
+
+#define INSTANTIATE_GAME_RECORD(G) \
+    template Termination terminationAfter(const BasicPosition<G>&, const GameHistory&, const BasicMoveInfo<G>&); \
+    template bool replayGameRecord(const GameRecord&, BasicPosition<G>&, std::string*);
+FOR_EACH_GEOMETRY(INSTANTIATE_GAME_RECORD)
@@ -0,0 +1,53 @@
+#pragma once
+#include "position.h"
+#include "history.h"
+#include <vector>
+#include <string>
+#include <cstdio>
+
+// --- 対局記録（バイナリ） ---
+// 24バイトのヘッダの後に手を並べる。8x8 は 1手2バイト（packMove、リトルエンディアン）、
+// それより大きい盤は from, to, flag の 1手3バイト。
+//   0  "OCGR"        4  version      5  result      6  termination   7  盤の一辺
+//   8  手数 (u16)    10 予約 (u16)    12 対局番号 (u32)  16 乱数シード (u64)
+// 初期局面は常にその盤の開始局面。serializeBoard で1手ごとに65バイト書くより約30倍小さい。
+// version 1 は盤の一辺の欄が予約（0）だった 8x8 だけの形式で、読み込みはそのまま受け付ける。
+enum GameResult : uint8_t { RESULT_WHITE_WINS, RESULT_BLACK_WINS, RESULT_DRAW, RESULT_UNFINISHED };
+
+enum Termination : uint8_t {
+    TERM_NONE,              // まだ続いている
+    TERM_KING_CAPTURED,     // 合法手だけなら起きない（キングが取られる局面から始めたときのみ）
+    TERM_KING_FLIPPED,
+    TERM_THREEFOLD,
+    TERM_FIFTY_MOVES,
+    TERM_NO_MOVES,
+    TERM_MAX_PLIES,         // 手数上限で引き分け扱い
+    TERM_CHECKMATE,
+    TERM_STALEMATE,
+};
+
+const int GAME_RECORD_HEADER_SIZE = 24;
+const uint8_t GAME_RECORD_VERSION = 2;
+
+struct GameRecord {
+    uint32_t index = 0;
+    uint64_t seed = 0;
+    GameResult result = RESULT_UNFINISHED;
+    Termination termination = TERM_NONE;
+    uint8_t boardSize = 8;       // 盤の一辺（8 / 10 / 12）
+    std::vector<Move> moves;
+};
+
+// 指した直後の局面から終局を判定する（GUI と同じルール）
+template<class G>
+Termination terminationAfter(const BasicPosition<G>& pos, const GameHistory& history, const BasicMoveInfo<G>& info);
+GameResult resultOf(Termination t, int mover);
+const char* terminationName(Termination t);
+
+void encodeGameRecord(const GameRecord& rec, std::vector<uint8_t>& out);   // out の末尾に追記
+bool writeGameRecord(FILE* f, const GameRecord& rec);
+bool readGameRecord(FILE* f, GameRecord& rec);         // 終端や壊れたデータなら false
+
+// 記録を初期局面から再生し、手の合法性と結果が一致するか確かめる（rec.boardSize が G の盤であること）
+template<class G>
+bool replayGameRecord(const GameRecord& rec, BasicPosition<G>& finalPos, std::string* error = nullptr);
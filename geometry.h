@@ -0,0 +1,161 @@
+#pragma once
+#include <cstdint>
+
+// --- 盤の形（コンパイル時） ---
+// Geometry<R, C> は R 行 C 列の盤。マス番号 sq = row*C + col（row 0 が黒の初期段）。
+// ビットボードの型はマス数で決まる: 64 以下は uint64_t、128 以下は unsigned __int128
+// （64 ビット語 2 つ）、それより大きければ 64 ビット語の配列（WideBoard）。どれも同じ演算子と
+// popcount / lsb / msb / popLsb で扱えるので、ルールのテンプレートは型を意識しない。
+// 行数・列数・端のマスク・方向ごとのシフト量はすべて定数なので、ループの中で盤の大きさを
+// 調べることはない。通常の 8x8 は Geometry8（bitboard.h の Bitboard はその Board 型）。
+
+template<int N>
+struct WideBoard {
+    uint64_t w[N];
+
+    constexpr WideBoard() : w{} {}
+    constexpr explicit operator bool() const {
+        for(int i=0;i<N;i++) if(w[i]) return true;
+        return false;
+    }
+    constexpr WideBoard operator~() const { WideBoard r; for(int i=0;i<N;i++) r.w[i] = ~w[i]; return r; }
+    constexpr WideBoard& operator&=(const WideBoard& o){ for(int i=0;i<N;i++) w[i] &= o.w[i]; return *this; }
+    constexpr WideBoard& operator|=(const WideBoard& o){ for(int i=0;i<N;i++) w[i] |= o.w[i]; return *this; }
+    constexpr WideBoard& operator^=(const WideBoard& o){ for(int i=0;i<N;i++) w[i] ^= o.w[i]; return *this; }
+    constexpr WideBoard operator&(const WideBoard& o) const { WideBoard r = *this; return r &= o; }
+    constexpr WideBoard operator|(const WideBoard& o) const { WideBoard r = *this; return r |= o; }
+    constexpr WideBoard operator^(const WideBoard& o) const { WideBoard r = *this; return r ^= o; }
+    constexpr bool operator==(const WideBoard& o) const {
+        for(int i=0;i<N;i++) if(w[i] != o.w[i]) return false;
+        return true;
+    }
+    constexpr bool operator!=(const WideBoard& o) const { return !(*this == o); }
+
+    // s は 0..64*N-1（盤の方向シフトと塗りつぶしの倍々のシフトはこれに収まる）
+    constexpr WideBoard operator<<(int s) const {
+        WideBoard r;
+        int q = s >> 6, b = s & 63;
+        for(int i=N-1;i>=q;i--){
+            r.w[i] = w[i - q] << b;
+            if(b && i - q - 1 >= 0) r.w[i] |= w[i - q - 1] >> (64 - b);
+        }
+        return r;
+    }
+    constexpr WideBoard operator>>(int s) const {
+        WideBoard r;
+        int q = s >> 6, b = s & 63;
+        for(int i=0;i+q<N;i++){
+            r.w[i] = w[i + q] >> b;
+            if(b && i + q + 1 < N) r.w[i] |= w[i + q + 1] << (64 - b);
+        }
+        return r;
+    }
+};
+
+typedef unsigned __int128 Board128;
+
+// --- 型ごとの基本操作（msb は負方向の利きと反転で最初に当たるマスを引く） ---
+
+inline int popcount(uint64_t b){ return __builtin_popcountll(b); }
+inline int lsb(uint64_t b){ return __builtin_ctzll(b); }
+inline int msb(uint64_t b){ return 63 - __builtin_clzll(b); }
+inline int popLsb(uint64_t& b){ int s = lsb(b); b &= b - 1; return s; }
+inline bool moreThanOne(uint64_t b){ return (b & (b - 1)) != 0; }
+
+inline int popcount(Board128 b){ return __builtin_popcountll(uint64_t(b)) + __builtin_popcountll(uint64_t(b >> 64)); }
+inline int lsb(Board128 b){ return uint64_t(b) ? __builtin_ctzll(uint64_t(b)) : 64 + __builtin_ctzll(uint64_t(b >> 64)); }
+inline int msb(Board128 b){ return uint64_t(b >> 64) ? 127 - __builtin_clzll(uint64_t(b >> 64)) : 63 - __builtin_clzll(uint64_t(b)); }
+inline int popLsb(Board128& b){ int s = lsb(b); b &= b - 1; return s; }
+inline bool moreThanOne(Board128 b){ return (b & (b - 1)) != 0; }
+
+template<int N> inline int popcount(const WideBoard<N>& b){
+    int n = 0;
+    for(int i=0;i<N;i++) n += __builtin_popcountll(b.w[i]);
+    return n;
+}
+template<int N> inline int lsb(const WideBoard<N>& b){
+    for(int i=0;i<N;i++) if(b.w[i]) return i * 64 + __builtin_ctzll(b.w[i]);
+    return -1;
+}
+template<int N> inline int msb(const WideBoard<N>& b){
+    for(int i=N-1;i>=0;i--) if(b.w[i]) return i * 64 + 63 - __builtin_clzll(b.w[i]);
+    return -1;
+}
+template<int N> inline int popLsb(WideBoard<N>& b){
+    for(int i=0;i<N;i++)
+        if(b.w[i]){
+            int s = i * 64 + __builtin_ctzll(b.w[i]);
+            b.w[i] &= b.w[i] - 1;
+            return s;
+        }
+    return -1;
+}
+template<int N> inline bool moreThanOne(const WideBoard<N>& b){ return popcount(b) > 1; }
+
+template<int Bits, bool Small = (Bits <= 64), bool Medium = (Bits <= 128)> struct BoardFor { typedef WideBoard<(Bits + 63) / 64> type; };
+template<int Bits> struct BoardFor<Bits, true, true> { typedef uint64_t type; };
+template<int Bits> struct BoardFor<Bits, false, true> { typedef Board128 type; };
+
+template<class B> struct BoardTraits {
+    static constexpr B bit(int sq){ return B(1) << sq; }
+};
+template<int N> struct BoardTraits<WideBoard<N>> {
+    static constexpr WideBoard<N> bit(int sq){ WideBoard<N> r; r.w[sq >> 6] = 1ULL << (sq & 63); return r; }
+};
+
+// --- 8方向（main.cpp の dir[8][2] と同じ並び。前半 4 つがマス番号の減る向き） ---
+// {-1,-1},{-1,0},{-1,1},{0,-1},{0,1},{1,-1},{1,0},{1,1}
+enum Dir { NW, N, NE, W, E, SW, S, SE };
+constexpr int DIR_DR[8] = { -1, -1, -1,  0, 0, 1, 1, 1 };
+constexpr int DIR_DC[8] = { -1,  0,  1, -1, 1,-1, 0, 1 };
+
+template<int R, int C>
+struct Geometry {
+    static constexpr int ROWS = R;
+    static constexpr int COLS = C;
+    static constexpr int SQUARES = R * C;
+    typedef typename BoardFor<R * C>::type Board;
+    static_assert(SQUARES <= 256, "squares must fit in the 8-bit from/to fields of Move");
+
+    static constexpr int sqOf(int row, int col){ return row * C + col; }
+    static constexpr int rowOf(int sq){ return sq / C; }
+    static constexpr int colOf(int sq){ return sq % C; }
+    static constexpr Board bit(int sq){ return BoardTraits<Board>::bit(sq); }
+
+    static constexpr Board makeAll(){ Board b{}; for(int s=0;s<SQUARES;s++) b |= bit(s); return b; }
+    static constexpr Board makeFile(int col){ Board b{}; for(int r=0;r<R;r++) b |= bit(sqOf(r, col)); return b; }
+    static constexpr Board makeRow(int row){ Board b{}; for(int c=0;c<C;c++) b |= bit(sqOf(row, c)); return b; }
+
+    static constexpr Board ALL = makeAll();
+    static constexpr Board NOT_FIRST_FILE = ALL & ~makeFile(0);
+    static constexpr Board NOT_LAST_FILE = ALL & ~makeFile(C - 1);
+    static constexpr int DELTA[8] = { -C-1, -C, -C+1, -1, 1, C-1, C, C+1 };
+    // シフト後に端を跨いだビットと盤外のビットを落とすマスク
+    static constexpr Board DIR_MASK[8] = { NOT_LAST_FILE, ALL, NOT_FIRST_FILE, NOT_LAST_FILE,
+                                           NOT_FIRST_FILE, NOT_LAST_FILE, ALL, NOT_FIRST_FILE };
+
+    static constexpr Board shift(Board b, int d){
+        int s = DELTA[d];
+        b = s > 0 ? b << s : b >> -s;
+        return b & DIR_MASK[d];
+    }
+};
+
+typedef Geometry<8, 8> Geometry8;
+typedef Geometry<10, 10> Geometry10;
+typedef Geometry<12, 12> Geometry12;
+
+// ルールを実体化する盤。テンプレートを .cpp に置くファイルは末尾で
+// FOR_EACH_GEOMETRY(マクロ) としてこの全部を明示的に実体化する
+#define FOR_EACH_GEOMETRY(X) X(Geometry8) X(Geometry10) X(Geometry12)
+
+// 実行時の盤の一辺（--board）から Geometry を選んで f(Geometry{}) を呼ぶ。
+// 大きさを調べるのはここだけで、呼ばれた先はすべてコンパイル時に決まる
+inline bool isBoardSize(int n){ return n == 8 || n == 10 || n == 12; }
+
+template<class F>
+auto withGeometry(int size, F&& f){
+    if(size == 10) return f(Geometry10{});
+    if(size == 12) return f(Geometry12{});
+    return f(Geometry8{});
+}
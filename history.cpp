@@ -0,0 +1,13 @@
+#include "history.h"
+
+int countRepetitions(const uint64_t* keys, int size, int halfMoveClock){
+    if(size < 5) return 0;
+    uint64_t cur = keys[size - 1];
+    int stop = size - 1 - halfMoveClock;
+    if(stop < 0) stop = 0;
+    int count = 0;
+    // 同じ手番の局面だけを見るので2手ずつ遡る
+    for(int i = size - 3; i >= stop; i -= 2)
+        if(keys[i] == cur) count++;
+    return count;
+}
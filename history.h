@@ -0,0 +1,29 @@
+#pragma once
+#include "position.h"
+#include <vector>
+
+// --- 局面履歴（Zobrist キーの平坦な配列） ---
+// keys[i] は i 手目を指した後の局面。末尾が現局面。
+// reset は HISTORY_RESERVE 手分を確保する（すでにあれば取り直さない）。
+// キーしか持たないので盤の大きさによらず同じ型
+const int HISTORY_RESERVE = 512;
+
+struct GameHistory {
+    std::vector<uint64_t> keys;
+
+    template<class G>
+    void reset(const BasicPosition<G>& pos){ keys.clear(); keys.reserve(HISTORY_RESERVE); keys.push_back(pos.key); }
+    template<class G>
+    void push(const BasicPosition<G>& pos){ keys.push_back(pos.key); }
+    void pop(){ keys.pop_back(); }
+};
+
+// 現局面と同じ局面が過去に何回現れたか（取り・ポーン移動より前は遡らない）
+int countRepetitions(const uint64_t* keys, int size, int halfMoveClock);
+
+template<class G>
+inline bool isThreefold(const GameHistory& h, const BasicPosition<G>& pos){
+    return countRepetitions(h.keys.data(), (int)h.keys.size(), pos.halfMoveClock) >= 2;
+}
+template<class G>
+inline bool isFiftyMoveDraw(const BasicPosition<G>& pos){ return pos.halfMoveClock >= 100; }
@@ -0,0 +1,60 @@
+#include "hud.h"
+#include <algorithm>
+#include <cstdio>
+
+void setLabel(SDL_Renderer* ren, TTF_Font* font, TextLabel& label, const std::string& text, SDL_Color color){
+    if(label.texture && label.text == text && label.color.r == color.r && label.color.g == color.g
+       && label.color.b == color.b && label.color.a == color.a) return;
+    destroyLabel(label);
+    label.text = text;
+    label.color = color;
+    SDL_Surface* surf = font ? TTF_RenderText_Blended(font, text.c_str(), color) : nullptr;   // フォントがない環境（headless など）
+    if(!surf) return;
+    label.texture = SDL_CreateTextureFromSurface(ren, surf);
+    label.w = surf->w;
+    label.h = surf->h;
+    SDL_FreeSurface(surf);
+}
+
+void destroyLabel(TextLabel& label){
+    if(label.texture) SDL_DestroyTexture(label.texture);
+    label.texture = nullptr;
+    label.w = label.h = 0;
+}
+
+void FrameStats::record(double frameMs, int calls){
+    ms[next] = frameMs;
+    next = (next + 1) % WINDOW;
+    if(count < WINDOW) count++;
+    drawCalls = calls;
+    frames++;
+}
+
+double FrameStats::percentile(double p) const {
+    if(count == 0) return 0;
+    double sorted[WINDOW];
+    std::copy(ms, ms + count, sorted);
+    int k = std::min(count - 1, int(p / 100.0 * count));
+    std::nth_element(sorted, sorted + k, sorted + count);
+    return sorted[k];
+}
+
+int drawHud(SDL_Renderer* ren, TTF_Font* font, TextLabel& label, const FrameStats& stats, Uint32 refreshMs){
+    Uint32 now = SDL_GetTicks();
+    if(!label.texture || now - label.updatedAt >= refreshMs){
+        char buf[128];
+        std::snprintf(buf, sizeof buf, "frame p50 %.2f  p95 %.2f  p99 %.2f ms  submits %d",
+                      stats.percentile(50), stats.percentile(95), stats.percentile(99), stats.drawCalls);
+        setLabel(ren, font, label, buf, SDL_Color{ 255, 255, 255, 255 });
+        label.updatedAt = now;
+    }
+    if(!label.texture) return 0;
+    SDL_Rect bg = { 0, 0, label.w + 8, label.h + 4 };
+    SDL_SetRenderDrawBlendMode(ren, SDL_BLENDMODE_BLEND);
+    SDL_SetRenderDrawColor(ren, 0, 0, 0, 160);
+    SDL_RenderFillRect(ren, &bg);
+    SDL_SetRenderDrawBlendMode(ren, SDL_BLENDMODE_NONE);
+    SDL_Rect dst = { 4, 2, label.w, label.h };
+    SDL_RenderCopy(ren, label.texture, nullptr, &dst);
+    return 2;
+}
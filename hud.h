@@ -0,0 +1,32 @@
+#pragma once
+#include <SDL.h>
+#include <SDL_ttf.h>
+#include <string>
+
+// --- 文字列テクスチャのキャッシュ ---
+// 文字列か色が変わったときだけラスタライズし直す
+struct TextLabel {
+    SDL_Texture* texture = nullptr;
+    int w = 0, h = 0;
+    std::string text;
+    SDL_Color color = { 0, 0, 0, 0 };
+    Uint32 updatedAt = 0;            // SDL_GetTicks()（drawHud の間引き用）
+};
+
+void setLabel(SDL_Renderer* ren, TTF_Font* font, TextLabel& label, const std::string& text, SDL_Color color);
+void destroyLabel(TextLabel& label);
+
+// --- フレーム時間の統計（F3 のオーバーレイ用） ---
+struct FrameStats {
+    static const int WINDOW = 240;   // 直近何フレーム分を見るか
+    double ms[WINDOW];
+    int count = 0, next = 0;
+    int drawCalls = 0;               // 直前のフレームで SDL に渡した描画命令の数（GPU の描画回数とは限らない）
+    uint64_t frames = 0;
+
+    void record(double frameMs, int calls);
+    double percentile(double p) const;   // p は 0〜100
+};
+
+// 左上に統計を描く。文字列の作り直しは refreshMs ごとに1回だけ。戻り値は描画呼び出し数
+int drawHud(SDL_Renderer* ren, TTF_Font* font, TextLabel& label, const FrameStats& stats, Uint32 refreshMs = 250);
@@ -0,0 +1,199 @@
+#include "input_replay.h"
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <time.h>
+
+// --- 記録 ---
+
+bool InputRecorder::open(const std::string& path, std::string& error){
+    close();
+    file = std::fopen(path.c_str(), "w");
+    if(!file){ error = "cannot write " + path; return false; }
+    std::fprintf(file, "# ochello input\n");
+    startTicks = SDL_GetTicks();
+    SDL_AddEventWatch(&InputRecorder::watch, this);
+    return true;
+}
+
+void InputRecorder::close(){
+    if(!file) return;
+    SDL_DelEventWatch(&InputRecorder::watch, this);
+    std::fclose(file);
+    file = nullptr;
+}
+
+// キューに積まれた時点で呼ばれる。ワーカーが積む AI の通知などはここで読み飛ばす
+int SDLCALL InputRecorder::watch(void* self, SDL_Event* e){
+    InputRecorder* r = static_cast<InputRecorder*>(self);
+    Uint32 ms = SDL_GetTicks() - r->startTicks;
+    if(e->type==SDL_MOUSEBUTTONDOWN)
+        std::fprintf(r->file, "%u down %d %d %d\n", ms, int(e->button.x), int(e->button.y), int(e->button.button));
+    else if(e->type==SDL_KEYDOWN)
+        std::fprintf(r->file, "%u key %d %d\n", ms, int(e->key.keysym.sym), int(e->key.keysym.mod));
+    else if(e->type==SDL_QUIT)
+        std::fprintf(r->file, "%u quit\n", ms);
+    return 1;
+}
+
+// --- 再生 ---
+
+bool InputReplay::load(const std::string& path, std::string& error){
+    FILE* f = std::fopen(path.c_str(), "r");
+    if(!f){ error = "cannot open " + path; return false; }
+    entries.clear();
+    char line[256], kind[16];
+    int lineNo = 0;
+    while(std::fgets(line, sizeof line, f)){
+        lineNo++;
+        if(line[0]=='#' || line[0]=='\n' || line[0]=='\r') continue;
+        unsigned ms = 0;
+        int a = 0, b = 0, c = 0;
+        Entry en{};
+        if(std::sscanf(line, "%u %15s", &ms, kind) != 2){ error = path + ":" + std::to_string(lineNo) + ": bad line"; break; }
+        en.ms = ms;
+        if(std::strcmp(kind, "down")==0 && std::sscanf(line, "%*u %*s %d %d %d", &a, &b, &c)==3){
+            en.event.type = SDL_MOUSEBUTTONDOWN;
+            en.event.button.x = a;
+            en.event.button.y = b;
+            en.event.button.button = Uint8(c);
+            en.event.button.state = 1;       // SDL_PRESSED
+            en.event.button.clicks = 1;
+        } else if(std::strcmp(kind, "key")==0 && std::sscanf(line, "%*u %*s %d %d", &a, &b)==2){
+            en.event.type = SDL_KEYDOWN;
+            en.event.key.state = 1;
+            en.event.key.keysym.sym = a;
+            en.event.key.keysym.mod = Uint16(b);
+        } else if(std::strcmp(kind, "quit")==0){
+            en.event.type = SDL_QUIT;
+        } else {
+            error = path + ":" + std::to_string(lineNo) + ": bad line";
+            break;
+        }
+        entries.push_back(en);
+    }
+    std::fclose(f);
+    return error.empty();
+}
+
+void InputReplay::start(double s){
+    speed = std::max(0.0, s);
+    next = 0;
+    quitSent = false;
+    startTicks = SDL_GetTicks();
+}
+
+Uint32 InputReplay::dueAt(const Entry& en) const {
+    return startTicks + Uint32(en.ms / speed);
+}
+
+void InputReplay::pump(bool idle){
+    if(!idle || quitSent) return;
+    Uint32 now = SDL_GetTicks();
+    while(next < entries.size()){
+        Entry& en = entries[next];
+        if(speed > 0 && int32_t(dueAt(en) - now) > 0) return;
+        SDL_PushEvent(&en.event);
+        next++;
+        if(en.event.type==SDL_QUIT){ quitSent = true; return; }
+        if(speed == 0) return;           // 1回に1つずつ（処理と描画を挟む）
+    }
+    SDL_Event quit{};
+    quit.type = SDL_QUIT;
+    SDL_PushEvent(&quit);
+    quitSent = true;
+}
+
+int InputReplay::msUntilNext(bool idle) const {
+    if(!idle || quitSent) return -1;
+    if(next >= entries.size() || speed == 0) return 0;
+    return std::max(0, int32_t(dueAt(entries[next]) - SDL_GetTicks()));
+}
+
+// --- 確保回数 ---
+
+static thread_local uint64_t allocations = 0;
+
+void* operator new(std::size_t n){
+    allocations++;
+    if(void* p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+static SDL_malloc_func sdlMalloc;
+static SDL_calloc_func sdlCalloc;
+static SDL_realloc_func sdlRealloc;
+static SDL_free_func sdlFree;
+
+static void* SDLCALL countedMalloc(size_t n){ allocations++; return sdlMalloc(n); }
+static void* SDLCALL countedCalloc(size_t n, size_t size){ allocations++; return sdlCalloc(n, size); }
+static void* SDLCALL countedRealloc(void* p, size_t n){ allocations++; return sdlRealloc(p, n); }
+
+void countSdlAllocations(){
+    SDL_GetMemoryFunctions(&sdlMalloc, &sdlCalloc, &sdlRealloc, &sdlFree);
+    SDL_SetMemoryFunctions(countedMalloc, countedCalloc, countedRealloc, sdlFree);
+}
+
+uint64_t allocationCount(){ return allocations; }
+
+// --- 計測 ---
+
+BenchMark BenchMark::now(){
+    BenchMark m;
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    m.cpuMs = ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+    m.wallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    m.allocs = allocations;
+    return m;
+}
+
+bool BenchLog::open(const std::string& path, std::string& error){
+    close();
+    file = std::fopen(path.c_str(), "w");
+    if(!file){ error = "cannot write " + path; return false; }
+    std::fprintf(file, "kind,index,cpu_ms,wall_ms,allocs,detail\n");
+    frameCpu.reserve(1 << 16);
+    moveCpu.reserve(1024);
+    return true;
+}
+
+void BenchLog::row(const char* kind, uint64_t index, const BenchMark& start, const BenchMark& end, const std::string& detail){
+    double cpu = end.cpuMs - start.cpuMs;
+    uint64_t allocs = end.allocs - start.allocs;
+    std::fprintf(file, "%s,%llu,%.4f,%.4f,%llu,%s\n", kind, (unsigned long long)index, cpu,
+                 end.wallMs - start.wallMs, (unsigned long long)allocs, detail.c_str());
+    if(kind[0]=='f'){ frameCpu.push_back(cpu); frameAllocs += allocs; }
+    else { moveCpu.push_back(cpu); moveAllocs += allocs; }
+}
+
+// 終わりの時刻は最初に取る（書き出しの文字列を作る確保・時間を数えない）
+void BenchLog::frame(const BenchMark& start, int drawCalls){
+    if(!file) return;
+    BenchMark end = BenchMark::now();
+    row("frame", frameCpu.size(), start, end, std::to_string(drawCalls));
+}
+
+void BenchLog::close(){
+    if(!file) return;
+    std::fclose(file);
+    file = nullptr;
+    auto pct = [](std::vector<double> v, double p) -> double {
+        if(v.empty()) return 0;
+        size_t k = std::min(v.size() - 1, size_t(p / 100.0 * v.size()));
+        std::nth_element(v.begin(), v.begin() + k, v.end());
+        return v[k];
+    };
+    size_t frames = frameCpu.size(), moves = moveCpu.size();
+    std::cerr << std::fixed << std::setprecision(3)
+              << "frames " << frames << "  cpu p50 " << pct(frameCpu, 50) << " p99 " << pct(frameCpu, 99)
+              << " ms  allocs/frame " << (frames ? double(frameAllocs) / frames : 0) << "\n"
+              << "moves " << moves << "  cpu p50 " << pct(moveCpu, 50) << " max " << pct(moveCpu, 100)
+              << " ms  allocs/move " << (moves ? double(moveAllocs) / moves : 0) << "\n";
+}
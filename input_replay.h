@@ -0,0 +1,85 @@
+#pragma once
+#include <SDL.h>
+#include <cstdio>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "position.h"
+
+// --- 入力の記録と再生（描画ループのベンチマーク用） ---
+// --record で遊んだ操作（クリック・キー・終了）を時刻つきでテキストに書き出し、
+// --replay でそれを SDL のイベントキューに積み直して同じ処理・同じ描画を通す。
+// 書式は1行1イベント:
+//   <ms> down <x> <y> <button>
+//   <ms> key <sym> <mod>
+//   <ms> quit
+// AI と対局した記録を同じ手で再生できるのは --engine mcts --threads 1 --playouts N のときだけ
+// （アルファベータは持ち時間で打ち切るので決定的にならない）。記録・再生中は先読み（ponder）を
+// しない。AI の返事を待つ間は次の入力を積まない。
+
+class InputRecorder {
+public:
+    ~InputRecorder(){ close(); }
+    // SDL_Init の後に呼ぶ。以降キューに入った入力を書き出す
+    bool open(const std::string& path, std::string& error);
+    void close();
+private:
+    static int SDLCALL watch(void* self, SDL_Event* e);
+    FILE* file = nullptr;
+    Uint32 startTicks = 0;
+};
+
+class InputReplay {
+public:
+    bool load(const std::string& path, std::string& error);
+    // speed は記録時の何倍速で流すか（0 = 待たずに1つずつ流す）
+    void start(double speed);
+    // 時刻が来た入力をイベントキューに積む。idle が false（AI の返事待ちなど）の間は積まない。
+    // 最後まで流し終えて記録に終了がなければ SDL_QUIT を積む
+    void pump(bool idle);
+    // 次の入力を積むまでの待ち時間（ミリ秒、-1 = 入力を待たない）
+    int msUntilNext(bool idle) const;
+    bool finished() const { return next >= entries.size() && quitSent; }
+    size_t size() const { return entries.size(); }
+private:
+    struct Entry { Uint32 ms; SDL_Event event; };
+    Uint32 dueAt(const Entry& en) const;
+    std::vector<Entry> entries;
+    size_t next = 0;
+    Uint32 startTicks = 0;
+    double speed = 1;
+    bool quitSent = false;
+};
+
+// --- 計測（フレームと手の処理時間・確保回数を CSV に） ---
+// 確保回数はこのスレッドの operator new と SDL_malloc / calloc / realloc の呼び出し数
+void countSdlAllocations();            // SDL_Init の前に呼ぶ
+uint64_t allocationCount();
+
+struct BenchMark {
+    double cpuMs, wallMs;                // スレッドの CPU 時間と経過時間
+    uint64_t allocs;
+    static BenchMark now();
+};
+
+class BenchLog {
+public:
+    ~BenchLog(){ close(); }
+    bool open(const std::string& path, std::string& error);
+    bool isOpen() const { return file != nullptr; }
+    // start からの差分を1行書く
+    void frame(const BenchMark& start, int drawCalls);
+    template<class G>
+    void move(const BenchMark& start, Move mv){
+        if(!file) return;
+        BenchMark end = BenchMark::now();
+        row("move", moveCpu.size(), start, end, moveToString<G>(mv));
+    }
+    // 閉じるときに集計を標準エラーに出す
+    void close();
+private:
+    void row(const char* kind, uint64_t index, const BenchMark& start, const BenchMark& end, const std::string& detail);
+    FILE* file = nullptr;
+    std::vector<double> frameCpu, moveCpu;
+    uint64_t frameAllocs = 0, moveAllocs = 0;
+};
@@ -0,0 +1,327 @@
+// --- loadgen: server に多数の接続・対局を張って負荷をかけ、moves/s と応答時間を測る（Linux / epoll） ---
+// 使い方:
+//   loadgen [--host addr] [--port P] [--connections C] [--games G] [--seconds S] [--ai] [--seed S] [--board N]
+// 各接続で G 局を同時に進める。クライアントも同じルールで局面を持ち、合法手からランダムに指す。
+// --ai なら黒はサーバのエンジンが指し、そうでなければ両方の手をクライアントが送る。
+// --board はサーバと同じ盤にする（NEW の局面の長さが合わなければ止める）。
+// 応答時間は MOVE を送ってから OK が届くまで（エンジンの思考時間は含まない）。
+#include "position.h"
+#include "zobrist.h"
+#include "attacks.h"
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <cstdlib>
+#include <cerrno>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/resource.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+typedef std::chrono::steady_clock Clock;
+
+struct LoadOptions {
+    std::string host = "127.0.0.1";
+    int port = 7777;
+    int connections = 100;
+    int games = 4;
+    int seconds = 10;
+    bool ai = false;
+    uint64_t seed = 1;
+    int boardSize = 8;
+};
+
+template<class G>
+struct ClientGame {
+    uint32_t gid = 0;
+    BasicPosition<G> pos;
+    Clock::time_point sentAt;
+};
+
+template<class G>
+struct ClientConn {
+    int fd = -1;
+    std::string in, out;
+    std::vector<ClientGame<G>> games;
+    std::vector<int> waitingNew;      // NEW の返事を待っている対局（送った順）
+    std::vector<int> resting;         // server full で断られ、retryAt を過ぎたら頼み直す対局
+    Clock::time_point retryAt;
+};
+
+struct LoadStats {
+    uint64_t moves = 0, engineMoves = 0, games = 0, errors = 0, full = 0;
+    std::vector<float> latencyUs;
+};
+
+template<class G>
+class LoadGen {
+public:
+    typedef ClientConn<G> Conn;
+    typedef ClientGame<G> Game;
+
+    explicit LoadGen(const LoadOptions& o) : opt(o), rng(o.seed) {}
+    bool connectAll(std::string& err);
+    bool run();
+    void report(double secs) const;
+
+private:
+    void requestNew(Conn& c, int index);
+    void sendMove(Conn& c, Game& g);
+    void finishGame(Conn& c, Game& g);
+    void handleLine(Conn& c, const std::string& line);
+    Game* findGame(Conn& c, uint32_t gid);
+    bool flush(Conn& c);
+
+    LoadOptions opt;
+    uint64_t rng;
+    int epfd = -1;
+    std::vector<Conn> conns;
+    LoadStats stats;
+    bool wrongBoard = false;          // サーバの盤が --board と違う
+};
+
+template<class G>
+bool LoadGen<G>::connectAll(std::string& err){
+    epfd = epoll_create1(0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(uint16_t(opt.port));
+    if(inet_pton(AF_INET, opt.host.c_str(), &addr.sin_addr) != 1){ err = "bad address " + opt.host; return false; }
+    conns.resize(opt.connections);
+    for(int i=0;i<opt.connections;i++){
+        Conn& c = conns[i];
+        c.fd = socket(AF_INET, SOCK_STREAM, 0);
+        if(c.fd < 0 || connect(c.fd, (sockaddr*)&addr, sizeof(addr)) < 0){
+            err = "connection " + std::to_string(i) + ": " + std::strerror(errno);
+            return false;
+        }
+        int one = 1;
+        setsockopt(c.fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        fcntl(c.fd, F_SETFL, fcntl(c.fd, F_GETFL, 0) | O_NONBLOCK);
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.u32 = uint32_t(i);
+        epoll_ctl(epfd, EPOLL_CTL_ADD, c.fd, &ev);
+        c.games.resize(opt.games);
+        for(int g=0;g<opt.games;g++) requestNew(c, g);
+        flush(c);
+    }
+    return true;
+}
+
+template<class G>
+void LoadGen<G>::requestNew(Conn& c, int index){
+    c.games[index].gid = 0;
+    c.resting.erase(std::remove(c.resting.begin(), c.resting.end(), index), c.resting.end());
+    c.waitingNew.push_back(index);
+    c.out += opt.ai ? "NEW ai\n" : "NEW\n";
+}
+
+template<class G>
+void LoadGen<G>::sendMove(Conn& c, Game& g){
+    BasicMoveList<G> list;
+    generateMoves(g.pos, list);
+    if(list.size == 0){ finishGame(c, g); return; }
+    Move mv = list.moves[splitmix64(rng) % list.size];
+    c.out += "MOVE " + std::to_string(g.gid) + " " + moveToString<G>(mv) + "\n";
+    makeMove(g.pos, mv);
+    g.sentAt = Clock::now();
+}
+
+template<class G>
+void LoadGen<G>::finishGame(Conn& c, Game& g){
+    stats.games++;
+    c.out += "END " + std::to_string(g.gid) + "\n";
+    g.gid = 0;
+}
+
+template<class G>
+ClientGame<G>* LoadGen<G>::findGame(Conn& c, uint32_t gid){
+    for(Game& g : c.games) if(g.gid == gid) return &g;
+    return nullptr;
+}
+
+template<class G>
+void LoadGen<G>::handleLine(Conn& c, const std::string& line){
+    char cmd[8] = {}, arg[16] = {}, status[8] = {};
+    unsigned gid = 0;
+    if(std::sscanf(line.c_str(), "%7s %u", cmd, &gid) < 1) return;
+    std::string type = cmd;
+
+    if(type == "NEW"){
+        if(c.waitingNew.empty()) return;
+        size_t board = line.rfind(' ');
+        if(line.size() - board - 1 != size_t(G::SQUARES + 1)){ wrongBoard = true; return; }
+        int index = c.waitingNew.front();
+        c.waitingNew.erase(c.waitingNew.begin());
+        Game& g = c.games[index];
+        g.gid = gid;
+        setStartPosition(g.pos);
+        sendMove(c, g);
+        return;
+    }
+    if(type == "END"){
+        // 返却が済んだので同じ枠で次の対局を始める
+        for(size_t i=0;i<c.games.size();i++)
+            if(c.games[i].gid == 0 && std::find(c.waitingNew.begin(), c.waitingNew.end(), int(i)) == c.waitingNew.end()){
+                requestNew(c, int(i));
+                break;
+            }
+        return;
+    }
+    Game* g = findGame(c, gid);
+    if(type == "ERR"){
+        if(line.find("server full") != std::string::npos && !c.waitingNew.empty()){
+            // この対局は休ませ、同じ接続の対局が終わったときか 100ms 後に頼み直す
+            stats.full++;
+            c.resting.push_back(c.waitingNew.front());
+            c.waitingNew.erase(c.waitingNew.begin());
+            c.retryAt = Clock::now() + std::chrono::milliseconds(100);
+            return;
+        }
+        stats.errors++;
+        if(g) finishGame(c, *g);
+        return;
+    }
+    if(!g) return;
+
+    if(type == "OK" && std::sscanf(line.c_str(), "%*s %*u %7s", status) == 1){
+        stats.moves++;
+        stats.latencyUs.push_back(float(std::chrono::duration<double, std::micro>(Clock::now() - g->sentAt).count()));
+        if(std::strcmp(status, "play") != 0) finishGame(c, *g);
+        else if(!opt.ai) sendMove(c, *g);
+    } else if(type == "AI" && std::sscanf(line.c_str(), "%*s %*u %15s %7s", arg, status) == 2){
+        stats.engineMoves++;
+        Move mv = parseMove(g->pos, arg);
+        if(!mv){ stats.errors++; finishGame(c, *g); return; }
+        makeMove(g->pos, mv);
+        if(std::strcmp(status, "play") != 0) finishGame(c, *g);
+        else sendMove(c, *g);
+    }
+}
+
+template<class G>
+bool LoadGen<G>::flush(Conn& c){
+    while(!c.out.empty()){
+        ssize_t n = ::send(c.fd, c.out.data(), c.out.size(), MSG_NOSIGNAL);
+        if(n < 0){
+            if(errno == EINTR) continue;
+            return errno == EAGAIN;     // 送れなかった分は次の読み込み後に送る
+        }
+        c.out.erase(0, size_t(n));
+    }
+    return true;
+}
+
+template<class G>
+bool LoadGen<G>::run(){
+    auto start = Clock::now();
+    epoll_event events[256];
+    char buf[16384];
+    while(!wrongBoard && std::chrono::duration<double>(Clock::now() - start).count() < opt.seconds){
+        int n = epoll_wait(epfd, events, 256, 100);
+        for(int i=0;i<n;i++){
+            Conn& c = conns[events[i].data.u32];
+            if(c.fd < 0) continue;
+            for(;;){
+                ssize_t r = ::read(c.fd, buf, sizeof(buf));
+                if(r > 0){ c.in.append(buf, size_t(r)); continue; }
+                if(r == 0 || (errno != EAGAIN && errno != EINTR)){
+                    std::cerr << "server closed connection\n";
+                    epoll_ctl(epfd, EPOLL_CTL_DEL, c.fd, nullptr);
+                    ::close(c.fd);
+                    c.fd = -1;
+                }
+                break;
+            }
+            if(c.fd < 0) continue;
+            size_t pos = 0;
+            for(;;){
+                size_t nl = c.in.find('\n', pos);
+                if(nl == std::string::npos) break;
+                handleLine(c, c.in.substr(pos, nl - pos));
+                pos = nl + 1;
+            }
+            c.in.erase(0, pos);
+            flush(c);
+        }
+        // 休ませた対局を頼み直し、送り残し（サーバ側のバッファが一杯だった）と合わせて送る
+        auto now = Clock::now();
+        for(Conn& c : conns){
+            if(c.fd < 0) continue;
+            if(!c.resting.empty() && now >= c.retryAt){
+                std::vector<int> retry = c.resting;
+                for(int index : retry) requestNew(c, index);
+            }
+            if(!c.out.empty()) flush(c);
+        }
+    }
+    for(Conn& c : conns) if(c.fd >= 0) ::close(c.fd);
+    ::close(epfd);
+    if(wrongBoard){
+        std::cerr << "server board is not " << G::ROWS << "x" << G::COLS << " (use the same --board)\n";
+        return false;
+    }
+    report(std::chrono::duration<double>(Clock::now() - start).count());
+    return true;
+}
+
+template<class G>
+void LoadGen<G>::report(double secs) const {
+    std::vector<float> lat = stats.latencyUs;
+    auto pct = [&](double p) -> double {
+        if(lat.empty()) return 0;
+        size_t k = std::min(lat.size() - 1, size_t(p * lat.size()));
+        std::nth_element(lat.begin(), lat.begin() + k, lat.end());
+        return lat[k];
+    };
+    double p50 = pct(0.50), p99 = pct(0.99), p999 = pct(0.999);
+    std::cout << opt.connections << " connections x " << opt.games << " games, " << std::fixed
+              << std::setprecision(1) << secs << "s\n";
+    std::cout << "moves " << stats.moves << "  (" << (uint64_t)(stats.moves / secs) << " moves/s)";
+    if(opt.ai) std::cout << "  engine replies " << stats.engineMoves << " (" << (uint64_t)(stats.engineMoves / secs) << "/s)";
+    std::cout << "\ngames finished " << stats.games << "  errors " << stats.errors << "  server full (retried) " << stats.full << "\n";
+    std::cout << "latency us  p50 " << std::setprecision(0) << p50 << "  p99 " << p99 << "  p99.9 " << p999 << "\n";
+}
+
+int main(int argc, char* argv[]){
+    initAttacks();
+    LoadOptions opt;
+    for(int i=1;i<argc;i++){
+        std::string a = argv[i];
+        if(a == "--host" && i+1 < argc) opt.host = argv[++i];
+        else if(a == "--port" && i+1 < argc) opt.port = std::atoi(argv[++i]);
+        else if(a == "--connections" && i+1 < argc) opt.connections = std::max(1, std::atoi(argv[++i]));
+        else if(a == "--games" && i+1 < argc) opt.games = std::max(1, std::atoi(argv[++i]));
+        else if(a == "--seconds" && i+1 < argc) opt.seconds = std::atoi(argv[++i]);
+        else if(a == "--ai") opt.ai = true;
+        else if(a == "--seed" && i+1 < argc) opt.seed = std::strtoull(argv[++i], nullptr, 10);
+        else if(a == "--board" && i+1 < argc) opt.boardSize = std::atoi(argv[++i]);
+        else {
+            std::cerr << "usage: loadgen [--host addr] [--port P] [--connections C] [--games G] [--seconds S] [--ai] [--seed S]\n"
+                         "               [--board N]\n";
+            return 1;
+        }
+    }
+    if(!isBoardSize(opt.boardSize)){ std::cerr << "board size must be 8, 10 or 12\n"; return 1; }
+    rlimit rl;
+    if(getrlimit(RLIMIT_NOFILE, &rl) == 0 && rl.rlim_cur < rl.rlim_max){
+        rl.rlim_cur = rl.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &rl);
+    }
+
+    return withGeometry(opt.boardSize, [&](auto g){
+        LoadGen<decltype(g)> gen(opt);
+        std::string err;
+        if(!gen.connectAll(err)){ std::cerr << err << "\n"; return 1; }
+        return gen.run() ? 0 : 1;
+    });
+}
@@ -6,290 +6,430 @@
 #include <vector>
 #include <chrono>
 #include <string>
-#include <map>
-#include <sstream>
-#include <cctype>
+#include <cstdlib>
+#include <thread>
+#include <algorithm>
+#include "position.h"
+#include "history.h"
+#include "search.h"
+#include "engine_thread.h"
+#include "tablebase.h"
+#include "gamerecord.h"
+#include "assets.h"
+#include "hud.h"
+#include "attacks.h"
+#include "input_replay.h"
 
 const int CELL = 64;
-const int ROWS = 8;
-const int COLS = 8;
-const int WINDOW_W = COLS * CELL;
-const int WINDOW_H = ROWS * CELL;
-
-enum PieceType { KING, QUEEN, ROOK, BISHOP, KNIGHT, PAWN };
-
-struct Piece {
-    bool isWhite;
-    PieceType type;
-    int row, col;
-    SDL_Texture* texture;
-    bool hasMoved = false;          
-    bool enPassantVulnerable = false; 
-};
-
-// --- プロトタイプ宣言 ---
-std::vector<std::pair<int,int>> getLegalMoves(Piece* board[ROWS][COLS], Piece* piece, std::pair<int,int> lastMove = {-1,-1});
-SDL_Texture* loadTexture(SDL_Renderer* ren, const std::string& path);
-std::string serializeBoard(Piece* board[ROWS][COLS], bool whiteTurn);
-void flipOthello(Piece* board[ROWS][COLS], int row, int col,
-                    std::map<std::string,SDL_Texture*>& textures,
-                    bool& gameOver, bool& winnerIsWhite);
-
-Mix_Chunk* moveSound = Mix_LoadWAV("./sound/move.mp3");
-Mix_Chunk* captureSound = Mix_LoadWAV("./sound/capture.mp3");
-Mix_Chunk* gameOverSound = Mix_LoadWAV("./sound/gameover.mp3");
-Mix_Chunk* flipSound = Mix_LoadWAV("./sound/flip.mp3");
 
-int main(int argc, char* argv[]) {
+// 盤の大きさ（--board）ごとに実体化する本体。ウィンドウは盤に合わせて広げる
+template<class G>
+static int runGame(int argc, char* argv[], StartupTimer& startup) {
+    typedef BasicPosition<G> Position;
+    typedef BasicMoveList<G> MoveList;
+    typedef BasicUndo<G> Undo;
+    const int WINDOW_W = G::COLS * CELL;
+    const int WINDOW_H = G::ROWS * CELL;
     bool gameOver = false;
     bool winnerIsWhite = false;
-    int halfMoveClock = 0; 
-    std::vector<std::string> boardHistory;
+    bool isDraw = false;
+    GameHistory history;
+
+    // --- コマンドライン: --ai white|black|both, --movetime ミリ秒, --threads 数,
+    //     --vsync, --fps 上限（0 = 無制限）, --book 対局データベース, --tb 終盤テーブルベースのディレクトリ,
+    //     --engine ab|mcts, --playouts MCTS のプレイアウト数（指定すると持ち時間より優先）,
+    //     --record 入力の記録先, --replay 記録ファイル, --replay-speed 倍率（0 = 待たずに流す）,
+    //     --bench-csv フレーム・手ごとの計測の書き出し先, --headless ダミーの映像・音声ドライバ,
+    //     --board 盤の一辺 8 / 10 / 12（main で読む。定跡とテーブルベースは 8x8 だけ） ---
+    bool aiPlays[2] = { false, false };
+    SearchLimits aiLimits;
+    aiLimits.threads = std::max(1u, std::thread::hardware_concurrency());
+    bool vsync = false;
+    int fpsCap = 60;
+    std::string bookPath, tbDir;
+    std::string recordPath, replayPath, benchPath;
+    double replaySpeed = 1;
+    bool headless = false;
+    uint64_t playouts = 0;
+    for(int i=1;i<argc;i++){
+        std::string arg = argv[i];
+        if(arg=="--ai" && i+1<argc){
+            std::string side = argv[++i];
+            aiPlays[WHITE] = side=="white" || side=="both";
+            aiPlays[BLACK] = side=="black" || side=="both";
+        } else if(arg=="--movetime" && i+1<argc){
+            aiLimits.timeMs = std::atoi(argv[++i]);
+        } else if(arg=="--threads" && i+1<argc){
+            aiLimits.threads = std::max(1, std::atoi(argv[++i]));
+        } else if(arg=="--vsync"){
+            vsync = true;
+        } else if(arg=="--fps" && i+1<argc){
+            fpsCap = std::max(0, std::atoi(argv[++i]));
+        } else if(arg=="--book" && i+1<argc){
+            bookPath = argv[++i];
+        } else if(arg=="--tb" && i+1<argc){
+            tbDir = argv[++i];
+        } else if(arg=="--engine" && i+1<argc){
+            aiLimits.engine = std::string(argv[++i])=="mcts" ? ENGINE_MCTS : ENGINE_ALPHABETA;
+        } else if(arg=="--playouts" && i+1<argc){
+            playouts = std::strtoull(argv[++i], nullptr, 10);
+        } else if(arg=="--record" && i+1<argc){
+            recordPath = argv[++i];
+        } else if(arg=="--replay" && i+1<argc){
+            replayPath = argv[++i];
+        } else if(arg=="--replay-speed" && i+1<argc){
+            replaySpeed = std::atof(argv[++i]);
+        } else if(arg=="--bench-csv" && i+1<argc){
+            benchPath = argv[++i];
+        } else if(arg=="--headless"){
+            headless = true;
+        } else if(arg=="--board" && i+1<argc){
+            i++;
+        }
+    }
+    if(G::ROWS != 8 && (!bookPath.empty() || !tbDir.empty()))
+        std::cerr << "--book and --tb are only used on the 8x8 board" << std::endl;
+    // --playouts は MCTS だけに効く（アルファベータを節点数で黙って打ち切らない）
+    if(playouts){
+        if(aiLimits.engine == ENGINE_MCTS){ aiLimits.maxNodes = playouts; aiLimits.timeMs = 0; }
+        else std::cerr << "--playouts is ignored without --engine mcts" << std::endl;
+    }
+    // 記録・再生中は先読みしない（先読みの量は時刻しだいで、次の探索の置換表が変わる）。
+    // 同じ手を指すのは MCTS をプレイアウト数・1スレッドで回すときだけ
+    bool replayMode = !recordPath.empty() || !replayPath.empty();
+    if(replayMode && (aiPlays[WHITE] || aiPlays[BLACK])
+       && (aiLimits.engine != ENGINE_MCTS || !aiLimits.maxNodes || aiLimits.threads != 1))
+        std::cerr << "AI moves are reproducible on replay only with --engine mcts --threads 1 --playouts N" << std::endl;
+    InputRecorder recorder;
+    InputReplay replay;
+    BenchLog bench;
+    std::string ioError;
+    if(!replayPath.empty() && !replay.load(replayPath, ioError)){
+        std::cerr << ioError << std::endl;
+        return 1;
+    }
+    if(!benchPath.empty()){
+        if(!bench.open(benchPath, ioError)){ std::cerr << ioError << std::endl; return 1; }
+        countSdlAllocations();
+    }
+    // 画面も音も出さずに回す（無人のベンチマーク用）。環境変数で指定済みならそちらを使う
+    if(headless){
+        SDL_setenv("SDL_VIDEODRIVER", "dummy", 0);
+        SDL_setenv("SDL_AUDIODRIVER", "dummy", 0);
+    }
+    GameDb book;
+    std::string bookError;
+    if(!bookPath.empty() && !book.open(bookPath, &bookError)) std::cerr << bookError << std::endl;
+    Tablebases tablebases;
+    if(!tbDir.empty()){
+        std::string tbError;
+        if(tablebases.open(tbDir, &tbError) == 0) std::cerr << (tbError.empty() ? "no tables in " + tbDir : tbError) << std::endl;
+        else aiLimits.tablebases = &tablebases;
+    }
+    BasicAsyncEngine<G> engine(64);
+    if(book.isOpen()) engine.setBook(&book);
+    uint64_t searchId = 0;      // 結果待ちの探索要求（0 = なし）
 
-    if (SDL_Init(SDL_INIT_VIDEO) < 0) {
+    if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO) < 0) {
         std::cout << "SDL could not initialize! SDL_Error: " << SDL_GetError() << std::endl;
         return 1;
     }
-
-    SDL_Init(SDL_INIT_VIDEO);
     TTF_Init();
     IMG_Init(IMG_INIT_PNG);
-    Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, 2, 2048);
-
-    // --- BGM読み込み ---
-    Mix_Music* bgm = Mix_LoadMUS("./sound/bgm.mp3");
-    if(!bgm){
-        std::cerr << "Failed to load BGM: " << Mix_GetError() << std::endl;
-    }
-    Mix_PlayMusic(bgm, -1); // -1 でループ再生
+    startup.mark("sdl init");
 
     SDL_Window* win = SDL_CreateWindow("Chess+Othello=Ochello",
         SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
         WINDOW_W, WINDOW_H, SDL_WINDOW_SHOWN);
-    SDL_Renderer* ren = SDL_CreateRenderer(win, -1, SDL_RENDERER_ACCELERATED);
+    SDL_Renderer* ren = SDL_CreateRenderer(win, -1,
+        SDL_RENDERER_ACCELERATED | (vsync ? SDL_RENDERER_PRESENTVSYNC : 0));
+    if(!ren) ren = SDL_CreateRenderer(win, -1, SDL_RENDERER_SOFTWARE);   // ダミードライバなど
     TTF_Font* font = TTF_OpenFont("C:/Windows/Fonts/consola.ttf", 32);
+    TTF_Font* hudFont = TTF_OpenFont("C:/Windows/Fonts/consola.ttf", 14);
+    startup.mark("window");
+    if(!recordPath.empty() && replayPath.empty() && !recorder.open(recordPath, ioError)) std::cerr << ioError << std::endl;
+
+    // 素材が届く前に一度画面を出しておく
+    SDL_SetRenderDrawColor(ren, 0, 0, 0, 255);
+    SDL_RenderClear(ren);
+    SDL_RenderPresent(ren);
+    startup.mark("first frame");
+
+    bool audio = Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, 2, 2048) == 0;
+    if(!audio) std::cerr << "Failed to open audio: " << Mix_GetError() << std::endl;
+    startup.mark("audio open");
+
+    // --- 素材読み込み（画像・効果音はスレッドプールで並列にデコード） ---
+    GameAssets assets;
+    SoundBank& sounds = assets.sounds;
+    AssetLoader loader(ren, assets, startup);
+    loader.start(CELL * 2, WINDOW_W, WINDOW_H, audio, SDL_RegisterEvents(1));
+
+    Position pos;
+    setStartPosition(pos);
+    history.reset(pos);
+
+    // --- 待った／やり直し ---
+    // 指した手の戻し記録と、待ったで戻した手（やり直し用）。最初に確保しておく
+    std::vector<Undo> undoStack;
+    std::vector<Move> redoMoves;
+    undoStack.reserve(1024);
+    redoMoves.reserve(1024);
 
-    Piece* board[ROWS][COLS] = {};
-
-    // --- 画像読み込み ---
-    std::map<std::string, SDL_Texture*> textures;
-    std::string base = "./img/";
-    std::string colors[2] = { "WHITE", "BLACK" };
-    std::string names[6] = { "KING","QUEEN","ROOK","BISHOP","KNIGHT","PAWN" };
-    for(int c=0;c<2;++c)
-        for(int t=0;t<6;++t){
-            std::string path = base + colors[c] + "_" + names[t] + ".png";
-            textures[colors[c]+"_"+names[t]] = loadTexture(ren,path);
-        }
+    int selectedRow=-1,selectedCol=-1;
+    MoveList legalMoves;
+    auto turnStartTime = std::chrono::steady_clock::now();
 
-    // --- 効果音読み込み ---
-    moveSound     = Mix_LoadWAV("./sound/move.mp3");
-    captureSound  = Mix_LoadWAV("./sound/capture.mp3");
-    gameOverSound = Mix_LoadWAV("./sound/gameover.mp3");
-    flipSound     = Mix_LoadWAV("./sound/flip.mp3");
-    if(!moveSound || !captureSound || !gameOverSound){
-        std::cerr << "Failed to load sound: " << Mix_GetError() << std::endl;
-    }
+    // 選択した駒の手だけを取り出す
+    auto selectMoves = [&](int sq){
+        MoveList all;
+        generateMoves(pos, all);
+        legalMoves.size = 0;
+        for(Move m : all) if(moveFrom(m) == sq) legalMoves.push(m);
+    };
 
-    // --- 駒の配置と対応付け ---
-    auto place = [&](int r,int c,bool white,PieceType t){
-        std::string color = white ? "WHITE" : "BLACK";
-        std::string name;
-        switch(t){ case KING:name="KING";break;
-                    case QUEEN:name="QUEEN";break;
-                    case ROOK:name="ROOK";break;
-                    case BISHOP:name="BISHOP";break;
-                    case KNIGHT:name="KNIGHT";break;
-                    case PAWN:name="PAWN";break;
+    // --- AI に考えさせる ---
+    // 前の探索は止めてから、AI の手番なら本探索、人間の手番なら相手の手を先読みする
+    auto startEngine = [&](){
+        engine.cancel();
+        searchId = 0;
+        if(gameOver) return;
+        if(aiPlays[pos.sideToMove]) searchId = engine.search(pos,history,aiLimits);
+        else if(aiPlays[pos.sideToMove^1] && !replayMode) engine.ponder(pos,history,aiLimits);
+    };
+
+    // 手を指して勝敗判定・効果音まで行う（人間・AI・やり直し共通）
+    auto applyMove = [&](Move mv){
+        BenchMark moveStart = BenchMark::now();
+        undoStack.emplace_back();
+        Undo& info = undoStack.back();
+        int mover = pos.sideToMove;
+        makeMove(pos,mv,info);
+        history.push(pos);
+
+        // --- キングを取った／反転させたら勝ち、千日手・50手ルールは引き分け ---
+        Termination term = terminationAfter(pos,history,info);
+        if(term!=TERM_NONE){
+            gameOver = true;
+            isDraw = resultOf(term,mover)==RESULT_DRAW;
+            winnerIsWhite = mover==WHITE;
         }
-        board[r][c] = new Piece{white,t,r,c,textures[color+"_"+name]};
+
+        // --- 効果音再生 ---
+        if (gameOver) {
+            Mix_HaltMusic();
+            Mix_PlayChannel(-1, sounds.gameOver, 0);
+        } else if (info.captured!=NO_PIECE) {
+            Mix_PlayChannel(-1, sounds.capture, 0);
+        } else {
+            Mix_PlayChannel(-1, sounds.move, 0);
+        }
+        // 反転が発生した場合のみ効果音を鳴らす
+        if (info.flips && !gameOver) {
+            Mix_PlayChannel(-1, sounds.flip, 0);
+        }
+
+        turnStartTime = std::chrono::steady_clock::now();
+        startEngine();
+        bench.move<G>(moveStart, mv);
     };
 
-    // --- 初期配置 ---
-    place(7,0,true,ROOK); place(7,7,true,ROOK);
-    place(7,1,true,KNIGHT); place(7,6,true,KNIGHT);
-    place(7,2,true,BISHOP); place(7,5,true,BISHOP);
-    place(7,3,true,QUEEN); place(7,4,true,KING);
-    for(int i=0;i<8;i++) place(6,i,true,PAWN);
+    // 新しい手を指したらやり直しの手は捨てる
+    auto playMove = [&](Move mv){
+        redoMoves.clear();
+        applyMove(mv);
+    };
 
-    place(0,0,false,ROOK); place(0,7,false,ROOK);
-    place(0,1,false,KNIGHT); place(0,6,false,KNIGHT);
-    place(0,2,false,BISHOP); place(0,5,false,BISHOP);
-    place(0,3,false,QUEEN); place(0,4,false,KING);
-    for(int i=0;i<8;i++) place(1,i,false,PAWN);
+    // AI が片方だけを持っているときは、人間の手番まで戻す／進める
+    auto humanTurn = [&](){ return !aiPlays[pos.sideToMove] || aiPlays[pos.sideToMove^1]; };
+
+    auto undoMove = [&](){
+        if(undoStack.empty()) return;
+        engine.cancel();
+        do {
+            unmakeMove(pos,undoStack.back());
+            redoMoves.push_back(undoStack.back().move);
+            undoStack.pop_back();
+            history.pop();
+        } while(!undoStack.empty() && !humanTurn());
+        if(gameOver) Mix_PlayMusic(sounds.bgm, -1);
+        gameOver = isDraw = false;
+        selectedRow = selectedCol = -1;
+        legalMoves.size = 0;
+        turnStartTime = std::chrono::steady_clock::now();
+        startEngine();
+    };
 
-    int selectedRow=-1,selectedCol=-1;
-    std::vector<std::pair<int,int>> legalMoves;
-    bool isWhiteTurn=true;
-    auto turnStartTime = std::chrono::steady_clock::now();
-    std::pair<int,int> lastMove = {-1,-1};
+    auto redoMove = [&](){
+        if(redoMoves.empty()) return;
+        selectedRow = selectedCol = -1;
+        legalMoves.size = 0;
+        do {
+            applyMove(redoMoves.back());
+            redoMoves.pop_back();
+        } while(!redoMoves.empty() && !gameOver && !humanTurn());
+    };
 
-    bool title = true;
-    bool tutorial = true;
-    bool running = true;
+    // --- タイトル → チュートリアル ---
+    // 届いた素材を反映する。BGM は届いた時点で鳴らし始める。
+    // 再生中は時刻が来た入力もここで積む（AI の返事待ちの間は積まない）
+    auto pumpAssets = [&](){
+        if(!replayPath.empty()) replay.pump(searchId == 0);
+        unsigned arrived = loader.pump();
+        if((arrived & (1u << ASSET_BGM)) && !gameOver) Mix_PlayMusic(sounds.bgm, -1);   // -1 でループ再生
+        return arrived != 0;
+    };
+    auto clickScene = [&](SceneId id){
+        if(!runScene(ren, assets.scenes, id, pumpAssets)) return false;
+        Mix_PlayChannel(-1, sounds.move, 0);
+        return true;
+    };
+    if(!replayPath.empty()) replay.start(replaySpeed);
+    bool running = clickScene(SCENE_TITLE) && clickScene(SCENE_TUTORIAL);
     SDL_Event e;
 
-    while(title){
-        while(SDL_PollEvent(&e)){
-            if(e.type==SDL_MOUSEBUTTONDOWN && e.button.button==SDL_BUTTON_LEFT){
-                Mix_PlayChannel(-1, moveSound, 0);
-                title = false;
-            }
-            SDL_RenderClear(ren);
-            SDL_Surface* s = IMG_Load("./img/title.png");
-            SDL_Texture* t = SDL_CreateTextureFromSurface(ren, s);
-            SDL_FreeSurface(s);
-            SDL_RenderCopy(ren, t, nullptr, nullptr);
-            SDL_RenderPresent(ren);
-            SDL_DestroyTexture(t);
+    // --- 描画ループ ---
+    // 盤面・選択・ウィンドウに変化があったとき（dirty）だけ描き直し、それ以外は
+    // イベント待ちで眠る。AI の結果はワーカーからユーザーイベントで起こしてもらう。
+    Uint32 engineEvent = SDL_RegisterEvents(1);
+    engine.setReplyCallback([engineEvent](){
+        SDL_Event ev{};
+        ev.type = engineEvent;
+        SDL_PushEvent(&ev);
+    });
+
+    bool dirty = true;
+    bool showHud = false;
+    bool bannerShown = false;            // 前のフレームでターン表示を出したか
+    TextLabel bannerLabel, hudLabel;
+    FrameStats frameStats;
+    const auto frameInterval = std::chrono::microseconds(fpsCap > 0 ? 1000000 / fpsCap : 0);
+    // HUD だけのための描き直しは fps 上限が無くてもディスプレイのリフレッシュレートまで
+    // （分からなければ 60Hz）に抑える。でないと --fps 0 で F3 を押すと待たずに回り続ける
+    SDL_DisplayMode mode{};
+    int refreshHz = SDL_GetCurrentDisplayMode(std::max(0, SDL_GetWindowDisplayIndex(win)), &mode) == 0
+                    && mode.refresh_rate > 0 ? mode.refresh_rate : 60;
+    const auto hudInterval = std::max(frameInterval, std::chrono::microseconds(1000000 / refreshHz));
+    auto lastFrame = std::chrono::steady_clock::now() - frameInterval;
+    const auto bannerTime = std::chrono::seconds(3);
+
+    auto handleEvent = [&](const SDL_Event& e){
+        if(e.type==SDL_MOUSEMOTION || e.type==engineEvent) return;   // AI の手は下で dirty にする
+        dirty = true;
+        if(e.type==SDL_QUIT) running=false;
+        else if(e.type==SDL_KEYDOWN && e.key.keysym.sym==SDLK_F3) showHud = !showHud;
+        else if(e.type==SDL_KEYDOWN && (e.key.keysym.mod & KMOD_CTRL)){
+            // Ctrl+Z で待った、Ctrl+Y（または Ctrl+Shift+Z）でやり直し
+            bool shift = (e.key.keysym.mod & KMOD_SHIFT)!=0;
+            if(e.key.keysym.sym==SDLK_z && !shift) undoMove();
+            else if(e.key.keysym.sym==SDLK_y || (e.key.keysym.sym==SDLK_z && shift)) redoMove();
         }
-    }
+        else if(e.type==SDL_MOUSEBUTTONDOWN && e.button.button==SDL_BUTTON_LEFT
+                && !aiPlays[pos.sideToMove]){
+            int col = e.button.x / CELL;
+            int row = e.button.y / CELL;
+
+            int sq = G::sqOf(row,col);
+
+            if(selectedRow==-1){
+                if(pos.colorAt(sq)==pos.sideToMove){
+                    selectedRow=row; selectedCol=col;
+                    selectMoves(sq);
+                }
+            } else {
+                bool moved=false;
+                for(Move mv:legalMoves){
+                    if(moveTo(mv)==sq){
+                        playMove(mv);
+                        moved=true;
+                        break;
+                    }
+                }
 
-    while(tutorial){
-        while(SDL_PollEvent(&e)){
-            if(e.type==SDL_MOUSEBUTTONDOWN && e.button.button==SDL_BUTTON_LEFT){
-                Mix_PlayChannel(-1, moveSound, 0);
-                tutorial = false;
+                selectedRow=selectedCol=-1;
+                legalMoves.size=0;
+                if(!moved && pos.colorAt(sq)==pos.sideToMove)
+                    selectMoves(sq),
+                    selectedRow=row,selectedCol=col;
             }
-            SDL_RenderClear(ren);
-            SDL_Surface* s = IMG_Load("./img/tutorial.png");
-            SDL_Texture* t = SDL_CreateTextureFromSurface(ren, s);
-            SDL_FreeSurface(s);
-            SDL_RenderCopy(ren, t, nullptr, nullptr);
-            SDL_RenderPresent(ren);
-            SDL_DestroyTexture(t);
         }
-    }
+    };
 
+    startEngine();
     while(running){
-        while(SDL_PollEvent(&e)){
-            if(e.type==SDL_QUIT) running=false;
-            else if(e.type==SDL_MOUSEBUTTONDOWN && e.button.button==SDL_BUTTON_LEFT){
-                int col = e.button.x / CELL;
-                int row = e.button.y / CELL;
-
-                if(selectedRow==-1){
-                    if(board[row][col] && board[row][col]->isWhite==isWhiteTurn){
-                        selectedRow=row; selectedCol=col;
-                        legalMoves=getLegalMoves(board,board[row][col],lastMove);
-                    }
-                } else {
-                    bool moved=false;
-                    Piece* backup = nullptr;
-                    for(auto& mv:legalMoves){
-                        if(mv.first==row && mv.second==col){
-                            Piece* p = board[selectedRow][selectedCol];
-                            backup = board[row][col];
-                            
-                            // --- アンパッサン処理 ---
-                            if(p->type==PAWN && board[row][col]==nullptr && selectedCol!=col){
-                                int capRow = p->isWhite ? row+1 : row-1;
-                                delete board[capRow][col]; board[capRow][col]=nullptr;
-                            }
-
-                            // --- 移動実行 ---
-                            board[row][col]=p; board[selectedRow][selectedCol]=nullptr;
-                            int oldRow = p->row, oldCol = p->col;
-                            p->row=row; p->col=col;
-
-                            // --- 捕獲対象がキングならゲーム終了 ---
-                            if(backup && backup->type == KING){
-                                gameOver = true;
-                                winnerIsWhite = p->isWhite;
-                            }
-
-                            // --- キャスリング ---
-                            if(p->type==KING && abs(col-oldCol)==2){
-                                if(col>oldCol){
-                                    Piece* rook = board[row][7];
-                                    board[row][5]=rook; board[row][7]=nullptr;
-                                    rook->col=5; rook->hasMoved=true;
-                                } else {
-                                    Piece* rook = board[row][0];
-                                    board[row][3]=rook; board[row][0]=nullptr;
-                                    rook->col=3; rook->hasMoved=true;
-                                }
-                            }
-
-                            // --- ポーンプロモーション ---
-                            if(p->type==PAWN && (row==0 || row==7)){
-                                delete p;
-                                board[row][col]=new Piece{isWhiteTurn,QUEEN,row,col,textures[std::string(isWhiteTurn?"WHITE":"BLACK")+"_QUEEN"],true};
-                                p = board[row][col];
-                            }
-
-                            if(backup || p->type==PAWN) halfMoveClock=0;
-                            else halfMoveClock++;
-
-                            delete backup;
-                            moved=true;
-                            lastMove={oldRow,oldCol};
-                            p->hasMoved=true;
-
-                            // --- オセロ反転 ---
-                            flipOthello(board,row,col,textures, gameOver, winnerIsWhite);
-
-                            break;
-                        }
-                    }
+        // --- 次に起きる時刻を決めて眠る ---
+        // 描き直しが必要なら fps 上限まで、HUD だけなら hudInterval まで待ち、
+        // そうでなければターン表示が消える時刻まで
+        auto now = std::chrono::steady_clock::now();
+        std::chrono::steady_clock::time_point wakeAt = std::chrono::steady_clock::time_point::max();
+        if(dirty) wakeAt = lastFrame + frameInterval;
+        else if(showHud) wakeAt = lastFrame + hudInterval;
+        else if(bannerShown) wakeAt = turnStartTime + bannerTime;
+        int timeoutMs = -1;
+        if(wakeAt != std::chrono::steady_clock::time_point::max())
+            timeoutMs = (int)std::max<int64_t>(0,
+                std::chrono::duration_cast<std::chrono::milliseconds>(wakeAt - now).count());
+        if(!replayPath.empty()){
+            int replayMs = replay.msUntilNext(searchId == 0);
+            if(replayMs >= 0 && (timeoutMs < 0 || replayMs < timeoutMs)) timeoutMs = replayMs;
+        }
+        bool got = timeoutMs < 0 ? SDL_WaitEvent(&e) : SDL_WaitEventTimeout(&e, timeoutMs);
+        if(got) do { handleEvent(e); } while(SDL_PollEvent(&e));
+        if(pumpAssets()) dirty = true;
+
+        // --- AI の結果を受け取る（探索は別スレッドなので描画は止まらない） ---
+        EngineReply reply;
+        while(engine.poll(reply)){
+            if(reply.ponder || reply.cancelled || reply.id!=searchId) continue;
+            searchId = 0;
+            if(reply.key==pos.key && reply.result.best){ playMove(reply.result.best); dirty = true; }
+        }
 
-                    if(moved){
-                        // --- 効果音再生 ---
-                        if (gameOver) {
-                            Mix_HaltMusic();
-                            Mix_PlayChannel(-1, gameOverSound, 0);
-                        } else if (backup) {
-                            Mix_PlayChannel(-1, captureSound, 0);
-                        } else {
-                            Mix_PlayChannel(-1, moveSound, 0);
-                        }
-
-                        isWhiteTurn=!isWhiteTurn;
-                        turnStartTime = std::chrono::steady_clock::now();
-                        std::string serialized = serializeBoard(board,isWhiteTurn);
-                        boardHistory.push_back(serialized);
-                    }
+        now = std::chrono::steady_clock::now();
+        bool banner = !gameOver && now - turnStartTime < bannerTime;
+        if(banner != bannerShown) dirty = true;
+        if(!running || !(dirty || showHud) || now < lastFrame + (dirty ? frameInterval : hudInterval)) continue;
 
-                    selectedRow=selectedCol=-1;
-                    legalMoves.clear();
-                    if(!moved && board[row][col] && board[row][col]->isWhite==isWhiteTurn)
-                        legalMoves=getLegalMoves(board,board[row][col],lastMove),
-                        selectedRow=row,selectedCol=col;
-                }
-            }
-        }
+        auto frameStart = std::chrono::steady_clock::now();
+        BenchMark benchStart = BenchMark::now();
+        int drawCalls = 0;
+        dirty = false;
+        bannerShown = banner;
 
         // --- 背景描画 ---
+        bool isWhiteTurn = pos.sideToMove==WHITE;
         SDL_Color lightCell,darkCell;
         if(isWhiteTurn){ lightCell={200,255,200}; darkCell={100,200,100}; }
         else{ lightCell={80,120,80}; darkCell={40,80,40}; }
 
-        for(int r=0;r<ROWS;r++) for(int c=0;c<COLS;c++){
-            bool light=(r+c)%2==0;
-            SDL_SetRenderDrawColor(ren,
-                light?lightCell.r:darkCell.r,
-                light?lightCell.g:darkCell.g,
-                light?lightCell.b:darkCell.b,
-                255);
-            SDL_Rect cell={c*CELL,r*CELL,CELL,CELL};
-            SDL_RenderFillRect(ren,&cell);
+        // 明るいマスと暗いマスをそれぞれ1回で塗る
+        SDL_Rect cells[2][G::SQUARES/2];
+        int cellCount[2]={0,0};
+        for(int r=0;r<G::ROWS;r++) for(int c=0;c<G::COLS;c++){
+            int dark=(r+c)%2;
+            cells[dark][cellCount[dark]++]={c*CELL,r*CELL,CELL,CELL};
         }
+        SDL_SetRenderDrawColor(ren,lightCell.r,lightCell.g,lightCell.b,255);
+        SDL_RenderFillRects(ren,cells[0],cellCount[0]);
+        SDL_SetRenderDrawColor(ren,darkCell.r,darkCell.g,darkCell.b,255);
+        SDL_RenderFillRects(ren,cells[1],cellCount[1]);
+        drawCalls += 2;
 
         // --- 移動可能マス ---
-        SDL_SetRenderDrawBlendMode(ren,SDL_BLENDMODE_BLEND);
-        for(auto& mv:legalMoves){
+        if(legalMoves.size){
+            SDL_Rect targets[G::SQUARES];
+            int n=0;
+            for(Move mv:legalMoves)
+                targets[n++]={G::colOf(moveTo(mv))*CELL,G::rowOf(moveTo(mv))*CELL,CELL,CELL};
+            SDL_SetRenderDrawBlendMode(ren,SDL_BLENDMODE_BLEND);
             SDL_SetRenderDrawColor(ren,0,200,255,120);
-            SDL_Rect rect={mv.second*CELL,mv.first*CELL,CELL,CELL};
-            SDL_RenderFillRect(ren,&rect);
+            SDL_RenderFillRects(ren,targets,n);
+            SDL_SetRenderDrawBlendMode(ren,SDL_BLENDMODE_NONE);
+            drawCalls++;
         }
-        SDL_SetRenderDrawBlendMode(ren,SDL_BLENDMODE_NONE);
 
         // --- 駒描画 ---
-        for(int r=0;r<ROWS;r++) for(int c=0;c<COLS;c++)
-            if(board[r][c] && board[r][c]->texture){
-                SDL_Rect rect={c*CELL,r*CELL,CELL,CELL};
-                SDL_RenderCopy(ren,board[r][c]->texture,nullptr,&rect);
-            }
+        drawCalls += drawPieces(ren,assets.atlas,pos,CELL);
 
         // --- 選択中マス ---
         if(selectedRow>=0 && selectedCol>=0){
@@ -298,242 +438,61 @@ int main(int argc, char* argv[]) {
             SDL_Rect rect={selectedCol*CELL,selectedRow*CELL,CELL,CELL};
             SDL_RenderFillRect(ren,&rect);
             SDL_SetRenderDrawBlendMode(ren,SDL_BLENDMODE_NONE);
+            drawCalls++;
         }
 
-        // --- 勝者・ターン表示 ---
-        auto now = std::chrono::steady_clock::now();
-        auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(now-turnStartTime).count();
-        if(gameOver){
-            SDL_Color winColor={255,50,50,255};
-            const char* text = "Game Over!";
-            SDL_Surface* surf=TTF_RenderText_Solid(font,text,winColor);
-            SDL_Texture* tex=SDL_CreateTextureFromSurface(ren,surf);
-            SDL_Rect rect={WINDOW_W/2-150,WINDOW_H/2-20,surf->w,surf->h};
-            SDL_RenderCopy(ren,tex,nullptr,&rect);
-            SDL_FreeSurface(surf); SDL_DestroyTexture(tex);
-        } else if(elapsed<3){
-            SDL_Color textColor=isWhiteTurn?SDL_Color{0,0,0,255}:SDL_Color{255,255,255,255};
-            const char* turnText=isWhiteTurn?"White's Turn":"Black's Turn";
-            SDL_Surface* surf=TTF_RenderText_Solid(font,turnText,textColor);
-            SDL_Texture* tex=SDL_CreateTextureFromSurface(ren,surf);
-            SDL_Rect rect={WINDOW_W/2-80,WINDOW_H/2-20,surf->w,surf->h};
-            SDL_RenderCopy(ren,tex,nullptr,&rect);
-            SDL_FreeSurface(surf); SDL_DestroyTexture(tex);
+        // --- 勝者・ターン表示（文字列が変わったときだけ作り直す） ---
+        if(gameOver || banner){
+            if(gameOver)
+                setLabel(ren,font,bannerLabel,isDraw ? "Draw!" : "Game Over!",SDL_Color{255,50,50,255});
+            else
+                setLabel(ren,font,bannerLabel,isWhiteTurn ? "White's Turn" : "Black's Turn",
+                         isWhiteTurn ? SDL_Color{0,0,0,255} : SDL_Color{255,255,255,255});
+            if(bannerLabel.texture){
+                SDL_Rect rect={(WINDOW_W-bannerLabel.w)/2,WINDOW_H/2-20,bannerLabel.w,bannerLabel.h};
+                SDL_RenderCopy(ren,bannerLabel.texture,nullptr,&rect);
+                drawCalls++;
+            }
         }
 
+        // --- F3: フレーム時間のオーバーレイ ---
+        if(showHud) drawCalls += drawHud(ren,hudFont,hudLabel,frameStats);
+
         SDL_RenderPresent(ren);
+        lastFrame = std::chrono::steady_clock::now();
+        frameStats.record(std::chrono::duration<double, std::milli>(lastFrame - frameStart).count(), drawCalls);
+        bench.frame(benchStart, drawCalls);
     }
+    engine.cancel();
+    recorder.close();
+    bench.close();
 
     // --- 後処理 ---
-    for(int r=0;r<ROWS;r++) for(int c=0;c<COLS;c++) delete board[r][c];
-    for(auto& kv:textures) SDL_DestroyTexture(kv.second);
+    loader.stop();
+    destroyGameAssets(assets);
+    destroyLabel(bannerLabel);
+    destroyLabel(hudLabel);
     TTF_CloseFont(font);
+    TTF_CloseFont(hudFont);
     SDL_DestroyRenderer(ren);
     SDL_DestroyWindow(win);
     IMG_Quit();
     TTF_Quit();
-    Mix_FreeChunk(moveSound);
-    Mix_FreeChunk(captureSound);
-    Mix_FreeChunk(gameOverSound);
-    Mix_FreeChunk(flipSound);
-    Mix_FreeMusic(bgm);
     Mix_CloseAudio();
     SDL_Quit();
     return 0;
 }
 
-// --- 画像ロード ---
-SDL_Texture* loadTexture(SDL_Renderer* ren,const std::string& path){
-    SDL_Surface* surf = IMG_Load(path.c_str());
-    if(!surf){ std::cerr<<"Failed to load "<<path<<": "<<IMG_GetError()<<"\n"; return nullptr;}
-    SDL_Texture* tex = SDL_CreateTextureFromSurface(ren,surf);
-    SDL_FreeSurface(surf);
-    return tex;
-}
-
-// --- オセロ反転処理（キング挟みで勝利判定） ---
-void flipOthello(Piece* board[ROWS][COLS], int row, int col,
-                    std::map<std::string,SDL_Texture*>& textures,
-                    bool& gameOver, bool& winnerIsWhite) {
-    bool color = board[row][col]->isWhite;
-    int dir[8][2] = {{-1,-1},{-1,0},{-1,1},{0,-1},{0,1},{1,-1},{1,0},{1,1}};
-    bool flippedAny = false;  // ← 反転が起きたかどうか
-
-    for(auto& d:dir){
-        std::vector<Piece*> toFlip;
-        int r = row + d[0], c = col + d[1];
-
-        // 間の駒を一時的に格納
-        while(r>=0 && r<ROWS && c>=0 && c<COLS && board[r][c]){
-            if(board[r][c]->isWhite == color){
-                // 同色の駒にぶつかった場合、間の駒をすべて反転
-                if(!toFlip.empty()){
-                    flippedAny = true;  // ← 反転あり
-                    for(auto p: toFlip){
-                        // KINGが反転した場合はゲーム終了
-                        if(p->type == KING){
-                            gameOver = true;
-                            winnerIsWhite = color; // 移動した側の勝利
-                            Mix_HaltMusic();
-                            Mix_PlayChannel(-1, gameOverSound, 0);
-                        }
-
-                        p->isWhite = color;
-
-                        // テクスチャ更新
-                        std::string tname = (color ? "WHITE" : "BLACK");
-                        switch(p->type){
-                            case KING:   p->texture = textures[tname+"_KING"]; break;
-                            case QUEEN:  p->texture = textures[tname+"_QUEEN"]; break;
-                            case ROOK:   p->texture = textures[tname+"_ROOK"]; break;
-                            case BISHOP: p->texture = textures[tname+"_BISHOP"]; break;
-                            case KNIGHT: p->texture = textures[tname+"_KNIGHT"]; break;
-                            case PAWN:   p->texture = textures[tname+"_PAWN"]; break;
-                        }
-                    }
-                }
-                break;
-            } else {
-                toFlip.push_back(board[r][c]);
-            }
-            r += d[0]; c += d[1];
-        }
-    }
-    
-    // 反転が発生した場合のみ効果音を鳴らす
-    if (flippedAny && !gameOver) {
-        Mix_PlayChannel(-1, flipSound, 0);
-    }
-}
-
-
-// --- 駒の合法手 ---
-std::vector<std::pair<int,int>> getLegalMoves(Piece* board[ROWS][COLS], Piece* p,std::pair<int,int> lastMove){
-    std::vector<std::pair<int,int>> moves;
-    int r=p->row, c=p->col;
-    int dir[8][2]={{-1,-1},{-1,0},{-1,1},{0,-1},{0,1},{1,-1},{1,0},{1,1}};
-    auto add=[&](int rr,int cc){
-        if(rr>=0&&rr<ROWS&&cc>=0&&cc<COLS){
-            if(!board[rr][cc]||board[rr][cc]->isWhite!=p->isWhite)
-                moves.push_back({rr,cc});
-        }
-    };
-    switch(p->type){
-        case KING:
-            for(auto& d:dir) add(r+d[0],c+d[1]);
-            if(!p->hasMoved){
-                if(board[r][7] && board[r][7]->type==ROOK && !board[r][7]->hasMoved &&
-                    !board[r][5] && !board[r][6]) moves.push_back({r,6});
-                if(board[r][0] && board[r][0]->type==ROOK && !board[r][0]->hasMoved &&
-                    !board[r][1] && !board[r][2] && !board[r][3]) moves.push_back({r,2});
-            }
-            break;
-        case QUEEN:
-            for (int i = 0; i < 8; ++i) {
-                int dr = dir[i][0], dc = dir[i][1];
-                int nr = r + dr, nc = c + dc;
-                while (nr >= 0 && nr < ROWS && nc >= 0 && nc < COLS) {
-                    if (!board[nr][nc]) moves.push_back({nr, nc});
-                    else {
-                        if (board[nr][nc]->isWhite != p->isWhite)
-                            moves.push_back({nr, nc});
-                        break;
-                    }
-                    nr += dr; nc += dc;
-                }
-            }
-            break;
-
-        case ROOK: {
-            int rookDirs[4] = {1, 3, 4, 6};
-            for (int i : rookDirs) {
-                int dr = dir[i][0], dc = dir[i][1];
-                int nr = r + dr, nc = c + dc;
-                while (nr >= 0 && nr < ROWS && nc >= 0 && nc < COLS) {
-                    if (!board[nr][nc]) moves.push_back({nr, nc});
-                    else {
-                        if (board[nr][nc]->isWhite != p->isWhite)
-                            moves.push_back({nr, nc});
-                        break;
-                    }
-                    nr += dr; nc += dc;
-                }
-            }
-            break;
-        }
-
-        case BISHOP: {
-            int bishopDirs[4] = {0, 2, 5, 7};
-            for (int i : bishopDirs) {
-                int dr = dir[i][0], dc = dir[i][1];
-                int nr = r + dr, nc = c + dc;
-                while (nr >= 0 && nr < ROWS && nc >= 0 && nc < COLS) {
-                    if (!board[nr][nc]) moves.push_back({nr, nc});
-                    else {
-                        if (board[nr][nc]->isWhite != p->isWhite)
-                            moves.push_back({nr, nc});
-                        break;
-                    }
-                    nr += dr; nc += dc;
-                }
-            }
-            break;
-        }
-
-        case KNIGHT:{
-            int jmp[8][2]={{-2,-1},{-2,1},{-1,-2},{-1,2},{1,-2},{1,2},{2,-1},{2,1}};
-            for(auto& jj:jmp) add(r+jj[0],c+jj[1]);
-            break;
-        }
-        case PAWN:{
-            int dr=p->isWhite?-1:1;
-            int nr=r+dr;
-            if(nr>=0&&nr<ROWS && !board[nr][c]) moves.push_back({nr,c});
-            if((p->isWhite&&r==6)||( !p->isWhite&&r==1)){
-                if(!board[r+2*dr][c] && !board[r+dr][c]) moves.push_back({r+2*dr,c});
-            }
-            for(int dc=-1;dc<=1;dc+=2){
-                int nc=c+dc;
-                if(nc>=0&&nc<COLS){
-                    if(board[nr][nc] && board[nr][nc]->isWhite!=p->isWhite)
-                        moves.push_back({nr,nc});
-                    // アンパッサン
-                    int capRow = p->isWhite ? r : r;
-                    if(lastMove.first==capRow+dr && lastMove.second==nc){
-                        if(board[lastMove.first][lastMove.second] &&
-                            board[lastMove.first][lastMove.second]->type==PAWN &&
-                            board[lastMove.first][lastMove.second]->isWhite!=p->isWhite)
-                            moves.push_back({nr,nc});
-                    }
-                }
-            }
-            break;
-        }
-    }
-    return moves;
-}
-
-// --- 局面文字列化 ---
-std::string serializeBoard(Piece* board[ROWS][COLS], bool whiteTurn){
-    std::stringstream ss;
-    for(int r=0;r<ROWS;r++){
-        for(int c=0;c<COLS;c++){
-            if(!board[r][c]) ss<<"0";
-            else {
-                char ch='0';
-                switch(board[r][c]->type){
-                    case KING: ch='K'; break;
-                    case QUEEN: ch='Q'; break;
-                    case ROOK: ch='R'; break;
-                    case BISHOP: ch='B'; break;
-                    case KNIGHT: ch='N'; break;
-                    case PAWN: ch='P'; break;
-                }
-                if(!board[r][c]->isWhite) ch=std::tolower(ch);
-                ss<<ch;
-            }
-        }
+int main(int argc, char* argv[]) {
+    StartupTimer startup;
+    initAttacks();
+    startup.mark("attack tables");
+    int boardSize = 8;
+    for(int i=1;i<argc-1;i++)
+        if(std::string(argv[i])=="--board") boardSize = std::atoi(argv[i+1]);
+    if(!isBoardSize(boardSize)){
+        std::cerr << "--board must be 8, 10 or 12" << std::endl;
+        return 1;
     }
-    ss<<whiteTurn;
-    return ss.str();
+    return withGeometry(boardSize, [&](auto g){ return runGame<decltype(g)>(argc, argv, startup); });
 }
@@ -0,0 +1,88 @@
+#include "mapped_file.h"
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#endif
+
+#ifdef _WIN32
+bool MappedFile::open(const std::string& path, std::string* error){
+    close();
+    HANDLE f = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                           FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, nullptr);
+    if(f == INVALID_HANDLE_VALUE){
+        if(error) *error = "cannot open " + path;
+        return false;
+    }
+    LARGE_INTEGER size;
+    if(!GetFileSizeEx(f, &size) || size.QuadPart == 0){
+        if(error) *error = "empty or unreadable file " + path;
+        CloseHandle(f);
+        return false;
+    }
+    HANDLE m = CreateFileMappingA(f, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    void* p = m ? MapViewOfFile(m, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if(!p){
+        if(error) *error = "cannot map " + path;
+        if(m) CloseHandle(m);
+        CloseHandle(f);
+        return false;
+    }
+    fileHandle = f;
+    mappingHandle = m;
+    base = static_cast<const uint8_t*>(p);
+    length = size_t(size.QuadPart);
+    return true;
+}
+
+void MappedFile::close(){
+    if(base) UnmapViewOfFile(base);
+    if(mappingHandle) CloseHandle(mappingHandle);
+    if(fileHandle) CloseHandle(fileHandle);
+    base = nullptr;
+    length = 0;
+    fileHandle = mappingHandle = nullptr;
+}
+
+void MappedFile::adviseRandom(){}   // FILE_FLAG_RANDOM_ACCESS で開いている
+#else
+bool MappedFile::open(const std::string& path, std::string* error){
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if(fd < 0){
+        if(error) *error = "cannot open " + path + ": " + std::strerror(errno);
+        return false;
+    }
+    struct stat st;
+    if(fstat(fd, &st) != 0 || st.st_size == 0){
+        if(error) *error = "empty or unreadable file " + path;
+        ::close(fd);
+        return false;
+    }
+    void* p = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);        // マップは fd を閉じても残る
+    if(p == MAP_FAILED){
+        if(error) *error = "cannot map " + path + ": " + std::strerror(errno);
+        return false;
+    }
+    base = static_cast<const uint8_t*>(p);
+    length = size_t(st.st_size);
+    return true;
+}
+
+void MappedFile::close(){
+    if(base) munmap(const_cast<uint8_t*>(base), length);
+    base = nullptr;
+    length = 0;
+}
+
+void MappedFile::adviseRandom(){
+    if(base) madvise(const_cast<uint8_t*>(base), length, MADV_RANDOM);
+}
+#endif
@@ -0,0 +1,32 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// --- 読み取り専用のメモリマップドファイル ---
+// POSIX では mmap、Windows では CreateFileMapping / MapViewOfFile を使う。
+// 中身は OS のページキャッシュから必要な分だけ読まれるので、開くだけなら一瞬で済む。
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile(){ close(); }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& path, std::string* error = nullptr);
+    void close();
+    // ランダムアクセス主体であることを OS に伝える（先読みを抑える）
+    void adviseRandom();
+
+    const uint8_t* data() const { return base; }
+    size_t size() const { return length; }
+    bool isOpen() const { return base != nullptr; }
+
+private:
+    const uint8_t* base = nullptr;
+    size_t length = 0;
+#ifdef _WIN32
+    void* fileHandle = nullptr;
+    void* mappingHandle = nullptr;
+#endif
+};
@@ -0,0 +1,286 @@
+#include "mcts.h"
+#include "eval.h"
+#include "zobrist.h"
+#include <thread>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <algorithm>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+const double UCT_C = 0.2;
+const uint32_t VALUE_ONE = 1024;          // 勝ち 1024、引き分け 512 の固定小数点で足し込む
+const uint32_t VALUE_DRAW = VALUE_ONE / 2;
+const uint32_t ARENA_DEFAULT = 1u << 21;  // 持ち時間もプレイアウト数もないとき（stop で止める）のノード数
+const uint32_t ARENA_MAX = 1u << 23;
+const int NODES_PER_PLAYOUT = 48;         // 1回のプレイアウトで増えるノード数の見積もり（1回の展開で増える子の数）
+const int PLAYOUTS_PER_MS = 400;          // 持ち時間指定のときの1スレッドあたりの見積もり
+
+enum NodeState : uint8_t { NODE_LEAF, NODE_EXPANDING, NODE_EXPANDED, NODE_TERMINAL };
+
+// value はこのノードへ指した側（親の手番）から見た勝ち点の合計。
+// firstChild / childCount / terminalValue は state を release で書き換える前に埋める
+struct MctsNode {
+    std::atomic<uint32_t> visits{0};
+    std::atomic<uint32_t> virtualLoss{0};
+    std::atomic<uint64_t> value{0};
+    uint32_t firstChild = 0;
+    uint16_t childCount = 0;
+    Move move = MOVE_NONE;
+    std::atomic<uint8_t> state{NODE_LEAF};
+    uint16_t terminalValue = 0;           // NODE_TERMINAL のとき、指した側から見た結果
+};
+
+static_assert(std::is_trivially_destructible<MctsNode>::value, "tree nodes are released without destruction");
+
+// ノードは探索ごとに確保した生のメモリに置き、探索が終われば手放す。確保するときには
+// ノードを作らないので、ページに触れるのは実際に展開した分だけ（大きさは持ち時間から見積もる）
+struct Tree {
+    struct Release { void operator()(MctsNode* p) const { ::operator delete(p); } };
+    std::unique_ptr<MctsNode, Release> storage;
+    MctsNode* nodes;
+    uint32_t capacity;
+    std::atomic<uint32_t> top{1};             // 0 番はルート
+
+    explicit Tree(uint32_t n)
+        : storage(static_cast<MctsNode*>(::operator new(sizeof(MctsNode) * size_t(n)))),
+          nodes(storage.get()), capacity(n) { new(&nodes[0]) MctsNode; }
+
+    // 子をまとめて確保して初期化する（足りなければ 0。ルートが 0 番なので子の先頭には来ない）
+    uint32_t allocate(uint32_t n){
+        if(top.load(std::memory_order_relaxed) + n > capacity) return 0;
+        uint32_t first = top.fetch_add(n, std::memory_order_relaxed);
+        if(first + n > capacity) return 0;
+        for(uint32_t i=0;i<n;i++) new(&nodes[first + i]) MctsNode;
+        return first;
+    }
+};
+
+struct Shared {
+    Tree tree;
+    std::vector<uint64_t> rootKeys;           // 対局の履歴。末尾がルート局面
+    const SearchLimits& limits;
+    Clock::time_point start;
+    std::atomic<uint64_t> playouts{0};
+    std::atomic<int> maxDepth{0};
+    std::atomic<bool> stop{false};
+
+    Shared(uint32_t capacity, const SearchLimits& l) : tree(capacity), limits(l), start(Clock::now()) {}
+
+    double elapsedMs() const {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+    bool shouldStop() const {
+        if(stop.load(std::memory_order_relaxed)) return true;
+        if(limits.stop && limits.stop->load(std::memory_order_relaxed)) return true;
+        if(limits.maxNodes && playouts.load(std::memory_order_relaxed) >= limits.maxNodes) return true;
+        return limits.timeMs > 0 && elapsedMs() >= limits.timeMs;
+    }
+};
+
+// 勝率（手番側から見た 0..1）とセンチポーンの換算（400 で勝率 約 91%）
+uint32_t valueFromEval(int cp){
+    double p = 1.0 / (1.0 + std::pow(10.0, -cp / 400.0));
+    return uint32_t(p * VALUE_ONE + 0.5);
+}
+int evalFromWinRate(double p){
+    p = std::min(std::max(p, 0.001), 0.999);
+    return int(std::lround(-400.0 * std::log10(1.0 / p - 1.0)));
+}
+
+// 葉を展開する。終局なら NODE_TERMINAL にして結果を持たせる。
+// 他のスレッドが展開中ならそのまま戻り、呼び出し側は葉としてプレイアウトする
+template<class G>
+uint8_t expand(Tree& tree, MctsNode& node, const BasicPosition<G>& pos){
+    uint8_t expected = NODE_LEAF;
+    if(!node.state.compare_exchange_strong(expected, NODE_EXPANDING, std::memory_order_acquire))
+        return expected;
+
+    if(isGameOver(pos)){
+        node.terminalValue = VALUE_ONE;
+        node.state.store(NODE_TERMINAL, std::memory_order_release);
+        return NODE_TERMINAL;
+    }
+    BasicMoveList<G> list;
+    generateMoves(pos, list);
+    if(list.size == 0 || isFiftyMoveDraw(pos)){
+        node.terminalValue = list.size == 0 && inCheck(pos) ? VALUE_ONE : VALUE_DRAW;
+        node.state.store(NODE_TERMINAL, std::memory_order_release);
+        return NODE_TERMINAL;
+    }
+    uint32_t first = tree.allocate(list.size);
+    if(!first){
+        // アリーナが尽きたら葉のまま残し、以後はここからプレイアウトするだけにする
+        node.state.store(NODE_LEAF, std::memory_order_release);
+        return NODE_EXPANDING;
+    }
+    for(int i=0;i<list.size;i++) tree.nodes[first + i].move = list.moves[i];
+    node.firstChild = first;
+    node.childCount = uint16_t(list.size);
+    node.state.store(NODE_EXPANDED, std::memory_order_release);
+    return NODE_EXPANDED;
+}
+
+// UCT 値が最大の子。仮想損失は「価値 0 の訪問」として数える
+uint32_t selectChild(const Tree& tree, const MctsNode& node){
+    uint32_t parentVisits = node.visits.load(std::memory_order_relaxed)
+                          + node.virtualLoss.load(std::memory_order_relaxed);
+    double logN = std::log(double(parentVisits + 1));
+    uint32_t best = node.firstChild;
+    double bestScore = -1;
+    for(uint32_t i=0;i<node.childCount;i++){
+        const MctsNode& c = tree.nodes[node.firstChild + i];
+        uint32_t n = c.visits.load(std::memory_order_relaxed) + c.virtualLoss.load(std::memory_order_relaxed);
+        if(n == 0) return node.firstChild + i;
+        double q = double(c.value.load(std::memory_order_relaxed)) / (double(VALUE_ONE) * n);
+        double score = q + UCT_C * std::sqrt(logN / n);
+        if(score > bestScore){ bestScore = score; best = node.firstChild + i; }
+    }
+    return best;
+}
+
+// 合法手のランダム対局。擬似合法手をランダムな順に調べ、最初の合法手を指す。
+// keys[size-1] が開始局面で、指すたびに後ろへ積む（同じ局面に戻れば引き分け）。
+// 戻り値は開始局面の手番側から見た価値
+template<class G>
+uint32_t rollout(BasicPosition<G> pos, uint64_t* keys, int size, uint64_t& rng){
+    int us = pos.sideToMove;
+    auto forSide = [&](int side, uint32_t v){ return side == us ? v : VALUE_ONE - v; };
+    for(int ply=0;ply<MCTS_ROLLOUT_PLIES;ply++){
+        if(isGameOver(pos)) return forSide(pos.sideToMove, 0);
+        if(isFiftyMoveDraw(pos)) return VALUE_DRAW;
+        BasicMoveList<G> list;
+        generatePseudoMoves(pos, list);
+        BasicLegalityChecker<G> legal(pos);
+        Move mv = MOVE_NONE;
+        while(list.size){
+            int i = int(splitmix64(rng) % uint64_t(list.size));
+            if(legal.isLegal(list.moves[i])){ mv = list.moves[i]; break; }
+            list.moves[i] = list.moves[--list.size];
+        }
+        if(!mv) return legal.inCheck() ? forSide(pos.sideToMove, 0) : VALUE_DRAW;
+        makeMove(pos, mv);
+        keys[size++] = pos.key;
+        if(countRepetitions(keys, size, pos.halfMoveClock) > 0) return VALUE_DRAW;
+    }
+    if(isGameOver(pos)) return forSide(pos.sideToMove, 0);
+    return forSide(pos.sideToMove, valueFromEval(evaluate(pos)));
+}
+
+struct WorkerResult {
+    uint64_t playouts = 0;
+};
+
+template<class G>
+void runWorker(Shared& shared, const BasicPosition<G>& root, int index, WorkerResult& out){
+    Tree& tree = shared.tree;
+    uint64_t rng = root.key ^ (0x9E3779B97F4A7C15ULL * uint64_t(index + 1));
+    uint32_t path[MAX_PLY + 1];
+    int deepest = 0;
+
+    // 探索と同じく対局の履歴に木の経路とプレイアウトの手を積む
+    std::vector<uint64_t> keys(shared.rootKeys);
+    int rootIndex = (int)keys.size() - 1;
+    keys.resize(keys.size() + MAX_PLY + MCTS_ROLLOUT_PLIES + 1);
+
+    while(!shared.shouldStop()){
+        // --- 選択: 展開済みのノードを UCT でたどる ---
+        BasicPosition<G> pos = root;
+        int depth = 0;
+        path[0] = 0;
+        uint8_t state = tree.nodes[0].state.load(std::memory_order_acquire);
+        bool repeated = false;
+        while(depth < MAX_PLY){
+            MctsNode& node = tree.nodes[path[depth]];
+            if(state == NODE_LEAF && (depth == 0 || node.visits.load(std::memory_order_relaxed) > 0))
+                state = expand(tree, node, pos);
+            if(state != NODE_EXPANDED) break;
+            uint32_t child = selectChild(tree, node);
+            tree.nodes[child].virtualLoss.fetch_add(1, std::memory_order_relaxed);
+            makeMove(pos, tree.nodes[child].move);
+            path[++depth] = child;
+            keys[rootIndex + depth] = pos.key;
+            if(countRepetitions(keys.data(), rootIndex + depth + 1, pos.halfMoveClock) > 0){ repeated = true; break; }
+            state = tree.nodes[child].state.load(std::memory_order_acquire);
+        }
+        deepest = std::max(deepest, depth);
+
+        // --- 評価: 同一局面なら引き分け、終局ならその結果、そうでなければプレイアウト
+        //     （葉の手番側から見た価値） ---
+        const MctsNode& leaf = tree.nodes[path[depth]];
+        uint32_t v = repeated ? VALUE_DRAW
+                   : state == NODE_TERMINAL ? VALUE_ONE - leaf.terminalValue
+                   : rollout(pos, keys.data(), rootIndex + depth + 1, rng);
+
+        // --- 逆伝播: 各ノードは親の手番側から見た価値を持つので1段ごとに反転する ---
+        for(int d=depth; d>=0; d--){
+            MctsNode& node = tree.nodes[path[d]];
+            uint32_t forMover = (depth - d) % 2 == 0 ? VALUE_ONE - v : v;
+            node.value.fetch_add(forMover, std::memory_order_relaxed);
+            node.visits.fetch_add(1, std::memory_order_relaxed);
+            if(d > 0) node.virtualLoss.fetch_sub(1, std::memory_order_relaxed);
+        }
+        out.playouts++;
+        shared.playouts.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    int prev = shared.maxDepth.load(std::memory_order_relaxed);
+    while(deepest > prev && !shared.maxDepth.compare_exchange_weak(prev, deepest)){}
+}
+
+}
+
+template<class G>
+SearchResult mctsBestMove(const BasicPosition<G>& root, const GameHistory& history, const SearchLimits& limits){
+    SearchResult result;
+    BasicMoveList<G> rootMoves;
+    generateMoves(root, rootMoves);
+    if(rootMoves.size == 0 || isGameOver(root)) return result;
+    result.best = rootMoves.moves[0];
+
+    int n = limits.threads > 1 ? limits.threads : 1;
+    uint64_t playouts = limits.maxNodes ? limits.maxNodes
+                      : limits.timeMs > 0 ? uint64_t(limits.timeMs) * n * PLAYOUTS_PER_MS : 0;
+    uint64_t want = playouts ? playouts * NODES_PER_PLAYOUT + BasicMoveList<G>::CAPACITY + 1 : ARENA_DEFAULT;
+    uint32_t capacity = uint32_t(std::min<uint64_t>(want, ARENA_MAX));
+    Shared shared(capacity, limits);
+    shared.rootKeys.assign(history.keys.begin(), history.keys.end());
+    if(shared.rootKeys.empty() || shared.rootKeys.back() != root.key) shared.rootKeys.push_back(root.key);
+
+    std::vector<WorkerResult> results(n);
+    std::vector<std::thread> helpers;
+    for(int i=1;i<n;i++)
+        helpers.emplace_back([&, i]{ runWorker(shared, root, i, results[i]); });
+    runWorker(shared, root, 0, results[0]);
+    shared.stop.store(true, std::memory_order_relaxed);
+    for(auto& t : helpers) t.join();
+
+    // 最も多く訪れた子を選ぶ（勝率の高さより安定している）
+    const MctsNode& rootNode = shared.tree.nodes[0];
+    if(rootNode.state.load(std::memory_order_acquire) == NODE_EXPANDED){
+        const MctsNode* best = nullptr;
+        for(uint32_t i=0;i<rootNode.childCount;i++){
+            const MctsNode& c = shared.tree.nodes[rootNode.firstChild + i];
+            if(!best || c.visits.load() > best->visits.load()) best = &c;
+        }
+        uint32_t visits = best->visits.load();
+        result.best = best->move;
+        result.score = visits ? evalFromWinRate(double(best->value.load()) / (double(VALUE_ONE) * visits)) : 0;
+    }
+    result.depth = shared.maxDepth.load();
+    for(auto& r : results){
+        result.threadNodes.push_back(r.playouts);
+        result.nodes += r.playouts;
+    }
+    result.seconds = shared.elapsedMs() / 1000.0;
+    return result;
+}
+
+#define INSTANTIATE_MCTS(G) \
+    template SearchResult mctsBestMove(const BasicPosition<G>&, const GameHistory&, const SearchLimits&);
+FOR_EACH_GEOMETRY(INSTANTIATE_MCTS)
@@ -0,0 +1,19 @@
+#pragma once
+#include "search.h"
+
+// --- モンテカルロ木探索（UCT） ---
+// 木は連続したノード配列（アリーナ）に置き、子は1回の展開でまとめて確保して
+// firstChild から childCount 個を並べる。配列は探索ごとにプレイアウト数か持ち時間から
+// 見積もった大きさで確保して終われば手放し、ノードは子として確保したときに初期化する。
+// 複数スレッドは同じ木を共有し、降りる途中のノードに仮想損失を積んで
+// 他のスレッドが同じ枝に集中しないようにする（ロックは使わない）。
+// プレイアウトは合法手のランダム対局を MCTS_ROLLOUT_PLIES 手まで行い、
+// 決着がつかなければ評価関数を勝率に直して返す。
+// SearchLimits の maxNodes はプレイアウト数、timeMs は持ち時間として使う（maxDepth は見ない）。
+// 千日手は αβ 探索と同じく、history とルートからの経路で同じ局面に戻れば引き分け（価値 0.5）とする。
+const int MCTS_ROLLOUT_PLIES = 4;
+
+// 返す SearchResult: nodes はプレイアウト数、depth は木の最大深さ、
+// score はルート手番から見た勝率をセンチポーン相当に直したもの
+template<class G>
+SearchResult mctsBestMove(const BasicPosition<G>& root, const GameHistory& history, const SearchLimits& limits);
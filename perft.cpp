@@ -0,0 +1,315 @@
+// --- perft: 指定深さまでの末端局面数を数える（SDL 不要） ---
+// 使い方:
+//   perft [depth] [局面65文字]   深さ1から順に節点数と nodes/sec を表示
+//   perft --divide depth [局面]  ルートの手ごとの内訳
+//   perft --verify               保存済みの参照値と照合（不一致なら終了コード1）
+//   --board N                    N x N 盤（8 / 10 / 12、既定 8）。局面は N*N+1 文字
+#include "position.h"
+#include "flip.h"
+#include "attacks.h"
+#include "eval.h"
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <string>
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+#include <vector>
+
+// --- 参照値（ルール変更時はここを更新する） ---
+struct PerftRef {
+    const char* name;
+    int boardSize;              // 盤の一辺
+    const char* board;          // nullptr = 初期局面
+    uint64_t nodes[6];          // 深さ1..6（0 は未計測）
+};
+
+static const PerftRef REFS[] = {
+    { "start", 8, nullptr,
+      { 20, 400, 8902, 197281, 4865315, 119076667 } },
+    { "opening", 8, "rnb0kbnr0q0p00p0ppP000000000ppnpN0000000000000P0P0PPPP0PR0BQKB0R1",
+      { 25, 803, 20676, 690226, 18853541, 0 } },
+    { "middle", 8, "r0b0k0nr00pp0q000p000p0pp0n0P0p00000P000PPb00PP000PN000PR0BQKBNR1",
+      { 24, 978, 23867, 928789, 24691317, 0 } },
+    // 大きい盤は変種の初期配置（position.cpp の BackRank）から
+    { "start10", 10, nullptr,
+      { 26, 676, 19544, 563720, 18143657, 0 } },
+    { "start12", 12, nullptr,
+      { 32, 1024, 36252, 1282013, 0, 0 } },
+    { "middle10", 10, "r0bn0kbnbrp0pp0ppppp00n00000000p00p0000000000000000000000000N00000000P0P00P0P0q0PNPP0P0PP0R0B0QKBNBR1",
+      { 30, 1320, 40722, 1856694, 0, 0 } },
+    { "middle12", 12, "rnbnbqkbnb0rp0pp0p0ppppp000000000n000000p0p000000p00000000000000000000000000000000000000000000000000000P00PPBP0P00000N00P0P0PPP0PP00RN0NBQKB0BNR1",
+      { 43, 1979, 88630, 0, 0, 0 } },
+};
+
+// 数え方: 深さ 0 に届いた局面を1と数える。途中で終局した局面（キングを取られた・
+// 反転された）は展開せず、末端としても数えない（0）。深さ 1 で終局する手は数える。
+// 参照値・他ツールとの比較はすべてこの数え方による。
+template<class G>
+static uint64_t perft(BasicPosition<G>& pos, int depth){
+    if(depth == 0) return 1;
+    if(isGameOver(pos)) return 0;
+    BasicMoveList<G> list;
+    generateMoves(pos, list);
+    if(depth == 1) return list.size;
+    uint64_t nodes = 0;
+    BasicUndo<G> undo;
+    for(Move m : list){
+        makeMove(pos, m, undo);
+        nodes += perft(pos, depth - 1);
+        unmakeMove(pos, undo);
+    }
+    return nodes;
+}
+
+// --- 合法手の照合 ---
+// generateMoves の結果を、擬似合法手を実際に指して相手の全応手を試す素朴な判定と比べる
+template<class G>
+static bool kingLostAfterReplies(const BasicPosition<G>& pos, int color){
+    BasicMoveList<G> replies;
+    generatePseudoMoves(pos, replies);
+    for(Move r : replies){
+        BasicPosition<G> q = pos;
+        makeMove(q, r);
+        if(!q.pieces[color][KING]) return true;
+    }
+    return false;
+}
+
+// 手番を渡したら相手がキングを取れる／挟めるか
+template<class G>
+static bool inCheckByTrial(const BasicPosition<G>& pos){
+    BasicPosition<G> passed = pos;
+    BasicUndo<G> nu;
+    makeNullMove(passed, nu);
+    return kingLostAfterReplies(passed, pos.sideToMove);
+}
+
+template<class G>
+static void legalByTrial(const BasicPosition<G>& pos, BasicMoveList<G>& out){
+    int us = pos.sideToMove;
+    BasicMoveList<G> pseudo;
+    generatePseudoMoves(pos, pseudo);
+    if(!pos.pieces[us][KING]){ out = pseudo; return; }
+    bool check = inCheckByTrial(pos);
+    for(Move m : pseudo){
+        if(moveFlag(m) == MF_CASTLE){
+            // チェック中と、キングが通るマスに相手の駒が利いているときは不可
+            int from = moveFrom(m), pass = (from + moveTo(m)) / 2;
+            if(check) continue;
+            BasicPosition<G> q = pos;
+            q.sideToMove ^= 1;
+            q.epSquare = -1;
+            q.pieces[us][KING] ^= G::bit(from) | G::bit(pass);
+            q.byColor[us] ^= G::bit(from) | G::bit(pass);
+            BasicMoveList<G> replies;
+            generatePseudoMoves(q, replies);
+            bool attacked = false;
+            for(Move r : replies) if(moveTo(r) == pass) attacked = true;
+            if(attacked) continue;
+        }
+        BasicPosition<G> q = pos;
+        makeMove(q, m);
+        if(!q.pieces[us ^ 1][KING] || !kingLostAfterReplies(q, us)) out.push(m);
+    }
+}
+
+template<class G>
+static bool sameMoves(const BasicMoveList<G>& a, const BasicMoveList<G>& b){
+    if(a.size != b.size) return false;
+    for(Move m : a) if(std::find(b.begin(), b.end(), m) == b.end()) return false;
+    return true;
+}
+
+// 木の全節点で照合する（照合した局面数を返す、食い違いは -1）。
+// 手ごとの判定も、指した後の局面を組み立てて調べ直す isLegalByBoards と比べる
+template<class G>
+static int64_t checkLegality(const BasicPosition<G>& pos, int depth){
+    if(isGameOver(pos)) return 0;
+    BasicMoveList<G> fast, slow, pseudo;
+    generateMoves(pos, fast);
+    legalByTrial(pos, slow);
+    if(!sameMoves(fast, slow) || inCheck(pos) != inCheckByTrial(pos)){
+        std::cout << "legal move mismatch in " << serializeBoard(pos) << " (" << fast.size
+                  << " generated, " << slow.size << " by trial)\n";
+        return -1;
+    }
+    generatePseudoMoves(pos, pseudo);
+    BasicLegalityChecker<G> legal(pos);
+    for(Move m : pseudo){
+        if(legal.isLegal(m) != isLegalByBoards(pos, m)){
+            std::cout << "legality mismatch for " << moveToString<G>(m) << " in " << serializeBoard(pos) << "\n";
+            return -1;
+        }
+    }
+    int64_t n = 1;
+    if(depth > 1){
+        for(Move m : fast){
+            BasicPosition<G> q = pos;
+            makeMove(q, m);
+            int64_t sub = checkLegality(q, depth - 1);
+            if(sub < 0) return -1;
+            n += sub;
+        }
+    }
+    return n;
+}
+
+template<class G>
+static bool samePosition(const BasicPosition<G>& a, const BasicPosition<G>& b){
+    return std::memcmp(a.pieces, b.pieces, sizeof(a.pieces)) == 0
+        && std::memcmp(a.byColor, b.byColor, sizeof(a.byColor)) == 0
+        && a.sideToMove == b.sideToMove && a.castling == b.castling && a.epSquare == b.epSquare
+        && a.halfMoveClock == b.halfMoveClock && a.key == b.key;
+}
+
+// unmakeMove で局面が完全に元に戻るか、差分更新した評価アキュムレータが作り直したものと
+// 一致するかを、木の全節点で確かめる（戻った数を返す、失敗は -1）
+template<class G>
+static int64_t checkUnmake(BasicPosition<G>& pos, const Accumulator& acc, int depth){
+    if(depth == 0 || isGameOver(pos)) return 0;
+    BasicMoveList<G> list;
+    generateMoves(pos, list);
+    int64_t n = 0;
+    for(Move m : list){
+        BasicPosition<G> before = pos;
+        BasicUndo<G> undo;
+        makeMove(pos, m, undo);
+        if(pos.key != computeKey(pos)){
+            std::cout << "key mismatch after " << moveToString<G>(m) << " in " << serializeBoard(before) << "\n";
+            return -1;
+        }
+        Accumulator child, fresh;
+        updateAccumulator(acc, pos, undo, child);
+        refreshAccumulator(pos, fresh);
+        if(std::memcmp(&child, &fresh, sizeof child) != 0){
+            std::cout << "accumulator mismatch after " << moveToString<G>(m) << " in " << serializeBoard(before) << "\n";
+            return -1;
+        }
+        int64_t sub = checkUnmake(pos, child, depth - 1);
+        unmakeMove(pos, undo);
+        if(sub < 0) return -1;
+        if(!samePosition(pos, before)){
+            std::cout << "unmake mismatch for " << moveToString<G>(m) << " in " << serializeBoard(before) << "\n";
+            return -1;
+        }
+        n += sub + 1;
+    }
+    return n;
+}
+
+template<class G>
+static bool loadPosition(const char* s, BasicPosition<G>& pos){
+    if(!s){ setStartPosition(pos); return true; }
+    if(!parseBoard(s, pos)){
+        std::cerr << "invalid position: " << s << "\n";
+        return false;
+    }
+    return true;
+}
+
+template<class G>
+static void runDepths(BasicPosition<G>& pos, int maxDepth){
+    for(int d=1; d<=maxDepth; d++){
+        auto t0 = std::chrono::steady_clock::now();
+        uint64_t n = perft(pos, d);
+        double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        std::cout << "depth " << d << "  nodes " << std::setw(12) << n
+                  << "  time " << std::fixed << std::setprecision(3) << sec << "s"
+                  << "  nps " << (uint64_t)(sec > 0 ? n / sec : 0) << "\n";
+    }
+}
+
+template<class G>
+static void divide(BasicPosition<G>& pos, int depth){
+    BasicMoveList<G> list;
+    generateMoves(pos, list);
+    uint64_t total = 0;
+    BasicUndo<G> undo;
+    for(Move m : list){
+        makeMove(pos, m, undo);
+        uint64_t n = perft(pos, depth - 1);
+        unmakeMove(pos, undo);
+        std::cout << moveToString<G>(m) << ": " << n << "\n";
+        total += n;
+    }
+    std::cout << "total: " << total << "\n";
+}
+
+// 1つの参照局面を照合する（失敗数を返す）。合法手の照合は擬似合法手の数の2乗で
+// 重くなるので、大きい盤は1段浅くする
+template<class G>
+static int verifyRef(const PerftRef& ref, uint64_t& allNodes){
+    int failed = 0;
+    BasicPosition<G> pos;
+    if(!loadPosition(ref.board, pos)) return 1;
+    for(int d=1; d<=6; d++){
+        if(!ref.nodes[d-1]) continue;
+        uint64_t n = perft(pos, d);
+        allNodes += n;
+        bool ok = n == ref.nodes[d-1];
+        if(!ok) failed++;
+        std::cout << (ok ? "ok   " : "FAIL ") << ref.name << " depth " << d
+                  << ": " << n << " (expected " << ref.nodes[d-1] << ")\n";
+    }
+    Accumulator acc;
+    refreshAccumulator(pos, acc);
+    int64_t checked = checkUnmake(pos, acc, 3);
+    if(checked < 0) failed++;
+    else std::cout << "ok   " << ref.name << " make/unmake and eval accumulator: " << checked << " moves\n";
+    checked = checkLegality(pos, G::ROWS == 8 ? 4 : 3);
+    if(checked < 0) failed++;
+    else std::cout << "ok   " << ref.name << " legal moves match trial play: " << checked << " positions\n";
+    return failed;
+}
+
+static int verify(){
+    int failed = 0;
+    uint64_t allNodes = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    for(auto& ref : REFS)
+        failed += withGeometry(ref.boardSize, [&](auto g){ return verifyRef<decltype(g)>(ref, allNodes); });
+    double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    std::cout << (failed ? "FAILED " : "all passed ") << "(" << allNodes << " nodes, "
+              << (uint64_t)(sec > 0 ? allNodes / sec : 0) << " nps, flip kernel: " << flipKernelName()
+              << ", sliders: " << sliderLookupName() << ", eval: " << evalSimdName() << ")\n";
+    return failed ? 1 : 0;
+}
+
+template<class G>
+static int run(const std::vector<const char*>& args){
+    BasicPosition<G> pos;
+    if(args.size() >= 2 && std::strcmp(args[0], "--divide") == 0){
+        if(!loadPosition(args.size() >= 3 ? args[2] : nullptr, pos)) return 1;
+        divide(pos, std::max(1, std::atoi(args[1])));
+        return 0;
+    }
+
+    int depth = !args.empty() ? std::atoi(args[0]) : 5;
+    if(depth < 1){
+        std::cerr << "usage: perft [--board N] [depth] [position] | --divide depth [position] | --verify\n";
+        return 1;
+    }
+    if(!loadPosition(args.size() >= 2 ? args[1] : nullptr, pos)) return 1;
+    std::cout << serializeBoard(pos) << "  (flip kernel: " << flipKernelName()
+              << ", sliders: " << sliderLookupName() << ")\n";
+    runDepths(pos, depth);
+    return 0;
+}
+
+int main(int argc, char* argv[]){
+    initAttacks();
+    int boardSize = 8;
+    std::vector<const char*> args;
+    for(int i=1; i<argc; i++){
+        if(std::strcmp(argv[i], "--board") == 0 && i + 1 < argc) boardSize = std::atoi(argv[++i]);
+        else args.push_back(argv[i]);
+    }
+    if(!isBoardSize(boardSize)){
+        std::cerr << "board size must be 8, 10 or 12\n";
+        return 1;
+    }
+    if(!args.empty() && std::strcmp(args[0], "--verify") == 0) return verify();
+    return withGeometry(boardSize, [&](auto g){ return run<decltype(g)>(args); });
+}
@@ -0,0 +1,58 @@
+#include "piece_atlas.h"
+#include <iostream>
+#include <vector>
+#include <cstdint>
+
+static const char* COLOR_NAMES[2] = { "WHITE", "BLACK" };
+static const char* PIECE_NAMES[6] = { "KING", "QUEEN", "ROOK", "BISHOP", "KNIGHT", "PAWN" };
+
+std::string pieceImageName(int color, int type){
+    return std::string(COLOR_NAMES[color]) + "_" + PIECE_NAMES[type] + ".png";
+}
+
+bool createPieceAtlas(SDL_Renderer* ren, int tile, PieceAtlas& atlas){
+    SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "linear");
+    atlas.texture = SDL_CreateTexture(ren, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STATIC, tile * 6, tile * 2);
+    if(!atlas.texture){ std::cerr << "Failed to create atlas texture: " << SDL_GetError() << "\n"; return false; }
+    SDL_SetTextureBlendMode(atlas.texture, SDL_BLENDMODE_BLEND);
+    atlas.tile = tile;
+    for(int c=0;c<2;c++)
+        for(int t=0;t<6;t++)
+            atlas.src[c][t] = { t * tile, c * tile, tile, tile };
+
+    // 届いていないコマは透明のままにしておく
+    std::vector<uint32_t> clear(size_t(tile) * 6 * tile * 2, 0);
+    SDL_UpdateTexture(atlas.texture, nullptr, clear.data(), tile * 6 * 4);
+    return true;
+}
+
+void uploadPieceTile(PieceAtlas& atlas, int color, int type, SDL_Surface* tile){
+    if(!atlas.texture || !tile) return;
+    SDL_UpdateTexture(atlas.texture, &atlas.src[color][type], tile->pixels, tile->pitch);
+}
+
+void destroyPieceAtlas(PieceAtlas& atlas){
+    if(atlas.texture) SDL_DestroyTexture(atlas.texture);
+    atlas.texture = nullptr;
+}
+
+template<class G>
+int drawPieces(SDL_Renderer* ren, const PieceAtlas& atlas, const BasicPosition<G>& pos, int cell){
+    if(!atlas.texture) return 0;
+    int calls = 0;
+    // 全駒が同じテクスチャなので、SDL のバージョンとバックエンドによってはレンダーバッチで
+    // まとめて描かれることもある。数えるのは SDL に渡した RenderCopy の数
+    for(int c=0;c<2;c++)
+        for(int t=0;t<6;t++)
+            for(typename G::Board b = pos.pieces[c][t]; b; ){
+                int sq = popLsb(b);
+                SDL_Rect dst = { G::colOf(sq) * cell, G::rowOf(sq) * cell, cell, cell };
+                SDL_RenderCopy(ren, atlas.texture, &atlas.src[c][t], &dst);
+                calls++;
+            }
+    return calls;
+}
+
+#define INSTANTIATE_DRAW_PIECES(G) \
+    template int drawPieces(SDL_Renderer*, const PieceAtlas&, const BasicPosition<G>&, int);
+FOR_EACH_GEOMETRY(INSTANTIATE_DRAW_PIECES)
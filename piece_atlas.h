@@ -0,0 +1,28 @@
+#pragma once
+#include <SDL.h>
+#include <string>
+#include "position.h"
+
+// --- 駒のテクスチャアトラス ---
+// 12枚の駒画像を1枚のテクスチャに縮小して並べ（横 PieceType、縦 Color）、
+// [Color][PieceType] の切り出し矩形で引く。デコードと縮小は assets.cpp が
+// スレッドプールで行い、できたコマから uploadPieceTile で書き込む。
+struct PieceAtlas {
+    SDL_Texture* texture = nullptr;
+    SDL_Rect src[2][6];          // [Color][PieceType]
+    int tile = 0;                // 1コマの一辺（ピクセル）
+};
+
+// "WHITE_KING.png" などの画像ファイル名
+std::string pieceImageName(int color, int type);
+
+// 透明な空のアトラスを作る。tile はアトラス内の1コマの大きさ
+bool createPieceAtlas(SDL_Renderer* ren, int tile, PieceAtlas& atlas);
+// tile x tile の RGBA32 サーフェスを1コマ分書き込む（描画スレッドから呼ぶ）
+void uploadPieceTile(PieceAtlas& atlas, int color, int type, SDL_Surface* tile);
+void destroyPieceAtlas(PieceAtlas& atlas);
+
+// 盤上の駒をまとめて描く（cell は盤の1マスの大きさ）。戻り値は SDL_RenderCopy の回数
+// （GPU の描画回数とは限らない）
+template<class G>
+int drawPieces(SDL_Renderer* ren, const PieceAtlas& atlas, const BasicPosition<G>& pos, int cell);
@@ -0,0 +1,790 @@
+#include "position.h"
+#include "flip.h"
+#include "zobrist.h"
+#include "attacks.h"
+#include <cctype>
+
+// 盤の大きさ G ごとの定数と局面の内部処理。キング・ルーク・ポーンの初期段と
+// キャスリングのマスは盤の形から作る（8x8 では元の固定の表と同じ値になる）
+template<class G>
+struct Rules {
+    typedef typename G::Board Board;
+    typedef Attacks<G> A;
+    typedef BasicPosition<G> Pos;
+    static constexpr int R = G::ROWS, C = G::COLS;
+
+    static Board bit(int sq){ return G::bit(sq); }
+    static Board shift(Board b, int d){ return G::shift(b, d); }
+    static Board flips(int sq, Board own, Board opp){ return FlipKernel<G>::flips(sq, own, opp); }
+
+    // --- キャスリング: [色][0=キング側,1=クイーン側] ---
+    struct CastleInfo { int kingFrom, kingTo, rookFrom, rookTo, right; Board between; };
+    static constexpr int KING_COL = C / 2;
+    static constexpr int BACK_ROW[2] = { R - 1, 0 };
+    static constexpr CastleInfo castle(int color, int side){
+        int row = BACK_ROW[color], k = G::sqOf(row, KING_COL);
+        int rook = G::sqOf(row, side ? 0 : C - 1), dir = side ? -1 : 1;
+        int right = color == WHITE ? (side ? CR_A1 : CR_H1) : (side ? CR_A8 : CR_H8);
+        CastleInfo ci{ k, k + 2 * dir, rook, k + dir, right, Board{} };
+        for(int s = k + dir; s != rook; s += dir) ci.between |= G::bit(s);
+        return ci;
+    }
+    static constexpr CastleInfo CASTLES[2][2] = {
+        { castle(WHITE, 0), castle(WHITE, 1) },
+        { castle(BLACK, 0), castle(BLACK, 1) },
+    };
+    static constexpr int KING_RIGHT[2] = { CR_WHITE_KING, CR_BLACK_KING };
+
+    // from/to に触れた手で消えるキャスリング権
+    static int castleClear(int sq){
+        if(sq == CASTLES[WHITE][0].kingFrom) return CR_WHITE_KING;
+        if(sq == CASTLES[BLACK][0].kingFrom) return CR_BLACK_KING;
+        for(int c=0;c<2;c++)
+            for(auto& ci : CASTLES[c]) if(sq == ci.rookFrom) return ci.right;
+        return 0;
+    }
+
+    // 1段目（白の昇格先は row 0、黒は最後の段）と、ポーンが2マス進める段
+    static constexpr Board PROMO_ROW[2] = { G::makeRow(0), G::makeRow(R - 1) };
+    static constexpr int PAWN_ROW[2] = { R - 2, 1 };
+    // アンパッサンで取られるポーンのマス（us が to に取ったとき）
+    static int epVictim(int to, int us){ return to + (us == WHITE ? C : -C); }
+
+    static void addTargets(BasicMoveList<G>& list, int from, Board targets);
+    static Board attackersTo(const Board* p, int sq, int them, Board occ);
+    static bool canLand(const Board* p, Board mine, Board occ, int castling, int sq, int them);
+    static Board sandwichSquares(int ksq, Board own, Board opp);
+    static bool kingThreatened(const Board* p, Board own, Board opp, int castling, int k, int them);
+    static bool epFlipsKing(const Board* p, Board own, Board opp, int k, int us, int themEp);
+    static bool isThreatened(const Pos& b, int us, int themEp);
+    static Board between(int a, int b);
+    static Board flipsOf(const Pos& pos, Move m, Board& mover, Board& victims);
+    static void boardsAfter(const Pos& pos, Move m, Board flips, Pos& nb);
+};
+
+template<class G>
+int BasicPosition<G>::colorAt(int sq) const {
+    if(byColor[WHITE] & G::bit(sq)) return WHITE;
+    if(byColor[BLACK] & G::bit(sq)) return BLACK;
+    return NO_COLOR;
+}
+
+template<class G>
+int BasicPosition<G>::pieceAt(int sq) const {
+    int c = colorAt(sq);
+    if(c == NO_COLOR) return NO_PIECE;
+    for(int t=KING;t<=PAWN;t++) if(pieces[c][t] & G::bit(sq)) return t;
+    return NO_PIECE;
+}
+
+template<class G>
+void clearPosition(BasicPosition<G>& pos){
+    for(int c=0;c<2;c++){
+        for(int t=0;t<6;t++) pos.pieces[c][t] = {};
+        pos.byColor[c] = {};
+    }
+    pos.sideToMove = WHITE;
+    pos.castling = 0;
+    pos.epSquare = -1;
+    pos.halfMoveClock = 0;
+    pos.key = 0;
+}
+
+template<class G>
+void putPiece(BasicPosition<G>& pos, int sq, int color, int type){
+    pos.pieces[color][type] |= G::bit(sq);
+    pos.byColor[color] |= G::bit(sq);
+    pos.key ^= ZOBRIST_KEYS<G>.piece[color][type][sq];
+}
+
+template<class G>
+void removePiece(BasicPosition<G>& pos, int sq){
+    int c = pos.colorAt(sq);
+    if(c == NO_COLOR) return;
+    int t = pos.pieceAt(sq);
+    pos.pieces[c][t] &= ~G::bit(sq);
+    pos.byColor[c] &= ~G::bit(sq);
+    pos.key ^= ZOBRIST_KEYS<G>.piece[c][t][sq];
+}
+
+// --- Zobrist キーを一から計算（検証・読み込み用） ---
+template<class G>
+uint64_t computeKey(const BasicPosition<G>& pos){
+    const BasicZobristKeys<G>& z = ZOBRIST_KEYS<G>;
+    uint64_t k = 0;
+    for(int c=0;c<2;c++) for(int t=0;t<6;t++)
+        for(typename G::Board b = pos.pieces[c][t]; b; ) k ^= z.piece[c][t][popLsb(b)];
+    k ^= z.castling[pos.castling];
+    if(pos.epSquare >= 0) k ^= z.ep[G::colOf(pos.epSquare)];
+    if(pos.sideToMove == BLACK) k ^= z.side;
+    return k;
+}
+
+// --- 初期配置（キングは中央の列、大きい盤はナイトとビショップを増やす） ---
+template<int C> struct BackRank;
+template<> struct BackRank<8>  { static constexpr int P[8]  = { ROOK, KNIGHT, BISHOP, QUEEN, KING, BISHOP, KNIGHT, ROOK }; };
+template<> struct BackRank<10> { static constexpr int P[10] = { ROOK, KNIGHT, BISHOP, KNIGHT, QUEEN, KING, BISHOP, KNIGHT, BISHOP, ROOK }; };
+template<> struct BackRank<12> { static constexpr int P[12] = { ROOK, KNIGHT, BISHOP, KNIGHT, BISHOP, QUEEN, KING, BISHOP, KNIGHT, BISHOP, KNIGHT, ROOK }; };
+
+template<class G>
+void setStartPosition(BasicPosition<G>& pos){
+    clearPosition(pos);
+    const int R = G::ROWS;
+    for(int c=0;c<G::COLS;c++){
+        putPiece(pos, G::sqOf(R-1,c), WHITE, BackRank<G::COLS>::P[c]);
+        putPiece(pos, G::sqOf(R-2,c), WHITE, PAWN);
+        putPiece(pos, G::sqOf(0,c), BLACK, BackRank<G::COLS>::P[c]);
+        putPiece(pos, G::sqOf(1,c), BLACK, PAWN);
+    }
+    pos.castling = CR_WHITE_KING | CR_BLACK_KING | CR_A1 | CR_H1 | CR_A8 | CR_H8;
+    pos.key ^= ZOBRIST_KEYS<G>.castling[pos.castling];
+}
+
+// --- 擬似合法手（自殺手も含む。キングを取る／反転させると勝ち） ---
+template<class G>
+void Rules<G>::addTargets(BasicMoveList<G>& list, int from, Board targets){
+    while(targets) list.push(moveOf(from, popLsb(targets)));
+}
+
+template<class G>
+void generatePseudoMoves(const BasicPosition<G>& pos, BasicMoveList<G>& list){
+    typedef Rules<G> RL;
+    typedef typename RL::A A;
+    typedef typename G::Board Board;
+    int us = pos.sideToMove, them = us ^ 1;
+    Board own = pos.byColor[us], occ = pos.occupied();
+    Board notOwn = ~own;
+
+    for(Board b = pos.pieces[us][KNIGHT]; b; ){
+        int s = popLsb(b);
+        RL::addTargets(list, s, A::knight(s) & notOwn);
+    }
+    for(Board b = pos.pieces[us][BISHOP]; b; ){
+        int s = popLsb(b);
+        RL::addTargets(list, s, A::bishop(s, occ) & notOwn);
+    }
+    for(Board b = pos.pieces[us][ROOK]; b; ){
+        int s = popLsb(b);
+        RL::addTargets(list, s, A::rook(s, occ) & notOwn);
+    }
+    for(Board b = pos.pieces[us][QUEEN]; b; ){
+        int s = popLsb(b);
+        RL::addTargets(list, s, A::queen(s, occ) & notOwn);
+    }
+    for(Board b = pos.pieces[us][KING]; b; ){
+        int s = popLsb(b);
+        RL::addTargets(list, s, A::king(s) & notOwn);
+    }
+
+    // キャスリング
+    if(pos.castling & RL::KING_RIGHT[us]){
+        for(auto& ci : RL::CASTLES[us]){
+            if((pos.castling & ci.right) && (pos.pieces[us][KING] & G::bit(ci.kingFrom)) &&
+               (pos.pieces[us][ROOK] & G::bit(ci.rookFrom)) && !(occ & ci.between))
+                list.push(moveOf(ci.kingFrom, ci.kingTo, MF_CASTLE));
+        }
+    }
+
+    // ポーン
+    Board promoRow = RL::PROMO_ROW[us];
+    int fwd = us == WHITE ? N : S;
+    int push = G::DELTA[fwd];
+    for(Board b = pos.pieces[us][PAWN]; b; ){
+        int s = popLsb(b);
+        int r = G::rowOf(s);
+        Board one = G::shift(G::bit(s), fwd) & ~occ;
+        if(one){
+            int to = s + push;
+            list.push(moveOf(s, to, (one & promoRow) ? MF_PROMOTION : MF_NORMAL));
+            if(r == RL::PAWN_ROW[us]){
+                if(G::shift(one, fwd) & ~occ) list.push(moveOf(s, to + push, MF_DOUBLE_PUSH));
+            }
+        }
+        Board caps = A::pawn(us, s);
+        for(Board t = caps & pos.byColor[them]; t; ){
+            int to = popLsb(t);
+            list.push(moveOf(s, to, (G::bit(to) & promoRow) ? MF_PROMOTION : MF_NORMAL));
+        }
+        if(pos.epSquare >= 0 && (caps & G::bit(pos.epSquare)))
+            list.push(moveOf(s, pos.epSquare, MF_EN_PASSANT));
+    }
+}
+
+// --- 合法手 ---
+// 手番側のキングが「相手の駒に取られる」か「相手の駒に挟まれて反転する」状態をチェックとし、
+// 指した後にチェックが残る手を除く。局面は書き換えず、局面ごとに一度作るマスク
+// （チェックしている駒・ピン・挟まれうるマス）と、指した後の相手の駒のビットボードだけで判定する。
+
+// them の駒（p）のうち sq を取れる（利いている）もの
+template<class G>
+typename G::Board Rules<G>::attackersTo(const Board* p, int sq, int them, Board occ){
+    return (A::knight(sq) & p[KNIGHT]) | (A::king(sq) & p[KING])
+         | (A::pawn(them ^ 1, sq) & p[PAWN])
+         | (A::bishop(sq, occ) & (p[BISHOP] | p[QUEEN]))
+         | (A::rook(sq, occ) & (p[ROOK] | p[QUEEN]));
+}
+
+// them の駒（p、占めるマス mine）が1手で sq に来られるか（取る・空きマスへ動く・ポーンの前進・
+// キャスリング）。アンパッサンは取られるポーンが消えてから反転を数えるので呼び出し側で別に扱う
+template<class G>
+bool Rules<G>::canLand(const Board* p, Board mine, Board occ, int castling, int sq, int them){
+    Board x = bit(sq);
+    if(mine & x) return false;
+    if((A::knight(sq) & p[KNIGHT]) | (A::king(sq) & p[KING])
+       | (A::bishop(sq, occ) & (p[BISHOP] | p[QUEEN]))
+       | (A::rook(sq, occ) & (p[ROOK] | p[QUEEN])))
+        return true;
+    if(occ & x) return bool(A::pawn(them ^ 1, sq) & p[PAWN]);
+
+    int r = G::rowOf(sq);
+    if(them == WHITE){
+        if(r < R - 1 && (p[PAWN] & bit(sq + C))) return true;
+        if(r == R - 4 && (p[PAWN] & bit(sq + 2 * C)) && !(occ & bit(sq + C))) return true;
+    } else {
+        if(r > 0 && (p[PAWN] & bit(sq - C))) return true;
+        if(r == 3 && (p[PAWN] & bit(sq - 2 * C)) && !(occ & bit(sq - C))) return true;
+    }
+    if(castling & KING_RIGHT[them]){
+        for(auto& ci : CASTLES[them])
+            if(ci.kingTo == sq && (castling & ci.right) && (p[KING] & bit(ci.kingFrom)) &&
+               (p[ROOK] & bit(ci.rookFrom)) && !(occ & ci.between))
+                return true;
+    }
+    return false;
+}
+
+// キングから一直線に並ぶ自駒の列の反対側に相手駒があるとき、列の先の空きマスか
+// 列の駒（キング以外）に相手の駒が来るとキングごと挟まれる。そのマスの集合
+template<class G>
+typename G::Board Rules<G>::sandwichSquares(int ksq, Board own, Board opp){
+    Board danger{}, k = bit(ksq);
+    for(int d=0;d<8;d++){
+        Board a = shift(k, 7 - d);               // 7 - d が逆方向
+        while(a & own) a = shift(a, 7 - d);
+        if(!(a & opp)) continue;
+        Board c = shift(k, d);
+        while(c & own){ danger |= c; c = shift(c, d); }
+        danger |= c & ~opp;
+    }
+    return danger;
+}
+
+// キング k が them の駒 p（own / opp は両者の占めるマス）に取られるか挟まれうるか
+template<class G>
+bool Rules<G>::kingThreatened(const Board* p, Board own, Board opp, int castling, int k, int them){
+    Board occ = own | opp;
+    if(attackersTo(p, k, them, occ)) return true;
+    for(Board d = sandwichSquares(k, own, opp); d; )
+        if(canLand(p, opp, occ, castling, popLsb(d), them)) return true;
+    return false;
+}
+
+// them がアンパッサン（themEp）で取ると us のキング k まで反転するか。p は them の駒
+template<class G>
+bool Rules<G>::epFlipsKing(const Board* p, Board own, Board opp, int k, int us, int themEp){
+    if(!(A::pawn(us, themEp) & p[PAWN])) return false;
+    int capSq = epVictim(themEp, us ^ 1);
+    return bool(flips(themEp, opp | bit(themEp), own & ~bit(capSq)) & bit(k));
+}
+
+// b で us のキングがチェックされているか。themEp は them が使えるアンパッサンのマス
+template<class G>
+bool Rules<G>::isThreatened(const Pos& b, int us, int themEp){
+    int them = us ^ 1;
+    const Board* p = b.pieces[them];
+    for(Board ks = b.pieces[us][KING]; ks; ){
+        int k = popLsb(ks);
+        if(kingThreatened(p, b.byColor[us], b.byColor[them], b.castling, k, them)) return true;
+        if(themEp >= 0 && epFlipsKing(p, b.byColor[us], b.byColor[them], k, us, themEp)) return true;
+    }
+    return false;
+}
+
+// a と b を結ぶ直線上で両端を除くマス（並んでいなければ 0）
+template<class G>
+typename G::Board Rules<G>::between(int a, int b){
+    Board r = A::rook(a, bit(b));
+    if(r & bit(b)) return r & A::rook(b, bit(a));
+    r = A::bishop(a, bit(b));
+    if(r & bit(b)) return r & A::bishop(b, bit(a));
+    return Board{};
+}
+
+// 手 m で動く自駒のマス（mover、キャスリングのルークを含む）と反転する相手駒。
+// 相手駒のうち残るもの（取った駒・アンパッサンのポーンを除く）を victims に返す
+template<class G>
+typename G::Board Rules<G>::flipsOf(const Pos& pos, Move m, Board& mover, Board& victims){
+    int us = pos.sideToMove, them = us ^ 1;
+    int from = moveFrom(m), to = moveTo(m), flag = moveFlag(m);
+    mover = (pos.byColor[us] ^ bit(from)) | bit(to);
+    victims = pos.byColor[them] & ~bit(to);
+    if(flag == MF_EN_PASSANT) victims &= ~bit(epVictim(to, us));
+    if(flag == MF_CASTLE){
+        const CastleInfo& ci = CASTLES[us][to < from];
+        mover ^= bit(ci.rookFrom) | bit(ci.rookTo);
+    }
+    return flips(to, mover, victims);
+}
+
+// 指した後の駒配置（キーは更新しない）
+template<class G>
+void Rules<G>::boardsAfter(const Pos& pos, Move m, Board flips, Pos& nb){
+    int us = pos.sideToMove, them = us ^ 1;
+    int from = moveFrom(m), to = moveTo(m), flag = moveFlag(m);
+    nb = pos;
+    int type = pos.pieceAt(from);
+    int captured = pos.pieceAt(to);
+    if(captured != NO_PIECE){ nb.pieces[them][captured] ^= bit(to); nb.byColor[them] ^= bit(to); }
+    if(flag == MF_EN_PASSANT){
+        int cap = epVictim(to, us);
+        nb.pieces[them][PAWN] ^= bit(cap);
+        nb.byColor[them] ^= bit(cap);
+    }
+    nb.pieces[us][type] ^= bit(from) | bit(to);
+    nb.byColor[us] ^= bit(from) | bit(to);
+    if(flag == MF_CASTLE){
+        const CastleInfo& ci = CASTLES[us][to < from];
+        nb.pieces[us][ROOK] ^= bit(ci.rookFrom) | bit(ci.rookTo);
+        nb.byColor[us] ^= bit(ci.rookFrom) | bit(ci.rookTo);
+    }
+    if(flag == MF_PROMOTION){ nb.pieces[us][PAWN] ^= bit(to); nb.pieces[us][QUEEN] ^= bit(to); }
+    if(flips){
+        for(int t=0;t<6;t++){
+            Board f = nb.pieces[them][t] & flips;
+            nb.pieces[them][t] ^= f;
+            nb.pieces[us][t] ^= f;
+        }
+        nb.byColor[them] ^= flips;
+        nb.byColor[us] ^= flips;
+    }
+    nb.castling &= ~(castleClear(from) | castleClear(to));
+    nb.sideToMove = them;
+}
+
+// 検証用: 指した後の局面を組み立て、チェックを一から調べ直す
+template<class G>
+bool isLegalByBoards(const BasicPosition<G>& pos, Move m){
+    typedef Rules<G> RL;
+    typedef typename G::Board Board;
+    int us = pos.sideToMove, them = us ^ 1;
+    if(!pos.pieces[us][KING]) return true;
+    int from = moveFrom(m), to = moveTo(m), flag = moveFlag(m);
+    if(flag == MF_CASTLE &&
+       (RL::isThreatened(pos, us, -1) || RL::attackersTo(pos.pieces[them], (from + to) / 2, them, pos.occupied())))
+        return false;
+    Board mover, victims;
+    Board flips = RL::flipsOf(pos, m, mover, victims);
+    if((flips | G::bit(to)) & pos.pieces[them][KING]) return true;
+    BasicPosition<G> nb;
+    RL::boardsAfter(pos, m, flips, nb);
+    return !RL::isThreatened(nb, us, flag == MF_DOUBLE_PUSH ? (from + to) / 2 : -1);
+}
+
+// 局面ごとのマスク（キングが1つのとき）
+//  - checkers: キングを取れる相手の駒。キング以外の手は全部を取る・反転させる・遮るしかない
+//  - ピン: キングとの間が自駒1つだけの相手の飛び駒。その自駒は飛び駒との線上にしか動けない
+//  - zone: キングに連なる自駒の列と各方向の先端のマス。ここが変わらなければ挟まれうるマスも同じ
+//  - landable: 挟まれうるマスのうち相手が今来られるもの（空でなければチェック）
+//  - openers: 空くと挟まれうるマスへの相手の通り道が開きうるマス
+// キングの手・zone に触れる手は、キングの行き先（または元のキング）について
+// 指した後の相手の駒と占有で利きと挟まれうるマスを数え直す
+template<class G>
+BasicLegalityChecker<G>::BasicLegalityChecker(const BasicPosition<G>& p) : pos(p) {
+    typedef Rules<G> RL;
+    typedef typename RL::A A;
+    int us = pos.sideToMove, them = us ^ 1;
+    Board kings = pos.pieces[us][KING];
+    Board own = pos.byColor[us], opp = pos.byColor[them], occ = own | opp;
+    const Board* th = pos.pieces[them];
+    noKing = !kings;
+    single = popcount(kings) == 1;
+    checkers = pinned = zone = danger = landable = openers = Board{};
+    pinCount = 0;
+    ksq = -1;
+    if(!single){
+        check = !noKing && RL::isThreatened(pos, us, -1);
+        return;
+    }
+    ksq = lsb(kings);
+    checkers = RL::attackersTo(th, ksq, them, occ);
+
+    Board snipers = (A::rook(ksq, opp) & (th[ROOK] | th[QUEEN]))
+                  | (A::bishop(ksq, opp) & (th[BISHOP] | th[QUEEN]));
+    for(Board s = snipers; s; ){
+        int sq = popLsb(s);
+        Board line = RL::between(ksq, sq);
+        Board b = line & occ;
+        if(b && !moreThanOne(b) && (b & own)){
+            pinned |= b;
+            pinRay[pinCount++] = line | G::bit(sq);
+        }
+    }
+
+    for(int d=0;d<8;d++){
+        Board c = G::shift(kings, d);
+        while(c & own){ zone |= c; c = G::shift(c, d); }
+        zone |= c;
+    }
+    danger = RL::sandwichSquares(ksq, own, opp);
+    for(Board d = danger; d; ){
+        int sq = popLsb(d);
+        if(RL::canLand(th, opp, occ, pos.castling, sq, them)) landable |= G::bit(sq);
+        openers |= A::queen(sq, occ);
+    }
+    check = checkers || landable;
+}
+
+template<class G>
+bool BasicLegalityChecker<G>::isLegal(Move m) const {
+    typedef Rules<G> RL;
+    typedef typename RL::A A;
+    if(noKing) return true;          // キングを失った局面（終局済み）
+    int us = pos.sideToMove, them = us ^ 1;
+    int from = moveFrom(m), to = moveTo(m), flag = moveFlag(m);
+    Board own = pos.byColor[us], opp = pos.byColor[them];
+    if(flag == MF_CASTLE && (check || RL::attackersTo(pos.pieces[them], (from + to) / 2, them, own | opp)))
+        return false;                // 利きを通り抜けない
+    Board mover, victims;
+    Board flips = RL::flipsOf(pos, m, mover, victims);
+
+    // 相手キングを取る／挟む手はその場で勝ちなので常に指せる
+    if((flips | G::bit(to)) & pos.pieces[them][KING]) return true;
+
+    // 指した後の相手の駒（取られた・反転した駒を除く）
+    Board after[6];
+    Board oppAfter = victims & ~flips, ownAfter = mover | flips, gone = opp & ~oppAfter;
+    int castling = pos.castling & ~(RL::castleClear(from) | RL::castleClear(to));
+    auto fill = [&]{ for(int t=0;t<6;t++) after[t] = pos.pieces[them][t] & ~gone; };
+    int ep = flag == MF_DOUBLE_PUSH ? (from + to) / 2 : -1;
+
+    if(!single){
+        Board kings = pos.pieces[us][KING];
+        if(kings & G::bit(from)) kings ^= G::bit(from) | G::bit(to);
+        fill();
+        for(Board ks = kings; ks; ){
+            int k = popLsb(ks);
+            if(RL::kingThreatened(after, ownAfter, oppAfter, castling, k, them)) return false;
+            if(ep >= 0 && RL::epFlipsKing(after, ownAfter, oppAfter, k, us, ep)) return false;
+        }
+        return true;
+    }
+
+    // キングの手: 行き先で、キングが抜けた後の占有と残る相手の駒で調べる
+    if(from == ksq){
+        fill();
+        return !RL::kingThreatened(after, ownAfter, oppAfter, castling, to, them);
+    }
+
+    // 取られる利き
+    if(flag == MF_EN_PASSANT){
+        // 取ったポーンのマスも空くので、残る相手の駒の利きをそのまま数える
+        fill();
+        if(RL::attackersTo(after, ksq, them, ownAfter | oppAfter)) return false;
+    } else {
+        Board rest = checkers & gone;
+        rest ^= checkers;            // 取りも反転もされずに残るチェックの駒
+        if(rest){
+            if(moreThanOne(rest)) return false;
+            if(!(RL::between(ksq, lsb(rest)) & G::bit(to))) return false;
+        }
+        if(pinned & G::bit(from)){
+            for(int i=0;i<pinCount;i++){
+                const Board ray = pinRay[i];
+                if((ray & G::bit(from)) && !(ray & G::bit(to)) && !(ray & gone)) return false;
+            }
+        }
+    }
+
+    // 挟まれうるマス。zone が変わらなければ、今来られるマスと開いた通り道の先だけ調べ直せばよい
+    Board vacated = G::bit(from);
+    if(flag == MF_EN_PASSANT) vacated |= G::bit(RL::epVictim(to, us));
+    Board recheck;
+    bool rebuilt = bool((vacated | G::bit(to) | flips) & zone);
+    if(rebuilt) recheck = RL::sandwichSquares(ksq, ownAfter, oppAfter);
+    else recheck = (vacated & openers) ? danger : landable;
+    if(!recheck && (ep < 0 || !(A::pawn(us, ep) & pos.pieces[them][PAWN]))) return true;
+
+    fill();
+    Board occAfter = ownAfter | oppAfter;
+    for(Board d = recheck; d; )
+        if(RL::canLand(after, oppAfter, occAfter, castling, popLsb(d), them)) return false;
+    return ep < 0 || !RL::epFlipsKing(after, ownAfter, oppAfter, ksq, us, ep);
+}
+
+template<class G>
+void generateMoves(const BasicPosition<G>& pos, BasicMoveList<G>& list){
+    BasicMoveList<G> pseudo;
+    generatePseudoMoves(pos, pseudo);
+    BasicLegalityChecker<G> legal(pos);
+    for(Move m : pseudo) if(legal.isLegal(m)) list.push(m);
+}
+
+template<class G>
+bool inCheck(const BasicPosition<G>& pos){
+    return pos.pieces[pos.sideToMove][KING] && Rules<G>::isThreatened(pos, pos.sideToMove, -1);
+}
+
+// --- オセロ反転（sq に置かれた color の駒で挟んだ相手駒） ---
+template<class G>
+typename G::Board flipOthello(const BasicPosition<G>& pos, int sq, int color){
+    return FlipKernel<G>::flips(sq, pos.byColor[color], pos.byColor[color ^ 1]);
+}
+
+// --- 手を指す ---
+template<class G>
+void makeMove(BasicPosition<G>& pos, Move m){
+    BasicUndo<G> undo;
+    makeMove(pos, m, undo);
+}
+
+template<class G>
+void makeMove(BasicPosition<G>& pos, Move m, BasicMoveInfo<G>* info){
+    BasicUndo<G> undo;
+    makeMove(pos, m, undo);
+    if(info) *info = undo;
+}
+
+template<class G>
+void makeMove(BasicPosition<G>& pos, Move m, BasicUndo<G>& undo){
+    typedef Rules<G> RL;
+    typedef typename G::Board Board;
+    const BasicZobristKeys<G>& z = ZOBRIST_KEYS<G>;
+    undo.move = m;
+    undo.castling = pos.castling;
+    undo.epSquare = pos.epSquare;
+    undo.halfMoveClock = pos.halfMoveClock;
+    undo.key = pos.key;
+
+    int us = pos.sideToMove, them = us ^ 1;
+    int from = moveFrom(m), to = moveTo(m), flag = moveFlag(m);
+    int type = pos.pieceAt(from);
+    int captured = pos.pieceAt(to);
+
+    if(captured != NO_PIECE) removePiece(pos, to);
+    if(flag == MF_EN_PASSANT){
+        removePiece(pos, RL::epVictim(to, us));
+        captured = PAWN;
+    }
+
+    // --- 移動実行 ---
+    pos.pieces[us][type] ^= G::bit(from) | G::bit(to);
+    pos.byColor[us] ^= G::bit(from) | G::bit(to);
+    pos.key ^= z.piece[us][type][from] ^ z.piece[us][type][to];
+
+    // --- キャスリング ---
+    if(flag == MF_CASTLE){
+        const auto& ci = RL::CASTLES[us][to < from];
+        pos.pieces[us][ROOK] ^= G::bit(ci.rookFrom) | G::bit(ci.rookTo);
+        pos.byColor[us] ^= G::bit(ci.rookFrom) | G::bit(ci.rookTo);
+        pos.key ^= z.piece[us][ROOK][ci.rookFrom] ^ z.piece[us][ROOK][ci.rookTo];
+    }
+
+    // --- ポーンプロモーション ---
+    if(flag == MF_PROMOTION){
+        pos.pieces[us][PAWN] ^= G::bit(to);
+        pos.pieces[us][QUEEN] ^= G::bit(to);
+        pos.key ^= z.piece[us][PAWN][to] ^ z.piece[us][QUEEN][to];
+    }
+
+    if(captured != NO_PIECE || type == PAWN) pos.halfMoveClock = 0;
+    else pos.halfMoveClock++;
+
+    pos.key ^= z.castling[pos.castling];
+    pos.castling &= ~(RL::castleClear(from) | RL::castleClear(to));
+    pos.key ^= z.castling[pos.castling];
+
+    // --- オセロ反転 ---
+    BasicFlipResult<G> fr = computeFlips<G>(to, pos.byColor[us], pos.byColor[them], pos.pieces[them][KING]);
+    Board flips = fr.flips;
+    if(flips){
+        for(int t=0;t<6;t++){
+            Board f = pos.pieces[them][t] & flips;
+            pos.pieces[them][t] ^= f;
+            pos.pieces[us][t] ^= f;
+            while(f) pos.key ^= z.flip[t][popLsb(f)];
+        }
+        pos.byColor[them] ^= flips;
+        pos.byColor[us] ^= flips;
+    }
+
+    // 実際に取れるポーンがいるときだけアンパッサンのマスを残す
+    if(pos.epSquare >= 0) pos.key ^= z.ep[G::colOf(pos.epSquare)];
+    pos.epSquare = -1;
+    if(flag == MF_DOUBLE_PUSH){
+        int ep = (from + to) / 2;
+        if(RL::A::pawn(us, ep) & pos.pieces[them][PAWN]){
+            pos.epSquare = ep;
+            pos.key ^= z.ep[G::colOf(ep)];
+        }
+    }
+
+    pos.sideToMove = them;
+    pos.key ^= z.side;
+
+    undo.captured = captured;
+    undo.flips = flips;
+    undo.kingFlipped = fr.kingSandwiched;
+}
+
+// makeMove の逆順に戻す。キー・権利・時計は記録からそのまま書き戻す
+template<class G>
+void unmakeMove(BasicPosition<G>& pos, const BasicUndo<G>& undo){
+    typedef Rules<G> RL;
+    typedef typename G::Board Board;
+    int them = pos.sideToMove, us = them ^ 1;
+    int from = moveFrom(undo.move), to = moveTo(undo.move), flag = moveFlag(undo.move);
+    pos.sideToMove = us;
+
+    // --- オセロ反転を戻す（反転したマスはすべて us の駒になっている） ---
+    if(undo.flips){
+        for(int t=0;t<6;t++){
+            Board f = pos.pieces[us][t] & undo.flips;
+            pos.pieces[us][t] ^= f;
+            pos.pieces[them][t] ^= f;
+        }
+        pos.byColor[us] ^= undo.flips;
+        pos.byColor[them] ^= undo.flips;
+    }
+
+    if(flag == MF_PROMOTION){
+        pos.pieces[us][QUEEN] ^= G::bit(to);
+        pos.pieces[us][PAWN] ^= G::bit(to);
+    }
+    if(flag == MF_CASTLE){
+        const auto& ci = RL::CASTLES[us][to < from];
+        pos.pieces[us][ROOK] ^= G::bit(ci.rookFrom) | G::bit(ci.rookTo);
+        pos.byColor[us] ^= G::bit(ci.rookFrom) | G::bit(ci.rookTo);
+    }
+
+    int type = pos.pieceAt(to);
+    pos.pieces[us][type] ^= G::bit(from) | G::bit(to);
+    pos.byColor[us] ^= G::bit(from) | G::bit(to);
+
+    if(undo.captured != NO_PIECE){
+        int sq = flag == MF_EN_PASSANT ? RL::epVictim(to, us) : to;
+        pos.pieces[them][undo.captured] |= G::bit(sq);
+        pos.byColor[them] |= G::bit(sq);
+    }
+
+    pos.castling = undo.castling;
+    pos.epSquare = undo.epSquare;
+    pos.halfMoveClock = undo.halfMoveClock;
+    pos.key = undo.key;
+}
+
+template<class G>
+void makeNullMove(BasicPosition<G>& pos, BasicUndo<G>& undo){
+    undo.move = MOVE_NONE;
+    undo.captured = NO_PIECE;
+    undo.flips = {};
+    undo.kingFlipped = false;
+    undo.castling = pos.castling;
+    undo.epSquare = pos.epSquare;
+    undo.halfMoveClock = pos.halfMoveClock;
+    undo.key = pos.key;
+    if(pos.epSquare >= 0){
+        pos.key ^= ZOBRIST_KEYS<G>.ep[G::colOf(pos.epSquare)];
+        pos.epSquare = -1;
+    }
+    pos.halfMoveClock++;
+    pos.sideToMove ^= 1;
+    pos.key ^= ZOBRIST_KEYS<G>.side;
+}
+
+template<class G>
+void unmakeNullMove(BasicPosition<G>& pos, const BasicUndo<G>& undo){
+    pos.sideToMove ^= 1;
+    pos.epSquare = undo.epSquare;
+    pos.halfMoveClock = undo.halfMoveClock;
+    pos.key = undo.key;
+}
+
+// --- 座標表記（最後の行 = 1段目） ---
+template<class G>
+std::string moveToString(Move m){
+    std::string s;
+    for(int sq : { moveFrom(m), moveTo(m) }){
+        s += char('a' + G::colOf(sq));
+        s += std::to_string(G::ROWS - G::rowOf(sq));
+    }
+    if(moveFlag(m) == MF_PROMOTION) s += 'q';
+    return s;
+}
+
+template<class G>
+Move parseMove(const BasicPosition<G>& pos, const std::string& s){
+    BasicMoveList<G> list;
+    generateMoves(pos, list);
+    for(Move m : list) if(moveToString<G>(m) == s) return m;
+    return MOVE_NONE;
+}
+
+// --- 局面文字列化（マス数 + 手番） ---
+static const char PIECE_CHARS[] = "KQRBNP";
+
+template<class G>
+std::string serializeBoard(const BasicPosition<G>& pos){
+    std::string s(G::SQUARES + 1, '0');
+    for(int sq=0;sq<G::SQUARES;sq++){
+        int t = pos.pieceAt(sq);
+        if(t == NO_PIECE) continue;
+        char ch = PIECE_CHARS[t];
+        if(pos.colorAt(sq) == BLACK) ch = std::tolower(ch);
+        s[sq] = ch;
+    }
+    s[G::SQUARES] = pos.sideToMove == WHITE ? '1' : '0';
+    return s;
+}
+
+template<class G>
+bool parseBoard(const std::string& s, BasicPosition<G>& pos){
+    typedef Rules<G> RL;
+    const int SQ = G::SQUARES;
+    if(s.size() < SQ + 1) return false;
+    clearPosition(pos);
+    for(int sq=0;sq<SQ;sq++){
+        char ch = s[sq];
+        if(ch == '0') continue;
+        int type = -1;
+        for(int t=0;t<6;t++) if(PIECE_CHARS[t] == std::toupper(ch)) type = t;
+        if(type < 0) return false;
+        putPiece(pos, sq, std::isupper(ch) ? WHITE : BLACK, type);
+    }
+    if(s[SQ] != '0' && s[SQ] != '1') return false;
+    pos.sideToMove = s[SQ] == '1' ? WHITE : BLACK;
+
+    // キャスリング権は初期位置に残っている駒から推定する
+    for(int c=0;c<2;c++){
+        if(pos.pieces[c][KING] & G::bit(RL::CASTLES[c][0].kingFrom)) pos.castling |= RL::KING_RIGHT[c];
+        for(auto& ci : RL::CASTLES[c])
+            if(pos.pieces[c][ROOK] & G::bit(ci.rookFrom)) pos.castling |= ci.right;
+    }
+    pos.key = computeKey(pos);
+    return true;
+}
+
+// --- 盤の大きさごとの実体化 ---
+#define INSTANTIATE_RULES(G) \
+    template struct BasicPosition<G>; \
+    template class BasicLegalityChecker<G>; \
+    template void setStartPosition(BasicPosition<G>&); \
+    template void clearPosition(BasicPosition<G>&); \
+    template void putPiece(BasicPosition<G>&, int, int, int); \
+    template void removePiece(BasicPosition<G>&, int); \
+    template void generateMoves(const BasicPosition<G>&, BasicMoveList<G>&); \
+    template void generatePseudoMoves(const BasicPosition<G>&, BasicMoveList<G>&); \
+    template bool inCheck(const BasicPosition<G>&); \
+    template bool isLegalByBoards(const BasicPosition<G>&, Move); \
+    template G::Board flipOthello(const BasicPosition<G>&, int, int); \
+    template void makeMove(BasicPosition<G>&, Move); \
+    template void makeMove(BasicPosition<G>&, Move, BasicMoveInfo<G>*); \
+    template void makeMove(BasicPosition<G>&, Move, BasicUndo<G>&); \
+    template void unmakeMove(BasicPosition<G>&, const BasicUndo<G>&); \
+    template void makeNullMove(BasicPosition<G>&, BasicUndo<G>&); \
+    template void unmakeNullMove(BasicPosition<G>&, const BasicUndo<G>&); \
+    template uint64_t computeKey(const BasicPosition<G>&); \
+    template std::string moveToString<G>(Move); \
+    template Move parseMove(const BasicPosition<G>&, const std::string&); \
+    template std::string serializeBoard(const BasicPosition<G>&); \
+    template bool parseBoard(const std::string&, BasicPosition<G>&);
+FOR_EACH_GEOMETRY(INSTANTIATE_RULES)
@@ -0,0 +1,146 @@
+#pragma once
+#include "bitboard.h"
+#include <string>
+
+enum PieceType { KING, QUEEN, ROOK, BISHOP, KNIGHT, PAWN, NO_PIECE };
+enum Color { WHITE, BLACK, NO_COLOR };
+
+// --- 手の表現: from(8bit) | to(8bit) | flag(4bit) ---
+// 12x12 までの盤のマス番号が入るよう 32 ビット。置換表は下位 20 ビット、
+// 棋譜は 8x8 なら 6|6|4 の 16 ビット（packMove）、大きい盤は1バイトずつで保存する
+typedef uint32_t Move;
+enum MoveFlag { MF_NORMAL, MF_DOUBLE_PUSH, MF_EN_PASSANT, MF_CASTLE, MF_PROMOTION };
+const Move MOVE_NONE = 0;
+const int MOVE_BITS = 20;
+
+inline Move moveOf(int from, int to, int flag = MF_NORMAL){ return Move(from | (to << 8) | (flag << 16)); }
+inline int moveFrom(Move m){ return m & 0xFF; }
+inline int moveTo(Move m){ return (m >> 8) & 0xFF; }
+inline int moveFlag(Move m){ return m >> 16; }
+
+// 8x8 の手の 16 ビット表現（棋譜・棋譜データベース・定跡の形式）
+typedef uint16_t PackedMove;
+inline PackedMove packMove(Move m){ return PackedMove(moveFrom(m) | (moveTo(m) << 6) | (moveFlag(m) << 12)); }
+inline Move unpackMove(PackedMove p){ return moveOf(p & 63, (p >> 6) & 63, p >> 12); }
+
+// --- キャスリング権（キング未移動 + 四隅のルーク未移動） ---
+enum {
+    CR_WHITE_KING = 1, CR_BLACK_KING = 2,
+    CR_A1 = 4, CR_H1 = 8, CR_A8 = 16, CR_H8 = 32
+};
+
+// --- 固定長の手リスト ---
+// オセロ反転で駒が増えうるので通常のチェスより余裕を持たせる（8x8 で 512）
+template<class G>
+struct BasicMoveList {
+    static constexpr int CAPACITY = 8 * G::SQUARES;
+    Move moves[CAPACITY];
+    int size = 0;
+    void push(Move m){ moves[size++] = m; }
+    Move* begin(){ return moves; }
+    Move* end(){ return moves + size; }
+    const Move* begin() const { return moves; }
+    const Move* end() const { return moves + size; }
+};
+
+// --- 局面（値型） ---
+// 盤の大きさ G（geometry.h）ごとの型。8x8 は下の Position
+template<class G>
+struct BasicPosition {
+    typedef G Geometry;
+    typedef typename G::Board Board;
+
+    Board pieces[2][6];       // [Color][PieceType]
+    Board byColor[2];
+    int sideToMove;
+    int castling;
+    int epSquare;             // アンパッサンで取れるマス（なければ -1）
+    int halfMoveClock;
+    uint64_t key;             // Zobrist キー（makeMove で差分更新）
+
+    Board occupied() const { return byColor[WHITE] | byColor[BLACK]; }
+    int colorAt(int sq) const;
+    int pieceAt(int sq) const;
+};
+
+// 手を指した結果（効果音や勝敗判定用）
+template<class G>
+struct BasicMoveInfo {
+    int captured;                // 取った駒（なければ NO_PIECE）
+    typename G::Board flips;     // オセロ反転したマス
+    bool kingFlipped;            // 相手キングを挟んで反転させた
+};
+
+// --- 戻すための記録（makeMove で埋めて unmakeMove に渡す） ---
+// 固定サイズなので探索や対局の Undo スタックは最初に確保した配列で足りる
+template<class G>
+struct BasicUndo : BasicMoveInfo<G> {
+    Move move;
+    int castling;
+    int epSquare;
+    int halfMoveClock;
+    uint64_t key;
+};
+
+template<class G> void setStartPosition(BasicPosition<G>& pos);
+template<class G> void clearPosition(BasicPosition<G>& pos);
+template<class G> void putPiece(BasicPosition<G>& pos, int sq, int color, int type);
+template<class G> void removePiece(BasicPosition<G>& pos, int sq);
+
+// 合法手（指した後に自分のキングが取られる／挟まれる手は含まない）
+template<class G> void generateMoves(const BasicPosition<G>& pos, BasicMoveList<G>& list);
+// 擬似合法手（キングの安全を見ない。検証用）
+template<class G> void generatePseudoMoves(const BasicPosition<G>& pos, BasicMoveList<G>& list);
+// 手番側のキングが取られる、または相手の次の一手で挟まれて反転する状態か
+template<class G> bool inCheck(const BasicPosition<G>& pos);
+
+// 擬似合法手が合法かを1手ずつ調べる（探索で実際に読む手だけ判定する用）。
+// 局面ごとの前計算（チェックしている駒、ピン、挟まれに関わるマス）を持ち、手を指さずに判定する
+template<class G>
+class BasicLegalityChecker {
+public:
+    typedef typename G::Board Board;
+    explicit BasicLegalityChecker(const BasicPosition<G>& pos);
+    bool isLegal(Move m) const;       // m は pos の擬似合法手であること
+    bool inCheck() const { return check; }
+private:
+    const BasicPosition<G>& pos;
+    bool noKing, single, check;
+    int ksq;
+    Board checkers, pinned, zone, danger, landable, openers;
+    int pinCount;
+    Board pinRay[8];                  // キングとピンしている飛び駒の間 + 飛び駒
+};
+// 検証用（perft --verify）: 指した後の局面を組み立ててチェックを調べ直す
+template<class G> bool isLegalByBoards(const BasicPosition<G>& pos, Move m);
+template<class G> typename G::Board flipOthello(const BasicPosition<G>& pos, int sq, int color);
+template<class G> void makeMove(BasicPosition<G>& pos, Move m);
+template<class G> void makeMove(BasicPosition<G>& pos, Move m, BasicMoveInfo<G>* info);
+template<class G> void makeMove(BasicPosition<G>& pos, Move m, BasicUndo<G>& undo);
+template<class G> void unmakeMove(BasicPosition<G>& pos, const BasicUndo<G>& undo);
+template<class G> void makeNullMove(BasicPosition<G>& pos, BasicUndo<G>& undo);     // 手番だけ渡す（探索の枝刈り用）
+template<class G> void unmakeNullMove(BasicPosition<G>& pos, const BasicUndo<G>& undo);
+template<class G> uint64_t computeKey(const BasicPosition<G>& pos);
+
+// 手番側のキングが取られた／反転させられた = 直前に指した側の勝ち
+// （合法手だけで指していればキングは取られず、挟んで反転させたときだけ起きる）
+template<class G>
+inline bool isGameOver(const BasicPosition<G>& pos){ return !pos.pieces[pos.sideToMove][KING]; }
+
+// 座標表記（例: e2e4, プロモーションは e7e8q。段は盤の行数から数えるので 10x10 なら a10 まで）
+template<class G> std::string moveToString(Move m);
+template<class G> Move parseMove(const BasicPosition<G>& pos, const std::string& s);
+
+// 文字列化はデバッグと書き出し専用（履歴は Zobrist キーで持つ）。マス数 + 手番の文字列
+template<class G> std::string serializeBoard(const BasicPosition<G>& pos);
+template<class G> bool parseBoard(const std::string& s, BasicPosition<G>& pos);
+
+// --- 通常の 8x8 盤 ---
+typedef BasicPosition<Geometry8> Position;
+typedef BasicMoveList<Geometry8> MoveList;
+typedef BasicMoveInfo<Geometry8> MoveInfo;
+typedef BasicUndo<Geometry8> Undo;
+typedef BasicLegalityChecker<Geometry8> LegalityChecker;
+const int MAX_MOVES = MoveList::CAPACITY;
+
+inline std::string moveToString(Move m){ return moveToString<Geometry8>(m); }
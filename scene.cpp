@@ -0,0 +1,44 @@
+#include "scene.h"
+
+static const char* SCENE_IMAGES[SCENE_COUNT] = { "./img/title.png", "./img/tutorial.png" };
+
+// 何もイベントがなくてもこの間隔で目を覚ます（描き直すのは pump が true のときだけ）
+static const int SCENE_WAIT_MS = 250;
+
+const char* sceneImagePath(SceneId id){ return SCENE_IMAGES[id]; }
+
+void uploadSceneImage(SDL_Renderer* ren, SceneAssets& assets, SceneId id, SDL_Surface* surface){
+    if(!surface) return;
+    if(assets.background[id]) SDL_DestroyTexture(assets.background[id]);
+    assets.background[id] = SDL_CreateTextureFromSurface(ren, surface);
+}
+
+void destroySceneAssets(SceneAssets& assets){
+    for(SDL_Texture*& t : assets.background){
+        if(t) SDL_DestroyTexture(t);
+        t = nullptr;
+    }
+}
+
+static void drawScene(SDL_Renderer* ren, SDL_Texture* tex){
+    SDL_SetRenderDrawColor(ren, 0, 0, 0, 255);
+    SDL_RenderClear(ren);
+    if(tex) SDL_RenderCopy(ren, tex, nullptr, nullptr);
+    SDL_RenderPresent(ren);
+}
+
+bool runScene(SDL_Renderer* ren, const SceneAssets& assets, SceneId id, const std::function<bool()>& pump){
+    bool dirty = true;
+    SDL_Event e;
+    for(;;){
+        // 画像が届いた・画面が隠れた・大きさが変わったときだけ描き直す
+        if(pump && pump()) dirty = true;
+        if(dirty){ drawScene(ren, assets.background[id]); dirty = false; }
+        if(!SDL_WaitEventTimeout(&e, SCENE_WAIT_MS)) continue;
+        do {
+            if(e.type==SDL_QUIT) return false;
+            if(e.type==SDL_MOUSEBUTTONDOWN && e.button.button==SDL_BUTTON_LEFT) return true;
+            if(e.type==SDL_WINDOWEVENT) dirty = true;
+        } while(SDL_PollEvent(&e));
+    }
+}
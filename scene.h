@@ -0,0 +1,22 @@
+#pragma once
+#include <SDL.h>
+#include <functional>
+
+// --- 画面（タイトル・チュートリアル） ---
+// 1枚絵を表示してクリックを待つだけの画面。画像は起動時に1回だけデコードして
+// テクスチャとして持っておき、待機中は SDL_WaitEventTimeout で眠る。
+// デコードは assets.cpp がスレッドプールで行い、届いたら uploadSceneImage で載せる。
+enum SceneId { SCENE_TITLE, SCENE_TUTORIAL, SCENE_COUNT };
+
+struct SceneAssets {
+    SDL_Texture* background[SCENE_COUNT] = {};
+};
+
+const char* sceneImagePath(SceneId id);
+// 描画スレッドから呼ぶ。surface は解放しない
+void uploadSceneImage(SDL_Renderer* ren, SceneAssets& assets, SceneId id, SDL_Surface* surface);
+void destroySceneAssets(SceneAssets& assets);
+
+// 左クリックで true、ウィンドウが閉じられたら false を返す。
+// pump は起きるたびに呼ばれ、true を返したら（画像が届いたなど）描き直す
+bool runScene(SDL_Renderer* ren, const SceneAssets& assets, SceneId id, const std::function<bool()>& pump);
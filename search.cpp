@@ -0,0 +1,465 @@
+#include "search.h"
+#include "eval.h"
+#include "flip.h"
+#include "tablebase.h"
+#include <chrono>
+#include <vector>
+#include <cstring>
+#include <atomic>
+#include <thread>
+#include <memory>
+#include <algorithm>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+const int QS_MAX_PLY = 8;        // 反転の応酬で静止探索が終わらないのを防ぐ
+
+// --- 手の並べ替え ---
+const int SORT_TT     = 1 << 30;
+const int SORT_GAIN   = 1 << 24;
+const int SORT_KILLER = 1 << 22;
+const int KING_GAIN   = 100000;
+
+// 駒の種類ごとの個数（色は問わない）。テーブルベースを引くのはこれがルートと変わった局面だけ
+template<class G>
+uint64_t materialKey(const BasicPosition<G>& pos){
+    uint64_t k = 0;
+    for(int t=QUEEN;t<=PAWN;t++) k |= uint64_t(popcount(pos.pieces[WHITE][t] | pos.pieces[BLACK][t])) << (8 * t);
+    return k;
+}
+
+// テーブルベースは 8x8 の表だけなので、他の盤では引かない
+bool probeTablebase(const Tablebases& tbs, const Position& pos, TbValue& v){ return tbs.probe(pos, v); }
+template<class G>
+bool probeTablebase(const Tablebases&, const BasicPosition<G>&, TbValue&){ return false; }
+
+// 表で勝ち負けが決まっていて片方がキングだけのとき、勝つ側がキングを盤の端へ追い、
+// 自分のキングを近づけるほど良いとする（表は勝ち負けしか持たないので、進み方は探索に任せる）
+template<class G>
+int mopUpBonus(const BasicPosition<G>& pos){
+    const int R = G::ROWS, C = G::COLS;
+    for(int strong=0;strong<2;strong++){
+        int weak = strong ^ 1;
+        if(pos.byColor[weak] != pos.pieces[weak][KING] || pos.byColor[strong] == pos.pieces[strong][KING]) continue;
+        if(!pos.pieces[weak][KING] || !pos.pieces[strong][KING]) return 0;
+        int wk = lsb(pos.pieces[weak][KING]), sk = lsb(pos.pieces[strong][KING]);
+        int wr = G::rowOf(wk), wc = G::colOf(wk), sr = G::rowOf(sk), sc = G::colOf(sk);
+        int edge = std::max(R / 2 - 1 - wr, wr - R / 2) + std::max(C / 2 - 1 - wc, wc - C / 2);
+        int dist = std::abs(wr - sr) + std::abs(wc - sc);
+        int bonus = 20 * edge + 10 * (R - 1 + C - 1 - dist);
+        return strong == pos.sideToMove ? bonus : -bonus;
+    }
+    return 0;
+}
+
+template<class G>
+struct ScoredMoves {
+    static constexpr int CAPACITY = BasicMoveList<G>::CAPACITY;
+    Move moves[CAPACITY];
+    int scores[CAPACITY];
+    int gains[CAPACITY];
+    int size = 0;
+
+    // 残りから最高点の手を i 番目に持ってくる
+    Move pick(int i){
+        int best = i;
+        for(int j=i+1;j<size;j++) if(scores[j] > scores[best]) best = j;
+        if(best != i){
+            std::swap(moves[i], moves[best]);
+            std::swap(scores[i], scores[best]);
+            std::swap(gains[i], gains[best]);
+        }
+        return moves[i];
+    }
+};
+
+// 取った駒 + 反転で相手から奪う駒（自分に加わるので2倍）+ 成り
+template<class G>
+int moveGain(const BasicPosition<G>& pos, Move m){
+    typedef typename G::Board Board;
+    int us = pos.sideToMove, them = us ^ 1;
+    int from = moveFrom(m), to = moveTo(m), flag = moveFlag(m);
+    int gain = 0;
+    int captured = pos.pieceAt(to);
+    if(captured == KING) return KING_GAIN;
+    if(captured != NO_PIECE) gain += PIECE_VALUE[captured];
+    if(flag == MF_EN_PASSANT) gain += PIECE_VALUE[PAWN];
+    if(flag == MF_PROMOTION) gain += PIECE_VALUE[QUEEN] - PIECE_VALUE[PAWN];
+
+    Board own = pos.byColor[us] ^ G::bit(from) ^ G::bit(to);
+    Board opp = pos.byColor[them] & ~G::bit(to);
+    Board flips = FlipKernel<G>::flips(to, own, opp);
+    if(flips){
+        if(flips & pos.pieces[them][KING]) return KING_GAIN;
+        for(int t=QUEEN;t<=PAWN;t++) gain += 2 * PIECE_VALUE[t] * popcount(flips & pos.pieces[them][t]);
+    }
+    return gain;
+}
+
+// 全スレッドで共有する探索状態
+struct SharedState {
+    Clock::time_point start;
+    std::atomic<bool> stop{false};
+    std::atomic<uint64_t> totalNodes{0};
+};
+
+// スレッドごとの反復深化の結果
+struct ThreadResult {
+    Move best = MOVE_NONE;
+    int score = 0;
+    int depth = 0;
+};
+
+template<class G>
+struct Searcher {
+    typedef BasicPosition<G> Position;
+    typedef BasicMoveList<G> MoveList;
+    typedef BasicLegalityChecker<G> LegalityChecker;
+    TranspositionTable& tt;
+    SearchLimits limits;
+    SharedState& shared;
+    int id;                      // 0 = メインスレッド（時間管理を担当）
+    bool stopped = false;
+    uint64_t nodes = 0;
+    uint64_t tbHits = 0;
+    uint64_t rootMaterial = 0;
+    MoveList rootMoves;          // 空でなければルートではこの手だけ読む（テーブルベースで選んだ手）
+    bool mopUp = false;          // ルートが表で勝ち負けの局面（評価に mopUpBonus を足す）
+
+    // 過去の対局 + 探索経路のキー（千日手判定用）
+    std::vector<uint64_t> keys;
+    int rootIndex = 0;
+
+    BasicUndo<G> undos[MAX_PLY];     // ply ごとの戻し記録（探索中はメモリを確保しない）
+    Accumulator accs[MAX_PLY + 1];   // ply ごとの評価アキュムレータ（指すたびに差分で更新）
+    Move killers[MAX_PLY][2];
+    int historyScore[2][G::SQUARES][G::SQUARES];
+
+    Searcher(TranspositionTable& t, const SearchLimits& l, SharedState& sh, int i)
+        : tt(t), limits(l), shared(sh), id(i) {
+        std::memset(killers, 0, sizeof(killers));
+        std::memset(historyScore, 0, sizeof(historyScore));
+    }
+
+    double elapsedMs() const {
+        return std::chrono::duration<double, std::milli>(Clock::now() - shared.start).count();
+    }
+
+    void checkLimits(){
+        if((nodes & 1023) != 0) return;
+        uint64_t total = shared.totalNodes.fetch_add(1024, std::memory_order_relaxed) + 1024;
+        if(id == 0){
+            if((limits.timeMs > 0 && elapsedMs() >= limits.timeMs) ||
+               (limits.maxNodes && total >= limits.maxNodes) ||
+               (limits.stop && limits.stop->load(std::memory_order_relaxed)))
+                shared.stop.store(true, std::memory_order_relaxed);
+        }
+        if(shared.stop.load(std::memory_order_relaxed)) stopped = true;
+    }
+
+    bool isRepetition(const Position& pos, int ply) const {
+        int idx = rootIndex + ply;
+        int stop = idx - pos.halfMoveClock;
+        if(stop < 0) stop = 0;
+        for(int i = idx - 2; i >= stop; i -= 2)
+            if(keys[i] == pos.key) return true;
+        return false;
+    }
+
+    // 詰みとテーブルベースの勝ち負けは ply に依存するので、置換表にはその節点からの値で入れる
+    static int toTT(int score, int ply){
+        if(score > SCORE_TB_WIN - MAX_PLY) return score + ply;
+        if(score < -SCORE_TB_WIN + MAX_PLY) return score - ply;
+        return score;
+    }
+    static int fromTT(int score, int ply){
+        if(score > SCORE_TB_WIN - MAX_PLY) return score - ply;
+        if(score < -SCORE_TB_WIN + MAX_PLY) return score + ply;
+        return score;
+    }
+
+    void scoreMoves(const Position& pos, const MoveList& list, ScoredMoves<G>& sm, Move ttMove, int ply){
+        int us = pos.sideToMove;
+        sm.size = 0;
+        for(Move m : list){
+            int gain = moveGain(pos, m);
+            int s;
+            if(m == ttMove) s = SORT_TT;
+            else if(gain > 0) s = SORT_GAIN + gain * 8 - PIECE_VALUE[pos.pieceAt(moveFrom(m))] / 16;
+            else if(ply < MAX_PLY && m == killers[ply][0]) s = SORT_KILLER + 1;
+            else if(ply < MAX_PLY && m == killers[ply][1]) s = SORT_KILLER;
+            else s = historyScore[us][moveFrom(m)][moveTo(m)];
+            sm.moves[sm.size] = m;
+            sm.scores[sm.size] = s;
+            sm.gains[sm.size] = gain;
+            sm.size++;
+        }
+    }
+
+    // --- 静止探索: 取り・反転・成りだけを読む ---
+    int qsearch(Position& pos, int alpha, int beta, int ply, int qply){
+        if(isGameOver(pos)) return -SCORE_MATE + ply;
+        nodes++;
+        checkLimits();
+        if(stopped) return 0;
+
+        // チェックされていれば詰みかどうかだけ先に確かめる（合法な逃げ手が1つあれば足りる）
+        LegalityChecker legal(pos);
+        MoveList list;
+        if(legal.inCheck()){
+            generatePseudoMoves(pos, list);
+            const Move* m = list.begin();
+            while(m != list.end() && !legal.isLegal(*m)) m++;
+            if(m == list.end()) return -SCORE_MATE + ply;
+        }
+
+        int standPat = evaluate(pos, accs[ply]);
+        if(mopUp) standPat += mopUpBonus(pos);
+        if(standPat >= beta) return standPat;
+        if(qply >= QS_MAX_PLY || ply >= MAX_PLY - 1) return standPat;
+        if(standPat > alpha) alpha = standPat;
+
+        // 合法かどうかは実際に読む手だけ調べる
+        if(!legal.inCheck()) generatePseudoMoves(pos, list);
+        ScoredMoves<G> sm;
+        scoreMoves(pos, list, sm, MOVE_NONE, MAX_PLY);
+
+        for(int i=0;i<sm.size;i++){
+            Move m = sm.pick(i);
+            if(sm.gains[i] <= 0) break;       // 並べ替え済みなので以降は静かな手
+            if(!legal.isLegal(m)) continue;
+            makeMove(pos, m, undos[ply]);
+            updateAccumulator(accs[ply], pos, undos[ply], accs[ply + 1]);
+            keys[rootIndex + ply + 1] = pos.key;
+            int score = -qsearch(pos, -beta, -alpha, ply + 1, qply + 1);
+            unmakeMove(pos, undos[ply]);
+            if(stopped) return 0;
+            if(score >= beta) return score;
+            if(score > alpha) alpha = score;
+        }
+        return alpha;
+    }
+
+    static bool hasPieces(const Position& pos, int color){
+        return bool(pos.pieces[color][QUEEN] | pos.pieces[color][ROOK] |
+                    pos.pieces[color][BISHOP] | pos.pieces[color][KNIGHT]);
+    }
+
+    // --- negamax アルファベータ ---
+    int negamax(Position& pos, int depth, int alpha, int beta, int ply, bool allowNull, Move* bestOut){
+        if(isGameOver(pos)) return -SCORE_MATE + ply;      // キングを取られた／反転された
+        if(ply > 0 && (isFiftyMoveDraw(pos) || isRepetition(pos, ply))) return 0;
+        // 取る・成るで駒の組が変わった先だけ表を引く。ルートと同じ組で引くと勝ちの手が
+        // どれも同じ値になり、キングを取りに行かずに同じ所を回ってしまう
+        TbValue tbv;
+        if(ply > 0 && limits.tablebases && materialKey(pos) != rootMaterial && probeTablebase(*limits.tablebases, pos, tbv)){
+            tbHits++;
+            return tbv == TB_WIN ? SCORE_TB_WIN - ply : tbv == TB_LOSS ? -SCORE_TB_WIN + ply : 0;
+        }
+        if(depth <= 0 || ply >= MAX_PLY - 1) return qsearch(pos, alpha, beta, ply, 0);
+
+        nodes++;
+        checkLimits();
+        if(stopped) return 0;
+
+        bool pvNode = beta - alpha > 1;
+        TTData tte;
+        Move ttMove = MOVE_NONE;
+        if(tt.probe(pos.key, tte)){
+            ttMove = tte.move;
+            int s = fromTT(tte.score, ply);
+            if(ply > 0 && !pvNode && tte.depth >= depth){
+                if(tte.bound == BOUND_EXACT) return s;
+                if(tte.bound == BOUND_LOWER && s >= beta) return s;
+                if(tte.bound == BOUND_UPPER && s <= alpha) return s;
+            }
+        }
+
+        LegalityChecker legal(pos);
+
+        // --- ヌルムーブ枝刈り ---
+        if(allowNull && !pvNode && ply > 0 && depth >= 3 && !legal.inCheck()
+           && hasPieces(pos, pos.sideToMove) && evaluate(pos, accs[ply]) >= beta){
+            makeNullMove(pos, undos[ply]);
+            accs[ply + 1] = accs[ply];
+            keys[rootIndex + ply + 1] = pos.key;
+            int r = depth >= 6 ? 3 : 2;
+            int score = -negamax(pos, depth - 1 - r, -beta, -beta + 1, ply + 1, false, nullptr);
+            unmakeNullMove(pos, undos[ply]);
+            if(stopped) return 0;
+            if(score >= beta && !isMateScore(score)) return beta;
+        }
+
+        MoveList list;
+        generatePseudoMoves(pos, list);
+        ScoredMoves<G> sm;
+        scoreMoves(pos, list, sm, ttMove, ply);
+
+        int us = pos.sideToMove;
+        int bestScore = -SCORE_INF;
+        Move best = MOVE_NONE;
+        int origAlpha = alpha;
+        int searched = 0;            // 読んだ合法手の数（LMR の順位にも使う）
+
+        for(int i=0;i<sm.size;i++){
+            Move m = sm.pick(i);
+            if(!legal.isLegal(m)) continue;
+            if(ply == 0 && rootMoves.size && std::find(rootMoves.begin(), rootMoves.end(), m) == rootMoves.end()) continue;
+            bool quiet = sm.gains[i] == 0;
+            makeMove(pos, m, undos[ply]);
+            updateAccumulator(accs[ply], pos, undos[ply], accs[ply + 1]);
+            keys[rootIndex + ply + 1] = pos.key;
+
+            int score;
+            int n = searched++;
+            if(n == 0){
+                score = -negamax(pos, depth - 1, -beta, -alpha, ply + 1, true, nullptr);
+            } else {
+                // 後ろの静かな手は浅く読んでから必要なら読み直す（LMR + PVS）
+                int reduction = 0;
+                if(quiet && depth >= 3 && n >= 3 && sm.scores[i] < SORT_KILLER)
+                    reduction = n >= 8 ? 2 : 1;
+                score = -negamax(pos, depth - 1 - reduction, -alpha - 1, -alpha, ply + 1, true, nullptr);
+                if(score > alpha && reduction)
+                    score = -negamax(pos, depth - 1, -alpha - 1, -alpha, ply + 1, true, nullptr);
+                if(score > alpha && score < beta)
+                    score = -negamax(pos, depth - 1, -beta, -alpha, ply + 1, true, nullptr);
+            }
+            unmakeMove(pos, undos[ply]);
+            if(stopped) return 0;
+
+            if(score > bestScore){
+                bestScore = score;
+                best = m;
+                if(score > alpha){
+                    alpha = score;
+                    if(score >= beta){
+                        if(quiet){
+                            if(killers[ply][0] != m){
+                                killers[ply][1] = killers[ply][0];
+                                killers[ply][0] = m;
+                            }
+                            int& h = historyScore[us][moveFrom(m)][moveTo(m)];
+                            h += depth * depth;
+                            if(h > SORT_KILLER / 2) h /= 2;
+                        }
+                        break;
+                    }
+                }
+            }
+        }
+        if(searched == 0) return legal.inCheck() ? -SCORE_MATE + ply : 0;     // チェックメイト／ステイルメイト
+
+        int bound = bestScore >= beta ? BOUND_LOWER : bestScore > origAlpha ? BOUND_EXACT : BOUND_UPPER;
+        tt.store(pos.key, best, toTT(bestScore, ply), depth, bound);
+        if(bestOut) *bestOut = best;
+        return bestScore;
+    }
+
+    // --- 反復深化 ---
+    // ヘルパースレッドは奇数番が1手深くから始めて、メインと深さをずらす
+    void iterate(const Position& root, ThreadResult& out){
+        Position pos = root;
+        refreshAccumulator(pos, accs[0]);
+        for(int depth = 1 + (id & 1); depth<=limits.maxDepth && depth < MAX_PLY; depth++){
+            Move best = MOVE_NONE;
+            int score = negamax(pos, depth, -SCORE_INF, SCORE_INF, 0, false, &best);
+            if(stopped) break;
+            out.best = best;
+            out.score = score;
+            out.depth = depth;
+            if(id != 0) continue;
+            // 勝ち負けが読み切れたか、次の反復が間に合いそうにないなら打ち切る
+            if(isMateScore(score)) break;
+            if(limits.timeMs > 0 && elapsedMs() > limits.timeMs * 0.5) break;
+        }
+    }
+};
+
+// ルートが表にあれば、各手の先を引いて結果が最善の手だけを残す（表にない先は引き分け扱い）。
+// 読むのはその中だけなので、同じ駒の組の局面を引かなくても勝ちを手放さない
+bool tablebaseRootMoves(const Tablebases& tbs, const Position& root, const MoveList& moves, MoveList& out, TbValue& v){
+    out.size = 0;
+    if(!tbs.probe(root, v)) return false;
+    int rank[MAX_MOVES], best = 0;
+    for(int i=0;i<moves.size;i++){
+        Position child = root;
+        makeMove(child, moves.moves[i]);
+        TbValue cv;
+        rank[i] = isGameOver(child) ? 2 : !tbs.probe(child, cv) ? 1 : cv == TB_LOSS ? 2 : cv == TB_DRAW ? 1 : 0;
+        best = std::max(best, rank[i]);
+    }
+    for(int i=0;i<moves.size;i++) if(rank[i] == best) out.push(moves.moves[i]);
+    return true;
+}
+template<class G>
+bool tablebaseRootMoves(const Tablebases&, const BasicPosition<G>&, const BasicMoveList<G>&, BasicMoveList<G>& out, TbValue&){
+    out.size = 0;
+    return false;
+}
+
+}
+
+template<class G>
+SearchResult searchBestMove(TranspositionTable& tt, const BasicPosition<G>& root,
+                            const GameHistory& history, const SearchLimits& limits){
+    SearchResult result;
+    BasicMoveList<G> rootMoves;
+    generateMoves(root, rootMoves);
+    if(rootMoves.size == 0 || isGameOver(root)) return result;
+    BasicMoveList<G> tbMoves;
+    TbValue rootValue;
+    bool decided = limits.tablebases && tablebaseRootMoves(*limits.tablebases, root, rootMoves, tbMoves, rootValue)
+                   && rootValue != TB_DRAW;
+    result.best = tbMoves.size ? tbMoves.moves[0] : rootMoves.moves[0];
+
+    SharedState shared;
+    shared.start = Clock::now();
+    tt.newSearch();
+
+    int n = limits.threads > 1 ? limits.threads : 1;
+    std::vector<std::unique_ptr<Searcher<G>>> workers;
+    for(int i=0;i<n;i++){
+        auto w = std::make_unique<Searcher<G>>(tt, limits, shared, i);
+        w->keys.assign(history.keys.begin(), history.keys.end());
+        if(w->keys.empty() || w->keys.back() != root.key) w->keys.push_back(root.key);
+        w->rootIndex = (int)w->keys.size() - 1;
+        w->keys.resize(w->keys.size() + MAX_PLY + 1);
+        w->rootMaterial = materialKey(root);
+        w->rootMoves = tbMoves;
+        w->mopUp = decided;
+        workers.push_back(std::move(w));
+    }
+
+    std::vector<ThreadResult> results(n);
+    std::vector<std::thread> helpers;
+    for(int i=1;i<n;i++)
+        helpers.emplace_back([&, i]{ workers[i]->iterate(root, results[i]); });
+    workers[0]->iterate(root, results[0]);
+    shared.stop.store(true, std::memory_order_relaxed);
+    for(auto& t : helpers) t.join();
+
+    // メインスレッドの結果を基本に、より深く読み終えたヘルパーがいればそちらを採る
+    const ThreadResult* chosen = &results[0];
+    for(auto& r : results)
+        if(r.best && r.depth > chosen->depth) chosen = &r;
+    if(chosen->best){
+        result.best = chosen->best;
+        result.score = chosen->score;
+        result.depth = chosen->depth;
+    }
+
+    for(auto& w : workers){
+        result.threadNodes.push_back(w->nodes);
+        result.nodes += w->nodes;
+        result.tbHits += w->tbHits;
+    }
+    result.seconds = workers[0]->elapsedMs() / 1000.0;
+    return result;
+}
+
+#define INSTANTIATE_SEARCH(G) \
+    template SearchResult searchBestMove(TranspositionTable&, const BasicPosition<G>&, const GameHistory&, const SearchLimits&);
+FOR_EACH_GEOMETRY(INSTANTIATE_SEARCH)
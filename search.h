@@ -0,0 +1,46 @@
+#pragma once
+#include "position.h"
+#include "history.h"
+#include "tt.h"
+#include <vector>
+#include <atomic>
+
+// --- 探索（反復深化 + negamax アルファベータ） ---
+const int SCORE_INF  = 32000;
+const int SCORE_MATE = 31000;    // 勝ち = SCORE_MATE - ply
+const int MAX_PLY    = 128;
+// テーブルベースで決まった勝ち = SCORE_TB_WIN - ply（詰みの手数ではないので読み切り扱いにしない）
+const int SCORE_TB_WIN = SCORE_MATE - 2 * MAX_PLY;
+
+inline bool isMateScore(int s){ return s > SCORE_MATE - MAX_PLY || s < -SCORE_MATE + MAX_PLY; }
+
+// 手を決めるエンジン（mcts.h の mctsBestMove も同じ SearchLimits / SearchResult を使う）
+enum EngineKind { ENGINE_ALPHABETA, ENGINE_MCTS };
+
+class Tablebases;
+
+struct SearchLimits {
+    int maxDepth = 64;
+    int timeMs = 300;            // 1手あたりの持ち時間（0 = 無制限）
+    uint64_t maxNodes = 0;       // 0 = 無制限（全スレッドの合計）
+    int threads = 1;             // Lazy SMP のスレッド数
+    const std::atomic<bool>* stop = nullptr;   // 外部からの中断要求（GUI の手が進んだときなど）
+    EngineKind engine = ENGINE_ALPHABETA;      // AsyncEngine がどちらで探索するか
+    const Tablebases* tablebases = nullptr;    // ルートの手を表で絞り、取る・成る先は読まずに表を引く（alpha-beta、8x8 のみ）
+};
+
+struct SearchResult {
+    Move best = MOVE_NONE;
+    int score = 0;
+    int depth = 0;               // 最後に完了した反復の深さ
+    uint64_t nodes = 0;
+    uint64_t tbHits = 0;         // テーブルベースで打ち切った節点
+    std::vector<uint64_t> threadNodes;   // スレッドごとの節点数（[0] がメインスレッド）
+    double seconds = 0;
+};
+
+// threads > 1 のときは同じルートを全スレッドで探索し、置換表だけを共有する。
+// 盤の大きさごとに実体化する（テーブルベースは 8x8 のときだけ引く）
+template<class G>
+SearchResult searchBestMove(TranspositionTable& tt, const BasicPosition<G>& root,
+                            const GameHistory& history, const SearchLimits& limits);
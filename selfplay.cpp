@@ -0,0 +1,290 @@
+// --- selfplay: コンピュータ同士の対局を並列で大量に行い、バイナリ記録に書き出す（SDL 不要） ---
+// 使い方:
+//   selfplay [--games N] [--threads T] [--nodes N | --movetime ms | --depth D] [--hash MB]
+//            [--seed S] [--random-plies K] [--max-plies P] [--book db] [--out file]
+//            [--engine ab|mcts] [--versus ab|mcts] [--playouts N] [--tb dir] [--board N]
+//   selfplay --verify file     記録を再生してルールと結果が一致するか確かめる
+// 1対局を1タスクとしてワークスティーリングのプールに投げる。各対局は自分専用の置換表と
+// 1スレッドの探索を使うので、--nodes 指定なら同じシードで同じ棋譜になる。
+// --versus を付けると --engine と先後を1局ごとに入れ替えて対戦させ、勝率と探索速度を比べる。
+// MCTS の持ち時間は --playouts（既定）か --movetime（両エンジン共通）で決める。
+// --tb を付けるとアルファベータ探索が終盤テーブルベースを引く（MCTS は引かない）。
+// --board で 10x10 / 12x12 の盤で対局する（定跡とテーブルベースは 8x8 だけ）。
+#include "search.h"
+#include "mcts.h"
+#include "gamerecord.h"
+#include "thread_pool.h"
+#include "gamedb.h"
+#include "tablebase.h"
+#include "zobrist.h"
+#include "attacks.h"
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <cstdlib>
+#include <chrono>
+#include <atomic>
+#include <mutex>
+
+struct SelfplayOptions {
+    int games = 100;
+    int threads = 0;
+    SearchLimits limits;
+    SearchLimits mctsLimits;     // maxNodes はプレイアウト数
+    EngineKind engines[2] = { ENGINE_ALPHABETA, ENGINE_ALPHABETA };   // [0] = --engine, [1] = --versus
+    bool match = false;
+    int hashMb = 4;
+    uint64_t seed = 1;
+    int randomPlies = 4;        // 序盤の数手はランダムに指して対局をばらけさせる
+    int maxPlies = 400;
+    int boardSize = 8;
+    std::string out;
+    const GameDb* book = nullptr;    // 定跡にある局面では探索しない
+};
+
+static const char* engineName(EngineKind e){ return e == ENGINE_MCTS ? "mcts" : "ab"; }
+
+// 探索した手の数と節点数（MCTS はプレイアウト数）。[0] = --engine, [1] = --versus
+struct EngineStats {
+    uint64_t moves = 0;
+    uint64_t nodes = 0;
+    double seconds = 0;
+};
+
+struct GameStats {
+    EngineStats engines[2];
+    int whiteSlot = 0;           // 白を持ったエンジン
+};
+
+template<class G>
+static GameRecord playGame(const SelfplayOptions& opt, uint32_t index, GameStats& stats){
+    GameRecord rec;
+    rec.index = index;
+    rec.boardSize = uint8_t(G::ROWS);
+    uint64_t rng = opt.seed * 0x9E3779B97F4A7C15ULL + index;
+    rec.seed = splitmix64(rng);
+
+    TranspositionTable tt(opt.hashMb);
+    BasicPosition<G> pos;
+    setStartPosition(pos);
+    GameHistory history;
+    history.reset(pos);
+    rec.moves.reserve(opt.maxPlies);
+    stats.whiteSlot = opt.match ? int(index & 1) : 0;
+
+    for(int ply=0;;ply++){
+        if(ply >= opt.maxPlies){ rec.termination = TERM_MAX_PLIES; rec.result = RESULT_DRAW; break; }
+        BasicMoveList<G> list;
+        generateMoves(pos, list);
+        if(list.size == 0){ rec.termination = TERM_NO_MOVES; rec.result = RESULT_DRAW; break; }
+
+        Move mv = MOVE_NONE;
+        if(ply < opt.randomPlies) mv = list.moves[splitmix64(rng) % list.size];
+        else if(opt.book) mv = pickBookMove(*opt.book, pos, splitmix64(rng) | 1);
+        if(!mv){
+            int slot = pos.sideToMove == WHITE ? stats.whiteSlot : stats.whiteSlot ^ 1;
+            SearchResult r;
+            if(opt.engines[slot] == ENGINE_MCTS) r = mctsBestMove(pos, history, opt.mctsLimits);
+            else {
+                tt.newSearch();
+                r = searchBestMove(tt, pos, history, opt.limits);
+            }
+            EngineStats& es = stats.engines[slot];
+            es.moves++;
+            es.nodes += r.nodes;
+            es.seconds += r.seconds;
+            mv = r.best;
+            if(!mv) mv = list.moves[0];
+        }
+
+        BasicMoveInfo<G> info;
+        int mover = pos.sideToMove;
+        makeMove(pos, mv, &info);
+        history.push(pos);
+        rec.moves.push_back(mv);
+        Termination t = terminationAfter(pos, history, info);
+        if(t != TERM_NONE){ rec.termination = t; rec.result = resultOf(t, mover); break; }
+    }
+    return rec;
+}
+
+static int verifyFile(const std::string& path){
+    FILE* f = std::fopen(path.c_str(), "rb");
+    if(!f){ std::cerr << "cannot open " << path << "\n"; return 1; }
+    GameRecord rec;
+    uint64_t games = 0, plies = 0, bad = 0;
+    while(readGameRecord(f, rec)){
+        std::string err;
+        bool ok = withGeometry(rec.boardSize, [&](auto g){
+            BasicPosition<decltype(g)> pos;
+            return replayGameRecord(rec, pos, &err);
+        });
+        if(!ok){
+            std::cout << "game " << rec.index << ": " << err << "\n";
+            bad++;
+        }
+        games++;
+        plies += rec.moves.size();
+    }
+    bool trailing = !std::feof(f);
+    std::fclose(f);
+    if(trailing){ std::cout << "corrupt record after game " << games << "\n"; bad++; }
+    std::cout << games << " games, " << plies << " plies, " << bad << " errors\n";
+    return bad ? 1 : 0;
+}
+
+int main(int argc, char* argv[]){
+    initAttacks();
+    SelfplayOptions opt;
+    std::string bookPath, tbDir;
+    opt.limits.threads = 1;
+    opt.limits.timeMs = 0;
+    opt.limits.maxNodes = 5000;
+    opt.mctsLimits.threads = 1;
+    opt.mctsLimits.timeMs = 0;
+    opt.mctsLimits.maxNodes = 2000;
+    for(int i=1;i<argc;i++){
+        std::string a = argv[i];
+        if(a == "--verify" && i+1 < argc) return verifyFile(argv[++i]);
+        else if(a == "--games" && i+1 < argc) opt.games = std::atoi(argv[++i]);
+        else if(a == "--threads" && i+1 < argc) opt.threads = std::atoi(argv[++i]);
+        else if(a == "--nodes" && i+1 < argc){ opt.limits.maxNodes = std::strtoull(argv[++i], nullptr, 10); opt.limits.timeMs = 0; }
+        else if(a == "--movetime" && i+1 < argc){
+            opt.limits.timeMs = opt.mctsLimits.timeMs = std::atoi(argv[++i]);
+            opt.limits.maxNodes = opt.mctsLimits.maxNodes = 0;
+        }
+        else if(a == "--depth" && i+1 < argc){ opt.limits.maxDepth = std::atoi(argv[++i]); opt.limits.maxNodes = 0; opt.limits.timeMs = 0; }
+        else if(a == "--hash" && i+1 < argc) opt.hashMb = std::atoi(argv[++i]);
+        else if(a == "--seed" && i+1 < argc) opt.seed = std::strtoull(argv[++i], nullptr, 10);
+        else if(a == "--random-plies" && i+1 < argc) opt.randomPlies = std::atoi(argv[++i]);
+        else if(a == "--max-plies" && i+1 < argc) opt.maxPlies = std::atoi(argv[++i]);
+        else if(a == "--out" && i+1 < argc) opt.out = argv[++i];
+        else if(a == "--book" && i+1 < argc) bookPath = argv[++i];
+        else if(a == "--tb" && i+1 < argc) tbDir = argv[++i];
+        else if(a == "--board" && i+1 < argc) opt.boardSize = std::atoi(argv[++i]);
+        else if(a == "--playouts" && i+1 < argc){ opt.mctsLimits.maxNodes = std::strtoull(argv[++i], nullptr, 10); opt.mctsLimits.timeMs = 0; }
+        else if((a == "--engine" || a == "--versus") && i+1 < argc){
+            std::string e = argv[++i];
+            if(e != "ab" && e != "mcts"){ std::cerr << "unknown engine " << e << "\n"; return 1; }
+            opt.engines[a == "--engine" ? 0 : 1] = e == "mcts" ? ENGINE_MCTS : ENGINE_ALPHABETA;
+            if(a == "--versus") opt.match = true;
+            else if(!opt.match) opt.engines[1] = opt.engines[0];
+        }
+        else {
+            std::cerr << "usage: selfplay [--games N] [--threads T] [--nodes N | --movetime ms | --depth D] [--hash MB]\n"
+                         "                [--seed S] [--random-plies K] [--max-plies P] [--book db] [--out file]\n"
+                         "                [--engine ab|mcts] [--versus ab|mcts] [--playouts N] [--tb dir] [--board N]\n"
+                         "       selfplay --verify file\n";
+            return 1;
+        }
+    }
+
+    if(!isBoardSize(opt.boardSize)){ std::cerr << "board size must be 8, 10 or 12\n"; return 1; }
+    if(opt.boardSize != 8 && (!bookPath.empty() || !tbDir.empty())){
+        std::cerr << "--book and --tb are only available on the 8x8 board\n";
+        return 1;
+    }
+
+    GameDb book;
+    if(!bookPath.empty()){
+        std::string err;
+        if(!book.open(bookPath, &err)){ std::cerr << err << "\n"; return 1; }
+        opt.book = &book;
+    }
+    Tablebases tablebases;
+    if(!tbDir.empty()){
+        std::string err;
+        if(tablebases.open(tbDir, &err) == 0){ std::cerr << (err.empty() ? "no tables in " + tbDir : err) << "\n"; return 1; }
+        opt.limits.tablebases = &tablebases;
+    }
+
+    ThreadPool pool(opt.threads);
+    std::vector<GameRecord> records(opt.games);
+    std::vector<GameStats> stats(opt.games);
+    std::atomic<int> finished{0};
+    std::mutex printMutex;
+    auto start = std::chrono::steady_clock::now();
+    auto secondsSince = [&]{ return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(); };
+
+    for(int g=0;g<opt.games;g++)
+        pool.submit([&, g]{
+            records[g] = withGeometry(opt.boardSize, [&](auto geo){
+                return playGame<decltype(geo)>(opt, (uint32_t)g, stats[g]);
+            });
+            int done = ++finished;
+            if(done % 100 == 0){
+                std::lock_guard<std::mutex> lk(printMutex);
+                std::cerr << done << "/" << opt.games << " games, "
+                          << std::fixed << std::setprecision(1) << done / secondsSince() << " games/s\n";
+            }
+        });
+    pool.wait();
+    double secs = secondsSince();
+
+    // --- 集計と書き出し（対局番号順なので同じ設定なら同じファイルになる） ---
+    uint64_t plies = 0, bytes = 0;
+    int wins[3] = {0, 0, 0};
+    int terms[TERM_STALEMATE + 1] = {};
+    std::vector<uint8_t> buf;
+    for(const GameRecord& r : records){
+        plies += r.moves.size();
+        if(r.result <= RESULT_DRAW) wins[r.result]++;
+        terms[r.termination]++;
+        encodeGameRecord(r, buf);
+    }
+    bytes = buf.size();
+    if(!opt.out.empty()){
+        FILE* f = std::fopen(opt.out.c_str(), "wb");
+        if(!f || std::fwrite(buf.data(), 1, buf.size(), f) != buf.size()){
+            std::cerr << "cannot write " << opt.out << "\n";
+            if(f) std::fclose(f);
+            return 1;
+        }
+        std::fclose(f);
+    }
+
+    std::cout << opt.games << " games on " << pool.size() << " threads in "
+              << std::fixed << std::setprecision(2) << secs << "s  ("
+              << std::setprecision(1) << opt.games / secs << " games/s, "
+              << (uint64_t)(plies / secs) << " moves/s)\n";
+    std::cout << "white " << wins[RESULT_WHITE_WINS] << "  black " << wins[RESULT_BLACK_WINS]
+              << "  draw " << wins[RESULT_DRAW] << "  avg plies "
+              << std::setprecision(1) << (opt.games ? double(plies) / opt.games : 0) << "\n";
+    for(int t=TERM_KING_CAPTURED;t<=TERM_STALEMATE;t++)
+        if(terms[t]) std::cout << "  " << terminationName(Termination(t)) << ": " << terms[t] << "\n";
+
+    // --- エンジンごとの探索速度と、対戦なら --engine 側から見た成績 ---
+    EngineStats total[2];
+    int score[3] = {0, 0, 0};    // --engine 側の勝ち・引き分け・負け
+    for(int g=0;g<opt.games;g++){
+        for(int s=0;s<2;s++){
+            total[s].moves += stats[g].engines[s].moves;
+            total[s].nodes += stats[g].engines[s].nodes;
+            total[s].seconds += stats[g].engines[s].seconds;
+        }
+        GameResult r = records[g].result;
+        if(r == RESULT_DRAW || r == RESULT_UNFINISHED) score[1]++;
+        else score[(r == RESULT_WHITE_WINS) == (stats[g].whiteSlot == 0) ? 0 : 2]++;
+    }
+    // 対戦でなければ両方の枠は同じエンジン（先後で分かれているだけ）なのでまとめる
+    if(!opt.match){
+        total[0].moves += total[1].moves;
+        total[0].nodes += total[1].nodes;
+        total[0].seconds += total[1].seconds;
+    }
+    for(int s=0;s<(opt.match ? 2 : 1);s++){
+        const EngineStats& e = total[s];
+        std::cout << engineName(opt.engines[s]) << ": " << e.moves << " searches, "
+                  << (opt.engines[s] == ENGINE_MCTS ? "playouts/s " : "nodes/s ")
+                  << (uint64_t)(e.seconds > 0 ? e.nodes / e.seconds : 0) << ", avg "
+                  << (e.moves ? e.nodes / e.moves : 0) << " per move\n";
+    }
+    if(opt.match)
+        std::cout << engineName(opt.engines[0]) << " vs " << engineName(opt.engines[1]) << ": +"
+                  << score[0] << " =" << score[1] << " -" << score[2] << "  ("
+                  << std::setprecision(1) << (opt.games ? 100.0 * (score[0] + 0.5 * score[1]) / opt.games : 0)
+                  << "%)\n";
+    std::cout << "records " << bytes << " bytes (" << std::setprecision(2)
+              << (plies ? double(bytes) / plies : 0) << " bytes/ply)\n";
+    return 0;
+}
@@ -0,0 +1,497 @@
+// --- server: TCP で多数の対局を同時に受け持つヘッドレスサーバ（Linux / epoll、SDL 不要） ---
+// 使い方:
+//   server [--port P] [--bind addr] [--max-games N] [--engine-threads T] [--nodes N | --movetime ms]
+//          [--hash MB] [--seconds S] [--board N]
+// 1行1コマンドのテキストプロトコル（gid は NEW が返す対局番号）:
+//   NEW [ai]            -> NEW <gid> <局面>             ai なら黒をサーバのエンジンが持つ
+//   MOVE <gid> <手>     -> OK <gid> <状態>  または  ERR <gid> <理由>
+//                          エンジン相手なら続けて  AI <gid> <手> <状態>
+//   BOARD <gid>         -> BOARD <gid> <局面> <状態>
+//   MOVES <gid>         -> MOVES <gid> <手>...
+//   END <gid>           -> END <gid>
+// 局面は serializeBoard の文字列（--board N なら N*N+1 文字、既定の 8x8 は65文字）、
+// 状態は play / white / black / draw（勝った側か引き分け）。
+// 対局は起動時に確保した固定長の配列（GamePool）から貸し出し、終わったら空きリストに戻す。
+// エンジンの探索はスレッドプールで行い、結果は eventfd でイベントループに知らせる。
+#include "search.h"
+#include "gamerecord.h"
+#include "thread_pool.h"
+#include "attacks.h"
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <cstdlib>
+#include <csignal>
+#include <cerrno>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/resource.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+struct ServerOptions {
+    int port = 7777;
+    std::string bind = "127.0.0.1";
+    int maxGames = 16384;
+    int engineThreads = 0;
+    SearchLimits limits;
+    int hashMb = 2;
+    int seconds = 0;             // 0 = SIGINT まで
+    int boardSize = 8;           // 全対局で共通の盤
+};
+
+const int MAX_LINE = 256;        // これより長い行は切断する
+const int MAX_GAME_PLIES = 400;  // 超えたら引き分け
+static_assert(MAX_GAME_PLIES + 1 <= HISTORY_RESERVE, "game slots reserve their whole history up front");
+
+static std::atomic<bool> quitRequested{false};
+
+// --- 対局の貸し出し ---
+// gid = 世代 << 20 | 添字。返却のたびに世代を進めるので、古い gid や
+// 返却後に届いたエンジンの結果は find で弾かれる
+template<class G>
+struct GameSlot {
+    BasicPosition<G> pos;
+    GameHistory history;
+    uint32_t generation = 0;
+    int owner = -1;              // 持ち主の接続（fd）
+    int plies = 0;
+    int aiColor = NO_COLOR;
+    bool aiThinking = false;
+    bool inUse = false;
+    GameResult result = RESULT_UNFINISHED;
+};
+
+template<class G>
+class GamePool {
+public:
+    explicit GamePool(int capacity) : slots(capacity) {
+        freeList.reserve(capacity);
+        for(int i=capacity-1;i>=0;i--) freeList.push_back(uint32_t(i));
+        for(GameSlot<G>& s : slots) s.history.keys.reserve(HISTORY_RESERVE);
+    }
+    // 空きがなければ 0（gid は世代が 1 以上なので 0 にならない）
+    uint32_t acquire(int owner){
+        if(freeList.empty()) return 0;
+        uint32_t i = freeList.back();
+        freeList.pop_back();
+        GameSlot<G>& s = slots[i];
+        s.generation = (s.generation + 1) & 0xFFF;
+        if(s.generation == 0) s.generation = 1;
+        s.owner = owner;
+        s.plies = 0;
+        s.aiColor = NO_COLOR;
+        s.aiThinking = false;
+        s.inUse = true;
+        s.result = RESULT_UNFINISHED;
+        setStartPosition(s.pos);
+        s.history.reset(s.pos);
+        return s.generation << 20 | i;
+    }
+    void release(uint32_t gid){
+        GameSlot<G>* s = find(gid);
+        if(!s) return;
+        s->inUse = false;
+        s->owner = -1;
+        freeList.push_back(gid & 0xFFFFF);
+    }
+    GameSlot<G>* find(uint32_t gid){
+        uint32_t i = gid & 0xFFFFF;
+        if(i >= slots.size()) return nullptr;
+        GameSlot<G>& s = slots[i];
+        return s.inUse && s.generation == gid >> 20 ? &s : nullptr;
+    }
+    int active() const { return int(slots.size() - freeList.size()); }
+private:
+    std::vector<GameSlot<G>> slots;
+    std::vector<uint32_t> freeList;
+};
+
+// --- 接続 ---
+struct Connection {
+    int fd = -1;
+    std::string in, out;
+    std::vector<uint32_t> games;      // この接続が持っている対局（切断時に返却する）
+    bool wantWrite = false;
+};
+
+// エンジンの結果（ワーカー → イベントループ）
+struct EngineDone {
+    uint32_t gid;
+    Move move;
+};
+
+template<class G>
+class Server {
+public:
+    explicit Server(const ServerOptions& o) : opt(o), games(o.maxGames), pool(o.engineThreads) {
+        for(int i=0;i<pool.size();i++) tts.push_back(std::make_unique<TranspositionTable>(opt.hashMb));
+    }
+    ~Server(){
+        stopping.store(true);
+        pool.wait();
+        for(auto& c : conns) if(c) ::close(c->fd);
+        if(listenFd >= 0) ::close(listenFd);
+        if(wakeFd >= 0) ::close(wakeFd);
+        if(epfd >= 0) ::close(epfd);
+    }
+    bool start(std::string& err);
+    void run();
+
+private:
+    void accept();
+    void readFrom(Connection& c);
+    void handleLine(Connection& c, const char* line, size_t len);
+    void flush(Connection& c);
+    void closeConnection(int fd);
+    void applyMove(GameSlot<G>& g, Move mv);
+    void startEngine(uint32_t gid, GameSlot<G>& g);
+    void drainEngine();
+    static const char* statusOf(const GameSlot<G>& g);
+
+    ServerOptions opt;
+    GamePool<G> games;
+    ThreadPool pool;
+    std::vector<std::unique_ptr<TranspositionTable>> tts;     // ワーカーごと
+    std::atomic<bool> stopping{false};
+    std::mutex doneMutex;
+    std::vector<EngineDone> done, doneSwap;
+    std::vector<std::unique_ptr<Connection>> conns;           // fd で引く
+    int epfd = -1, listenFd = -1, wakeFd = -1;
+    uint64_t moves = 0, engineMoves = 0, gamesStarted = 0, connections = 0;
+};
+
+static bool setNonBlocking(int fd){
+    int flags = fcntl(fd, F_GETFL, 0);
+    return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+template<class G>
+bool Server<G>::start(std::string& err){
+    epfd = epoll_create1(0);
+    wakeFd = eventfd(0, EFD_NONBLOCK);
+    listenFd = socket(AF_INET, SOCK_STREAM, 0);
+    if(epfd < 0 || wakeFd < 0 || listenFd < 0){ err = std::strerror(errno); return false; }
+    int one = 1;
+    setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(uint16_t(opt.port));
+    if(inet_pton(AF_INET, opt.bind.c_str(), &addr.sin_addr) != 1){ err = "bad address " + opt.bind; return false; }
+    if(bind(listenFd, (sockaddr*)&addr, sizeof(addr)) < 0 || listen(listenFd, 1024) < 0 || !setNonBlocking(listenFd)){
+        err = "cannot listen on " + opt.bind + ":" + std::to_string(opt.port) + ": " + std::strerror(errno);
+        return false;
+    }
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.fd = listenFd;
+    epoll_ctl(epfd, EPOLL_CTL_ADD, listenFd, &ev);
+    ev.data.fd = wakeFd;
+    epoll_ctl(epfd, EPOLL_CTL_ADD, wakeFd, &ev);
+    return true;
+}
+
+template<class G>
+void Server<G>::run(){
+    auto startTime = std::chrono::steady_clock::now();
+    auto lastReport = startTime;
+    uint64_t lastMoves = 0;
+    epoll_event events[256];
+    while(!quitRequested.load()){
+        int n = epoll_wait(epfd, events, 256, 1000);
+        if(n < 0 && errno != EINTR) break;
+        for(int i=0;i<n;i++){
+            int fd = events[i].data.fd;
+            if(fd == listenFd) accept();
+            else if(fd == wakeFd) drainEngine();
+            else if(fd < (int)conns.size() && conns[fd]){
+                Connection& c = *conns[fd];
+                if(events[i].events & (EPOLLERR | EPOLLHUP)){ closeConnection(fd); continue; }
+                if(events[i].events & EPOLLIN) readFrom(c);
+                if(conns[fd] && (events[i].events & EPOLLOUT)) flush(c);
+            }
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        double since = std::chrono::duration<double>(now - lastReport).count();
+        if(since >= 5){
+            std::cerr << "games " << games.active() << "  connections " << connections
+                      << "  moves/s " << (uint64_t)((moves - lastMoves) / since) << "\n";
+            lastReport = now;
+            lastMoves = moves;
+        }
+        if(opt.seconds > 0 && std::chrono::duration<double>(now - startTime).count() >= opt.seconds) break;
+    }
+    std::cerr << gamesStarted << " games, " << moves << " moves (" << engineMoves << " by the engine)\n";
+}
+
+template<class G>
+void Server<G>::accept(){
+    for(;;){
+        int fd = ::accept(listenFd, nullptr, nullptr);
+        if(fd < 0) return;      // EAGAIN なら取り切った
+        setNonBlocking(fd);
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        if(fd >= (int)conns.size()) conns.resize(fd + 1);
+        conns[fd] = std::make_unique<Connection>();
+        conns[fd]->fd = fd;
+        connections++;
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.fd = fd;
+        epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev);
+    }
+}
+
+// 読めた分ごとに行を処理するので、c.in に残るのは行の途中だけ（MAX_LINE まで）
+template<class G>
+void Server<G>::readFrom(Connection& c){
+    char buf[16384];
+    int fd = c.fd;
+    bool eof = false;
+    for(;;){
+        ssize_t n = ::read(fd, buf, sizeof(buf));
+        if(n < 0){
+            if(errno == EINTR) continue;
+            if(errno != EAGAIN){ closeConnection(fd); return; }
+            break;
+        }
+        if(n == 0){ eof = true; break; }
+        c.in.append(buf, size_t(n));
+        size_t pos = 0;
+        for(;;){
+            size_t nl = c.in.find('\n', pos);
+            if(nl == std::string::npos) break;
+            size_t len = nl - pos;
+            if(len && c.in[pos + len - 1] == '\r') len--;
+            handleLine(c, c.in.data() + pos, len);
+            pos = nl + 1;
+        }
+        c.in.erase(0, pos);
+        if(c.in.size() > MAX_LINE){ closeConnection(fd); return; }
+    }
+    // 返事はまとめて書く。相手が書き込み側を閉じていても、届いた行の返事は送ってから閉じる
+    flush(c);
+    if(eof && conns[fd]) closeConnection(fd);
+}
+
+template<class G>
+const char* Server<G>::statusOf(const GameSlot<G>& g){
+    switch(g.result){
+    case RESULT_WHITE_WINS: return "white";
+    case RESULT_BLACK_WINS: return "black";
+    case RESULT_DRAW: return "draw";
+    default: return "play";
+    }
+}
+
+// 手を指して終局判定まで行う（人間・エンジン共通）
+template<class G>
+void Server<G>::applyMove(GameSlot<G>& g, Move mv){
+    BasicMoveInfo<G> info;
+    int mover = g.pos.sideToMove;
+    makeMove(g.pos, mv, &info);
+    g.history.push(g.pos);
+    g.plies++;
+    moves++;
+    Termination t = terminationAfter(g.pos, g.history, info);
+    if(t != TERM_NONE) g.result = resultOf(t, mover);
+    else if(g.plies >= MAX_GAME_PLIES) g.result = RESULT_DRAW;
+}
+
+template<class G>
+void Server<G>::handleLine(Connection& c, const char* line, size_t len){
+    // 空白区切りで最大3語
+    std::string words[3];
+    int count = 0;
+    for(size_t i=0;i<len && count<3;){
+        while(i < len && line[i] == ' ') i++;
+        size_t j = i;
+        while(j < len && line[j] != ' ') j++;
+        if(j > i) words[count++].assign(line + i, j - i);
+        i = j;
+    }
+    if(count == 0) return;
+    const std::string& cmd = words[0];
+
+    if(cmd == "NEW"){
+        uint32_t gid = games.acquire(c.fd);
+        if(!gid){ c.out += "ERR - server full\n"; return; }
+        GameSlot<G>& g = *games.find(gid);
+        if(count > 1 && words[1] == "ai") g.aiColor = BLACK;
+        c.games.push_back(gid);
+        gamesStarted++;
+        c.out += "NEW " + std::to_string(gid) + " " + serializeBoard(g.pos) + "\n";
+        return;
+    }
+
+    if(cmd != "MOVE" && cmd != "BOARD" && cmd != "MOVES" && cmd != "END"){
+        c.out += "ERR - unknown command\n";
+        return;
+    }
+    uint32_t gid = count > 1 ? uint32_t(std::strtoul(words[1].c_str(), nullptr, 10)) : 0;
+    GameSlot<G>* g = games.find(gid);
+    if(!g || g->owner != c.fd){
+        c.out += "ERR " + (count > 1 ? words[1] : std::string("-")) + " no such game\n";
+        return;
+    }
+    std::string id = words[1];
+
+    if(cmd == "MOVE" && count == 3){
+        if(g->result != RESULT_UNFINISHED){ c.out += "ERR " + id + " game over\n"; return; }
+        if(g->aiThinking || g->pos.sideToMove == g->aiColor){ c.out += "ERR " + id + " not your turn\n"; return; }
+        Move mv = parseMove(g->pos, words[2]);
+        if(!mv){ c.out += "ERR " + id + " illegal\n"; return; }
+        applyMove(*g, mv);
+        c.out += "OK " + id + " " + statusOf(*g) + "\n";
+        if(g->result == RESULT_UNFINISHED && g->pos.sideToMove == g->aiColor) startEngine(gid, *g);
+    } else if(cmd == "BOARD"){
+        c.out += "BOARD " + id + " " + serializeBoard(g->pos) + " " + statusOf(*g) + "\n";
+    } else if(cmd == "MOVES"){
+        BasicMoveList<G> list;
+        if(g->result == RESULT_UNFINISHED) generateMoves(g->pos, list);
+        c.out += "MOVES " + id;
+        for(Move m : list){ c.out += ' '; c.out += moveToString<G>(m); }
+        c.out += '\n';
+    } else if(cmd == "END"){
+        for(size_t i=0;i<c.games.size();i++)
+            if(c.games[i] == gid){ c.games[i] = c.games.back(); c.games.pop_back(); break; }
+        games.release(gid);
+        c.out += "END " + id + "\n";
+    } else {
+        c.out += "ERR " + id + " missing move\n";
+    }
+}
+
+template<class G>
+void Server<G>::startEngine(uint32_t gid, GameSlot<G>& g){
+    g.aiThinking = true;
+    BasicPosition<G> pos = g.pos;
+    GameHistory history = g.history;
+    pool.submit([this, gid, pos, history]{
+        TranspositionTable& tt = *tts[ThreadPool::currentWorker()];
+        SearchLimits limits = opt.limits;
+        limits.stop = &stopping;
+        tt.newSearch();
+        Move mv = searchBestMove(tt, pos, history, limits).best;
+        {
+            std::lock_guard<std::mutex> lk(doneMutex);
+            done.push_back({ gid, mv });
+        }
+        uint64_t one = 1;
+        ssize_t r = ::write(wakeFd, &one, sizeof(one));
+        (void)r;
+    });
+}
+
+template<class G>
+void Server<G>::drainEngine(){
+    uint64_t count;
+    ssize_t r = ::read(wakeFd, &count, sizeof(count));
+    (void)r;
+    {
+        std::lock_guard<std::mutex> lk(doneMutex);
+        doneSwap.swap(done);
+    }
+    for(const EngineDone& d : doneSwap){
+        GameSlot<G>* g = games.find(d.gid);
+        if(!g) continue;                 // 探索中に対局が終わった／接続が切れた
+        g->aiThinking = false;
+        if(!d.move) continue;
+        applyMove(*g, d.move);
+        engineMoves++;
+        Connection& c = *conns[g->owner];
+        c.out += "AI " + std::to_string(d.gid) + " " + moveToString<G>(d.move) + " " + statusOf(*g) + "\n";
+        flush(c);
+    }
+    doneSwap.clear();
+}
+
+template<class G>
+void Server<G>::flush(Connection& c){
+    while(!c.out.empty()){
+        ssize_t n = ::send(c.fd, c.out.data(), c.out.size(), MSG_NOSIGNAL);
+        if(n < 0){
+            if(errno == EINTR) continue;
+            if(errno == EAGAIN) break;
+            closeConnection(c.fd);
+            return;
+        }
+        c.out.erase(0, size_t(n));
+    }
+    // 書き切れなかったときだけ EPOLLOUT を待つ
+    bool want = !c.out.empty();
+    if(want != c.wantWrite){
+        c.wantWrite = want;
+        epoll_event ev{};
+        ev.events = uint32_t(EPOLLIN) | (want ? uint32_t(EPOLLOUT) : 0u);
+        ev.data.fd = c.fd;
+        epoll_ctl(epfd, EPOLL_CTL_MOD, c.fd, &ev);
+    }
+}
+
+template<class G>
+void Server<G>::closeConnection(int fd){
+    Connection& c = *conns[fd];
+    for(uint32_t gid : c.games) games.release(gid);
+    epoll_ctl(epfd, EPOLL_CTL_DEL, fd, nullptr);
+    ::close(fd);
+    conns[fd].reset();
+    connections--;
+}
+
+int main(int argc, char* argv[]){
+    initAttacks();
+    ServerOptions opt;
+    opt.limits.threads = 1;
+    opt.limits.timeMs = 0;
+    opt.limits.maxNodes = 2000;
+    for(int i=1;i<argc;i++){
+        std::string a = argv[i];
+        if(a == "--port" && i+1 < argc) opt.port = std::atoi(argv[++i]);
+        else if(a == "--bind" && i+1 < argc) opt.bind = argv[++i];
+        else if(a == "--max-games" && i+1 < argc) opt.maxGames = std::min(std::max(1, std::atoi(argv[++i])), 1 << 20);
+        else if(a == "--engine-threads" && i+1 < argc) opt.engineThreads = std::atoi(argv[++i]);
+        else if(a == "--nodes" && i+1 < argc){ opt.limits.maxNodes = std::strtoull(argv[++i], nullptr, 10); opt.limits.timeMs = 0; }
+        else if(a == "--movetime" && i+1 < argc){ opt.limits.timeMs = std::atoi(argv[++i]); opt.limits.maxNodes = 0; }
+        else if(a == "--hash" && i+1 < argc) opt.hashMb = std::atoi(argv[++i]);
+        else if(a == "--seconds" && i+1 < argc) opt.seconds = std::atoi(argv[++i]);
+        else if(a == "--board" && i+1 < argc) opt.boardSize = std::atoi(argv[++i]);
+        else {
+            std::cerr << "usage: server [--port P] [--bind addr] [--max-games N] [--engine-threads T]\n"
+                         "              [--nodes N | --movetime ms] [--hash MB] [--seconds S] [--board N]\n";
+            return 1;
+        }
+    }
+    if(!isBoardSize(opt.boardSize)){ std::cerr << "board size must be 8, 10 or 12\n"; return 1; }
+
+    // 同時接続数ぶんの fd を使えるようにする
+    rlimit rl;
+    if(getrlimit(RLIMIT_NOFILE, &rl) == 0 && rl.rlim_cur < rl.rlim_max){
+        rl.rlim_cur = rl.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &rl);
+    }
+    std::signal(SIGINT, [](int){ quitRequested.store(true); });
+    std::signal(SIGTERM, [](int){ quitRequested.store(true); });
+
+    return withGeometry(opt.boardSize, [&](auto g){
+        Server<decltype(g)> server(opt);
+        std::string err;
+        if(!server.start(err)){ std::cerr << err << "\n"; return 1; }
+        std::cerr << "listening on " << opt.bind << ":" << opt.port << " (" << opt.maxGames << " game slots, "
+                  << opt.boardSize << "x" << opt.boardSize << ")\n";
+        server.run();
+        return 0;
+    });
+}
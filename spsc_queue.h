@@ -0,0 +1,35 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+
+// --- 単一生産者・単一消費者のロックフリーリングバッファ ---
+// push は生産者スレッドだけ、pop は消費者スレッドだけが呼ぶ。
+template<class T, size_t N>
+class SpscQueue {
+    static_assert((N & (N - 1)) == 0, "N は2のべき乗");
+public:
+    bool push(const T& v){
+        size_t t = tail.load(std::memory_order_relaxed);
+        if(t - head.load(std::memory_order_acquire) == N) return false;   // 満杯
+        items[t & (N - 1)] = v;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T& out){
+        size_t h = head.load(std::memory_order_relaxed);
+        if(h == tail.load(std::memory_order_acquire)) return false;       // 空
+        out = items[h & (N - 1)];
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool empty() const {
+        return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+    }
+
+private:
+    T items[N];
+    alignas(64) std::atomic<size_t> head{0};
+    alignas(64) std::atomic<size_t> tail{0};
+};
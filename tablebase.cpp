@@ -0,0 +1,382 @@
+#include "tablebase.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+
+namespace {
+
+const char TYPE_CHARS[] = "KQRBNP";
+const int VALUES_PER_BYTE = 5;                   // 3^5 = 243 <= 256
+const uint8_t POW3[VALUES_PER_BYTE] = { 1, 3, 9, 27, 81 };
+
+// --- キング対の通し番号 ---
+// 白キングは a〜d 列（左右反転で寄せる）、黒キングは重ならず隣接しないマス
+struct KingPairs {
+    int16_t index[64][64];
+    int count = 0;
+    KingPairs(){
+        for(int wk=0;wk<64;wk++)
+            for(int bk=0;bk<64;bk++){
+                bool near = std::abs(rowOf(wk) - rowOf(bk)) <= 1 && std::abs(colOf(wk) - colOf(bk)) <= 1;
+                index[wk][bk] = colOf(wk) < 4 && !near ? int16_t(count++) : int16_t(-1);
+            }
+    }
+};
+const KingPairs KK;
+
+struct KingSquares { uint8_t wk, bk; };
+std::vector<KingSquares> buildKingSquares(){
+    std::vector<KingSquares> v(KK.count);
+    for(int wk=0;wk<64;wk++)
+        for(int bk=0;bk<64;bk++)
+            if(KK.index[wk][bk] >= 0) v[KK.index[wk][bk]] = { uint8_t(wk), uint8_t(bk) };
+    return v;
+}
+const std::vector<KingSquares> KING_SQUARES = buildKingSquares();
+
+// 駒の種類を昇順に（高々3個なので挿入ソート）
+void sortTypes(TbMaterial& m){
+    for(int i=1;i<m.count;i++)
+        for(int j=i;j>0 && m.types[j-1] > m.types[j];j--) std::swap(m.types[j-1], m.types[j]);
+}
+
+bool sameMaterial(const TbMaterial& a, const TbMaterial& b){
+    if(a.count != b.count) return false;
+    for(int i=0;i<a.count;i++) if(a.types[i] != b.types[i]) return false;
+    return true;
+}
+
+// --- 生成中の値 ---
+enum { GEN_UNKNOWN, GEN_WIN, GEN_LOSS, GEN_DRAW, GEN_INVALID };
+
+struct Generator {
+    const TbMaterial& material;
+    const Tablebases& sub;
+    std::unique_ptr<std::atomic<uint8_t>[]> values;
+
+    // 手番側から見た子局面の値（同じ表の中はまだ決まっていないこともある）
+    int childValue(const Position& c) const {
+        // アンパッサンできる局面は表にないので1手読む
+        if(c.epSquare >= 0) return solve(c);
+        TbMaterial m;
+        uint64_t index;
+        if(!tbIndex(c, m, index) || m.count == 0) return GEN_DRAW;
+        if(sameMaterial(m, material)) return values[index].load(std::memory_order_relaxed);
+        TbValue v;
+        if(!sub.probe(c, v)) return GEN_DRAW;    // 呼び出し前に揃っていることを確かめてある
+        return v == TB_WIN ? GEN_WIN : v == TB_LOSS ? GEN_LOSS : GEN_DRAW;
+    }
+
+    // 子の値から親の値を決める。勝てる子が1つでもあれば勝ち、全部負けなら負け、
+    // まだ決まらない子が残っていれば保留（最後まで保留なら循環なので引き分け）
+    int solve(const Position& pos) const {
+        MoveList list;
+        generateMoves(pos, list);
+        if(list.size == 0) return inCheck(pos) ? GEN_LOSS : GEN_DRAW;
+        bool unknown = false, draw = false;
+        for(Move m : list){
+            Position c = pos;
+            makeMove(c, m);
+            if(isGameOver(c)) return GEN_WIN;         // キングを取った／反転させた
+            int v = childValue(c);
+            if(v == GEN_LOSS) return GEN_WIN;
+            if(v == GEN_UNKNOWN) unknown = true;
+            else if(v == GEN_DRAW) draw = true;
+        }
+        return unknown ? GEN_UNKNOWN : draw ? GEN_DRAW : GEN_LOSS;
+    }
+};
+
+}
+
+// --- 駒の組 ---
+
+std::string TbMaterial::name() const {
+    std::string s;
+    for(int i=0;i<count;i++) s += TYPE_CHARS[types[i]];
+    return s;
+}
+
+bool TbMaterial::parse(const std::string& s, TbMaterial& out){
+    out = TbMaterial();
+    for(char ch : s){
+        char u = ch >= 'a' && ch <= 'z' ? char(ch - 'a' + 'A') : ch;
+        if(u == 'K') continue;                   // "KQRK" のようにキングを書いてもよい
+        const char* p = std::strchr(TYPE_CHARS + 1, u);
+        if(!p || !*p || out.count >= TB_MAX_EXTRA) return false;
+        out.types[out.count++] = int(p - TYPE_CHARS);
+    }
+    sortTypes(out);
+    return out.count > 0;
+}
+
+uint64_t TbMaterial::entries() const { return uint64_t(KK.count) << (7 * count); }
+
+int TbMaterial::pawns() const { return int(std::count(types, types + count, int(PAWN))); }
+
+std::vector<TbMaterial> tbMaterials(int maxExtra){
+    std::vector<TbMaterial> out;
+    TbMaterial m;
+    // 種類を広義単調増加に並べた組を全部
+    auto rec = [&](auto& self, int from) -> void {
+        if(m.count > 0) out.push_back(m);
+        if(m.count == maxExtra) return;
+        for(int t=from;t<=PAWN;t++){
+            m.types[m.count++] = t;
+            self(self, t);
+            m.count--;
+        }
+    };
+    rec(rec, QUEEN);
+    std::stable_sort(out.begin(), out.end(), [](const TbMaterial& a, const TbMaterial& b){
+        return a.count != b.count ? a.count < b.count : a.pawns() < b.pawns();
+    });
+    return out;
+}
+
+std::vector<TbMaterial> tbSubMaterials(const TbMaterial& material){
+    std::vector<TbMaterial> out;
+    auto add = [&](TbMaterial m){
+        sortTypes(m);
+        if(m.count == 0) return;
+        for(const TbMaterial& o : out) if(sameMaterial(o, m)) return;
+        out.push_back(m);
+    };
+    // 1つ取られる（取った駒が成る場合も）、またはポーンが成る
+    for(int i=0;i<material.count;i++){
+        TbMaterial m = material;
+        std::copy(m.types + i + 1, m.types + m.count, m.types + i);
+        m.count--;
+        add(m);
+        for(int j=0;j<m.count;j++)
+            if(m.types[j] == PAWN){ TbMaterial q = m; q.types[j] = QUEEN; add(q); }
+        if(material.types[i] == PAWN){ TbMaterial q = material; q.types[i] = QUEEN; add(q); }
+    }
+    return out;
+}
+
+// --- 索引 ---
+
+bool tbIndex(const Position& pos, TbMaterial& material, uint64_t& index){
+    if(pos.castling || pos.epSquare >= 0) return false;
+    if(popcount(pos.occupied()) > TB_MAX_EXTRA + 2) return false;
+    if(popcount(pos.pieces[WHITE][KING]) != 1 || popcount(pos.pieces[BLACK][KING]) != 1) return false;
+
+    // 手番を白に（色の入れ替え + 上下反転）、白キングを左半分に（左右反転）
+    int swap = pos.sideToMove == BLACK;
+    int flipV = swap ? 56 : 0;
+    int wk = lsb(pos.pieces[swap][KING]) ^ flipV;
+    int bk = lsb(pos.pieces[swap ^ 1][KING]) ^ flipV;
+    int flipH = colOf(wk) >= 4 ? 7 : 0;
+    int kk = KK.index[wk ^ flipH][bk ^ flipH];
+    if(kk < 0) return false;
+
+    int types[TB_MAX_EXTRA], codes[TB_MAX_EXTRA], n = 0;
+    for(int c=0;c<2;c++)
+        for(int t=QUEEN;t<=PAWN;t++)
+            for(Bitboard b = pos.pieces[c][t]; b; ){
+                int sq = popLsb(b) ^ flipV ^ flipH;
+                int code = ((c ^ swap) << 6) | sq;
+                // 種類、同じ種類なら code の昇順に差し込む
+                int i = n++;
+                while(i > 0 && (types[i-1] > t || (types[i-1] == t && codes[i-1] > code))){
+                    types[i] = types[i-1];
+                    codes[i] = codes[i-1];
+                    i--;
+                }
+                types[i] = t;
+                codes[i] = code;
+            }
+    material.count = n;
+    index = uint64_t(kk);
+    for(int i=0;i<n;i++){
+        material.types[i] = types[i];
+        index = (index << 7) | uint64_t(codes[i]);
+    }
+    return true;
+}
+
+bool tbPosition(const TbMaterial& material, uint64_t index, Position& pos){
+    int n = material.count;
+    uint64_t kk = index >> (7 * n);
+    if(kk >= uint64_t(KK.count)) return false;
+    clearPosition(pos);
+    int wk = KING_SQUARES[kk].wk, bk = KING_SQUARES[kk].bk;
+    Bitboard used = bit(wk) | bit(bk);
+    putPiece(pos, wk, WHITE, KING);
+    putPiece(pos, bk, BLACK, KING);
+    int prevCode = -1;
+    for(int i=0;i<n;i++){
+        int code = int(index >> (7 * (n - 1 - i))) & 127;
+        int sq = code & 63, color = code >> 6, t = material.types[i];
+        if(used & bit(sq)) return false;
+        if(t == PAWN && (rowOf(sq) == 0 || rowOf(sq) == 7)) return false;
+        if(i > 0 && material.types[i-1] == t && code <= prevCode) return false;   // 同じ種類は昇順だけ
+        used |= bit(sq);
+        putPiece(pos, sq, color, t);
+        prevCode = code;
+    }
+    return true;
+}
+
+// --- 読み込みと引き当て ---
+
+int Tablebases::slotOf(const TbMaterial& m){
+    int slot = 0;
+    for(int i=0;i<m.count;i++){
+        int shift = 2 * (m.types[i] - QUEEN);
+        slot += 1 << shift;
+    }
+    return slot;
+}
+
+int Tablebases::open(const std::string& dir, std::string* error){
+    int opened = 0;
+    for(const TbMaterial& m : tbMaterials(TB_MAX_EXTRA)){
+        std::string path = dir + "/" + m.name() + ".otb";
+        FILE* f = std::fopen(path.c_str(), "rb");
+        if(!f) continue;
+        std::fclose(f);
+        if(load(path, error)) opened++;
+    }
+    return opened;
+}
+
+bool Tablebases::load(const std::string& path, std::string* error){
+    auto t = std::make_unique<Table>();
+    if(!t->file.open(path, error)) return false;
+    auto fail = [&](const char* why){
+        if(error) *error = path + ": " + why;
+        return false;
+    };
+    if(t->file.size() < sizeof(TbHeader)) return fail("too small");
+    const TbHeader* h = reinterpret_cast<const TbHeader*>(t->file.data());
+    if(std::memcmp(h->magic, "OCTB", 4) != 0) return fail("not a tablebase");
+    if(h->version != TB_VERSION) return fail("unsupported version");
+    if(h->extra < 1 || h->extra > uint32_t(TB_MAX_EXTRA)) return fail("bad piece count");
+    TbMaterial m;
+    m.count = int(h->extra);
+    for(int i=0;i<m.count;i++){
+        m.types[i] = h->types[i];
+        if(m.types[i] < QUEEN || m.types[i] > PAWN || (i > 0 && m.types[i] < m.types[i-1])) return fail("bad piece types");
+    }
+    if(h->entries != m.entries()) return fail("bad size");
+    if(t->file.size() - sizeof(TbHeader) < (h->entries + VALUES_PER_BYTE - 1) / VALUES_PER_BYTE) return fail("truncated");
+    t->header = h;
+    t->data = t->file.data() + sizeof(TbHeader);
+    t->file.adviseRandom();
+    bySlot[slotOf(m)] = t.get();
+    maxExtra = std::max(maxExtra, m.count);
+    tables.push_back(std::move(t));
+    return true;
+}
+
+void Tablebases::close(){
+    tables.clear();
+    std::fill(std::begin(bySlot), std::end(bySlot), nullptr);
+    maxExtra = 0;
+}
+
+bool Tablebases::has(const TbMaterial& m) const { return bySlot[slotOf(m)] != nullptr; }
+
+bool Tablebases::probe(const Position& pos, TbValue& value) const {
+    if(tables.empty() || popcount(pos.occupied()) > maxExtra + 2) return false;
+    TbMaterial m;
+    uint64_t index;
+    if(!tbIndex(pos, m, index)) return false;
+    if(m.count == 0){ value = TB_DRAW; return true; }     // キング同士は指し続けても決着しない
+    const Table* t = bySlot[slotOf(m)];
+    if(!t) return false;
+    uint8_t b = t->data[index / VALUES_PER_BYTE];
+    value = TbValue(b / POW3[index % VALUES_PER_BYTE] % 3);
+    return true;
+}
+
+// --- 生成 ---
+// 全局面の値を「保留」から始め、子の値で決まるものを決める走査を、何も変わらなく
+// なるまで繰り返す。走査はスレッドプールで索引の範囲ごとに分け、値は同じ配列を
+// その場で書き換える（決まった値は変わらないので、古い値を読んでも次の走査で拾える）。
+// 取る・成る手の先は sub の表（駒数が少ない・ポーンが少ない表）を引く。
+bool generateTablebase(const TbMaterial& material, const std::string& dir, const Tablebases& sub,
+                       int threads, TbGenStats* stats, std::string* error){
+    auto start = std::chrono::steady_clock::now();
+    // 取る・成る先の表が揃っているか
+    for(const TbMaterial& m : tbSubMaterials(material))
+        if(!sub.has(m)){
+            if(error) *error = "missing sub-table " + m.name() + " for " + material.name();
+            return false;
+        }
+
+    const uint64_t entries = material.entries();
+    Generator gen{ material, sub, std::unique_ptr<std::atomic<uint8_t>[]>(new std::atomic<uint8_t>[entries]) };
+    for(uint64_t i=0;i<entries;i++) gen.values[i].store(GEN_UNKNOWN, std::memory_order_relaxed);
+
+    ThreadPool pool(threads);
+    const uint64_t chunk = 1 << 16;
+    int passes = 0;
+    for(;;){
+        passes++;
+        std::atomic<uint64_t> changed{0};
+        bool first = passes == 1;
+        for(uint64_t lo=0; lo<entries; lo+=chunk){
+            pool.submit([&, lo]{
+                uint64_t hi = std::min(entries, lo + chunk), n = 0;
+                Position pos;
+                for(uint64_t i=lo;i<hi;i++){
+                    if(gen.values[i].load(std::memory_order_relaxed) != GEN_UNKNOWN) continue;
+                    if(!tbPosition(material, i, pos)){
+                        if(first) gen.values[i].store(GEN_INVALID, std::memory_order_relaxed);
+                        continue;
+                    }
+                    int v = gen.solve(pos);
+                    if(v != GEN_UNKNOWN){
+                        gen.values[i].store(uint8_t(v), std::memory_order_relaxed);
+                        n++;
+                    }
+                }
+                changed.fetch_add(n, std::memory_order_relaxed);
+            });
+        }
+        pool.wait();
+        if(changed.load() == 0) break;
+    }
+
+    // --- 3進数で5個ずつ詰める ---
+    TbHeader h{};
+    std::memcpy(h.magic, "OCTB", 4);
+    h.version = TB_VERSION;
+    h.extra = uint32_t(material.count);
+    for(int i=0;i<material.count;i++) h.types[i] = uint8_t(material.types[i]);
+    h.entries = entries;
+    std::vector<uint8_t> packed((entries + VALUES_PER_BYTE - 1) / VALUES_PER_BYTE);
+    for(uint64_t i=0;i<entries;i++){
+        int v = gen.values[i].load(std::memory_order_relaxed);
+        if(v == GEN_INVALID) continue;
+        if(v == GEN_UNKNOWN) v = GEN_DRAW;        // 最後まで決まらなかった = 循環
+        int digit = v == GEN_WIN ? TB_WIN : v == GEN_LOSS ? TB_LOSS : TB_DRAW;
+        (v == GEN_WIN ? h.wins : v == GEN_LOSS ? h.losses : h.draws)++;
+        packed[i / VALUES_PER_BYTE] += uint8_t(digit * POW3[i % VALUES_PER_BYTE]);
+    }
+
+    std::string path = dir + "/" + material.name() + ".otb";
+    FILE* f = std::fopen(path.c_str(), "wb");
+    if(!f){ if(error) *error = "cannot write " + path; return false; }
+    bool ok = std::fwrite(&h, sizeof h, 1, f) == 1
+           && std::fwrite(packed.data(), 1, packed.size(), f) == packed.size();
+    ok = std::fclose(f) == 0 && ok;
+    if(!ok){ if(error) *error = "write failed: " + path; return false; }
+
+    if(stats){
+        stats->positions = h.wins + h.losses + h.draws;
+        stats->wins = h.wins;
+        stats->losses = h.losses;
+        stats->draws = h.draws;
+        stats->passes = passes;
+        stats->seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+    return true;
+}
@@ -0,0 +1,88 @@
+#pragma once
+#include "position.h"
+#include "mapped_file.h"
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// --- 終盤テーブルベース（後退解析で作る勝ち・負け・引き分けの表） ---
+// 両キング + キング以外の駒 TB_MAX_EXTRA 個までの局面を、駒の種類の組（色は問わない。
+// オセロ反転で色は変わるが種類は変わらないので、反転しても同じ表の中に留まる）ごとに1ファイル。
+//   ファイル名: 駒の種類を Q R B N P の順に並べたもの + ".otb"（例: QR.otb, NP.otb）
+//   ヘッダ TbHeader | 値を5個ずつ1バイトに詰めた表（3進数、0 = 引き分け, 1 = 勝ち, 2 = 負け）
+// 値は手番側から見た結果。50手ルールと千日手は考えない（循環は引き分け）。
+// 索引は完全ハッシュ（1つの索引に局面は高々1つ）:
+//   手番が黒なら色を入れ替えて上下反転し、白キングが a〜d 列に来るよう左右反転してから
+//   キング対（重なり・隣接を除く 1806 通り）x 128^駒数（各駒の 色*64 + マス）。
+//   同じ種類の駒は (色*64 + マス) の昇順に並べ、それ以外の並びは使わない。
+// キャスリング権・アンパッサンのある局面は対象外（probe は false を返す）。
+const int TB_MAX_EXTRA = 3;
+const uint32_t TB_VERSION = 1;
+
+enum TbValue { TB_DRAW, TB_WIN, TB_LOSS };
+
+struct TbHeader {
+    char magic[4];               // "OCTB"
+    uint32_t version;
+    uint32_t extra;              // キング以外の駒数
+    uint8_t types[4];            // 駒の種類（PieceType、extra 個）
+    uint64_t entries;            // 索引の数（詰める前）
+    uint64_t wins, losses, draws;   // 有効な局面の内訳
+};
+static_assert(sizeof(TbHeader) == 48, "TbHeader layout");
+
+// キング以外の駒の種類の組（昇順）
+struct TbMaterial {
+    int count = 0;
+    int types[TB_MAX_EXTRA] = {};
+
+    std::string name() const;                    // "QR" など
+    static bool parse(const std::string& s, TbMaterial& out);
+    uint64_t entries() const;
+    int pawns() const;
+};
+
+// 局面の駒の組と索引を求める（対象外なら false、キング同士だけなら count == 0）
+bool tbIndex(const Position& pos, TbMaterial& material, uint64_t& index);
+// 索引から局面を作る（手番は白。使わない索引なら false）
+bool tbPosition(const TbMaterial& material, uint64_t index, Position& pos);
+
+class Tablebases {
+public:
+    // ディレクトリ内の表をすべて開く。開けた数を返す
+    int open(const std::string& dir, std::string* error = nullptr);
+    bool load(const std::string& path, std::string* error = nullptr);
+    void close();
+    int count() const { return int(tables.size()); }
+    int maxPieces() const { return maxExtra + 2; }
+    bool has(const TbMaterial& m) const;
+
+    // 手番側から見た値。表がない・対象外の局面なら false
+    bool probe(const Position& pos, TbValue& value) const;
+
+private:
+    struct Table {
+        MappedFile file;
+        const TbHeader* header = nullptr;
+        const uint8_t* data = nullptr;
+    };
+    static int slotOf(const TbMaterial& m);
+    std::vector<std::unique_ptr<Table>> tables;
+    const Table* bySlot[1024] = {};              // 種類ごとの個数（0..3 の5桁の4進数）で引く
+    int maxExtra = 0;
+};
+
+struct TbGenStats {
+    uint64_t positions = 0, wins = 0, losses = 0, draws = 0;
+    int passes = 0;
+    double seconds = 0;
+};
+
+// material の表を作って dir に書き出す。駒を取る・成ると移る先の表は sub で開いておくこと
+bool generateTablebase(const TbMaterial& material, const std::string& dir, const Tablebases& sub,
+                       int threads, TbGenStats* stats = nullptr, std::string* error = nullptr);
+// 駒数 n 以下のすべての駒の組（作る順: 駒数が少なく、ポーンが少ない順）
+std::vector<TbMaterial> tbMaterials(int maxExtra);
+// material から1手で移りうる（取る・成る）別の駒の組。生成前に揃っている必要がある
+std::vector<TbMaterial> tbSubMaterials(const TbMaterial& material);
@@ -0,0 +1,321 @@
+// --- tbgen: 終盤テーブルベースの生成・照合・引き当て（SDL 不要） ---
+// 使い方:
+//   tbgen [--dir D] [--pieces N] [--threads T] [駒の組...]   N 駒（キングを含む）以下の表を作る
+//   tbgen --verify [--dir D] [--samples S] [--games G]          値が子局面の値・探索と矛盾しないか、
+//                                                               KQK / KRK の勝ちを探索で勝ち切れるか
+//   tbgen --probe [--dir D] 局面65文字                          局面の値と、各合法手の先の値
+//   tbgen --bench [--dir D]                                     引き当ての速さと、探索の節点数の比較
+// 駒の組はキング以外の駒を並べたもの（例: Q, RN, QP）。色は問わない。
+// 指定しなければ N 駒以下のすべての組を、取る・成る先の表から順に作る。
+// ディレクトリにすでにある表は作り直さない（消してから実行する）。
+// 既定の N = 4 で 20 表。N = 5 は 1 表あたり 38 億局面（作業用に同じバイト数のメモリ）。
+#include "tablebase.h"
+#include "search.h"
+#include "zobrist.h"
+#include "gamerecord.h"
+#include "attacks.h"
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+#include <thread>
+#include <algorithm>
+
+static const char* VALUE_NAMES[] = { "draw", "win", "loss" };
+
+struct TbOptions {
+    std::string dir = ".";
+    int pieces = 4;
+    int threads = 0;
+    int samples = 20000;
+    int games = 30;
+};
+
+// --- 生成 ---
+static int generate(const TbOptions& opt, const std::vector<TbMaterial>& requested){
+    Tablebases tbs;
+    std::string err;
+    tbs.open(opt.dir, &err);
+    if(!err.empty()){ std::cerr << err << "\n"; return 1; }
+
+    // 指定された組と、そこから取る・成ると移る組をすべて（足りないものだけ作る）
+    std::vector<TbMaterial> todo;
+    auto same = [](const TbMaterial& a, const TbMaterial& b){ return a.name() == b.name(); };
+    std::vector<TbMaterial> stack = requested;
+    while(!stack.empty()){
+        TbMaterial m = stack.back();
+        stack.pop_back();
+        if(tbs.has(m) || std::any_of(todo.begin(), todo.end(), [&](const TbMaterial& o){ return same(o, m); })) continue;
+        todo.push_back(m);
+        for(const TbMaterial& s : tbSubMaterials(m)) stack.push_back(s);
+    }
+    std::stable_sort(todo.begin(), todo.end(), [](const TbMaterial& a, const TbMaterial& b){
+        return a.count != b.count ? a.count < b.count : a.pawns() < b.pawns();
+    });
+    if(todo.empty()){ std::cout << "all tables exist in " << opt.dir << "\n"; return 0; }
+
+    auto start = std::chrono::steady_clock::now();
+    for(const TbMaterial& m : todo){
+        TbGenStats st;
+        if(!generateTablebase(m, opt.dir, tbs, opt.threads, &st, &err)){ std::cerr << err << "\n"; return 1; }
+        if(!tbs.load(opt.dir + "/" + m.name() + ".otb", &err)){ std::cerr << err << "\n"; return 1; }
+        std::cout << "K" << std::left << std::setw(4) << (m.name() + "K") << std::right
+                  << std::setw(12) << st.positions << " positions  win " << std::setw(11) << st.wins
+                  << "  loss " << std::setw(11) << st.losses << "  draw " << std::setw(11) << st.draws
+                  << "  passes " << std::setw(3) << st.passes << "  " << std::fixed << std::setprecision(1)
+                  << st.seconds << "s (" << (uint64_t)(st.seconds > 0 ? st.positions / st.seconds : 0) << " positions/s)\n";
+    }
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << todo.size() << " tables in " << std::fixed << std::setprecision(1) << secs << "s\n";
+    return 0;
+}
+
+// --- 照合 ---
+// 表の値を子局面の表の値から求め直す（アンパッサンできる子は1手読む）
+static int valueFromChildren(const Tablebases& tbs, const Position& pos){
+    MoveList list;
+    generateMoves(pos, list);
+    if(list.size == 0) return inCheck(pos) ? TB_LOSS : TB_DRAW;
+    bool draw = false;
+    for(Move m : list){
+        Position c = pos;
+        makeMove(c, m);
+        if(isGameOver(c)) return TB_WIN;
+        TbValue v;
+        int cv = c.epSquare >= 0 ? valueFromChildren(tbs, c) : tbs.probe(c, v) ? int(v) : -1;
+        if(cv < 0) return -1;
+        if(cv == TB_LOSS) return TB_WIN;
+        if(cv == TB_DRAW) draw = true;
+    }
+    return draw ? TB_DRAW : TB_LOSS;
+}
+
+// 表で勝ちの局面から、探索（表あり）同士で実際にキングを取る・詰ますまで指せるか。
+// 勝つ側の駒がクイーンかルーク1個の表で games 局、CONVERT_PLIES 手以内に勝てなければ失敗
+const int CONVERT_PLIES = 100;
+
+static bool convertWins(const Tablebases& tbs, const TbOptions& opt){
+    bool ok = true;
+    TranspositionTable tt(16);
+    for(int type : { QUEEN, ROOK }){
+        TbMaterial m;
+        m.count = 1;
+        m.types[0] = type;
+        if(!tbs.has(m)) continue;
+        uint64_t rng = 3;
+        int games = 0, converted = 0, totalPlies = 0, maxPlies = 0;
+        while(games < opt.games){
+            Position pos;
+            TbValue v;
+            if(!tbPosition(m, splitmix64(rng) % m.entries(), pos) || pos.pieces[BLACK][type]) continue;
+            pos.key = computeKey(pos);
+            if(!tbs.probe(pos, v) || v != TB_WIN) continue;
+            Position start = pos;
+            GameHistory history;
+            history.reset(pos);
+            tt.clear();
+            GameResult result = RESULT_UNFINISHED;
+            int ply = 0;
+            while(result == RESULT_UNFINISHED && ply < CONVERT_PLIES){
+                SearchLimits limits;
+                limits.timeMs = 0;
+                limits.maxNodes = 20000;
+                limits.tablebases = &tbs;
+                SearchResult sr = searchBestMove(tt, pos, history, limits);
+                MoveInfo info;
+                int mover = pos.sideToMove;
+                makeMove(pos, sr.best, &info);
+                history.push(pos);
+                ply++;
+                Termination t = terminationAfter(pos, history, info);
+                if(t != TERM_NONE) result = resultOf(t, mover);
+            }
+            games++;
+            if(result == RESULT_WHITE_WINS){
+                converted++;
+                totalPlies += ply;
+                maxPlies = std::max(maxPlies, ply);
+            } else if(games - converted <= 5)
+                std::cout << "  not converted " << serializeBoard(start) << "\n";
+        }
+        std::cout << "K" << std::left << std::setw(4) << (m.name() + "K") << std::right << std::setw(7) << converted
+                  << "/" << games << " won positions converted, avg " << (converted ? totalPlies / converted : 0)
+                  << " max " << maxPlies << " plies" << (converted == games ? "  ok" : "  FAILED") << "\n";
+        ok &= converted == games;
+    }
+    return ok;
+}
+
+static int verify(const TbOptions& opt){
+    Tablebases tbs;
+    std::string err;
+    if(tbs.open(opt.dir, &err) == 0){ std::cerr << (err.empty() ? "no tables in " + opt.dir : err) << "\n"; return 1; }
+    TranspositionTable tt(16);
+    uint64_t rng = 1;
+    bool ok = true;
+    for(const TbMaterial& m : tbMaterials(TB_MAX_EXTRA)){
+        if(!tbs.has(m)) continue;
+        int checked = 0, searched = 0, mismatches = 0;
+        for(int s=0;s<opt.samples;s++){
+            Position pos;
+            uint64_t index = splitmix64(rng) % m.entries();
+            if(!tbPosition(m, index, pos)) continue;
+            pos.key = computeKey(pos);
+            // 色を入れ替えて上下反転した局面（黒番）も同じ値になるはず
+            Position mirror;
+            clearPosition(mirror);
+            for(int c=0;c<2;c++)
+                for(int t=KING;t<=PAWN;t++)
+                    for(Bitboard b = pos.pieces[c][t]; b; ) putPiece(mirror, popLsb(b) ^ 56 ^ 7, c ^ 1, t);
+            mirror.sideToMove = BLACK;
+            TbValue stored, mirrored;
+            tbs.probe(pos, stored);
+            tbs.probe(mirror, mirrored);
+            int expected = valueFromChildren(tbs, pos);
+            bool bad = expected != stored || mirrored != stored;
+            // 浅い探索で詰みが見つかったら表と向きが合うか
+            if(!bad && (s & 15) == 0){
+                GameHistory history;
+                history.reset(pos);
+                SearchLimits limits;
+                limits.maxDepth = 4;
+                limits.timeMs = 0;
+                SearchResult r = searchBestMove(tt, pos, history, limits);
+                if(isMateScore(r.score) && (r.score > 0 ? stored != TB_WIN : stored != TB_LOSS)) bad = true;
+                searched++;
+            }
+            if(bad && mismatches++ < 5)
+                std::cout << "  mismatch " << serializeBoard(pos) << " stored " << VALUE_NAMES[stored]
+                          << " from children " << (expected < 0 ? "?" : VALUE_NAMES[expected]) << "\n";
+            checked++;
+        }
+        std::cout << "K" << std::left << std::setw(4) << (m.name() + "K") << std::right << std::setw(7) << checked
+                  << " positions, " << std::setw(5) << searched << " searched" << (mismatches ? "  MISMATCH" : "  ok") << "\n";
+        ok &= mismatches == 0;
+    }
+    ok &= convertWins(tbs, opt);
+    std::cout << (ok ? "all ok\n" : "FAILED\n");
+    return ok ? 0 : 1;
+}
+
+// --- 引き当て ---
+static int probe(const TbOptions& opt, const std::string& board){
+    Tablebases tbs;
+    std::string err;
+    tbs.open(opt.dir, &err);
+    Position pos;
+    if(!parseBoard(board, pos)){ std::cerr << "invalid position: " << board << "\n"; return 1; }
+    TbValue v;
+    if(!tbs.probe(pos, v)){ std::cout << "not in tablebases\n"; return 1; }
+    std::cout << serializeBoard(pos) << "  " << VALUE_NAMES[v] << "\n";
+    MoveList list;
+    generateMoves(pos, list);
+    for(Move m : list){
+        Position c = pos;
+        makeMove(c, m);
+        TbValue cv;
+        // 子の値は相手から見たものなので裏返して表示する
+        const char* s = isGameOver(c) ? "win (king)" : !tbs.probe(c, cv) ? "?" : VALUE_NAMES[cv == TB_WIN ? TB_LOSS : cv == TB_LOSS ? TB_WIN : TB_DRAW];
+        std::cout << "  " << moveToString(m) << "  " << s << "\n";
+    }
+    return 0;
+}
+
+static int bench(const TbOptions& opt){
+    Tablebases tbs;
+    std::string err;
+    if(tbs.open(opt.dir, &err) == 0){ std::cerr << (err.empty() ? "no tables in " + opt.dir : err) << "\n"; return 1; }
+    // 表にある局面を集めてから引く時間だけを測る
+    std::vector<Position> positions, wins;
+    uint64_t rng = 7;
+    std::vector<TbMaterial> mats;
+    for(const TbMaterial& m : tbMaterials(TB_MAX_EXTRA)) if(tbs.has(m)) mats.push_back(m);
+    while(positions.size() < 1000000){
+        const TbMaterial& m = mats[splitmix64(rng) % mats.size()];
+        Position pos;
+        if(!tbPosition(m, splitmix64(rng) % m.entries(), pos)) continue;
+        pos.key = computeKey(pos);
+        positions.push_back(pos);
+    }
+    uint64_t counts[3] = {};
+    auto t0 = std::chrono::steady_clock::now();
+    for(const Position& p : positions){
+        TbValue v;
+        if(tbs.probe(p, v)) counts[v]++;
+    }
+    double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    std::cout << positions.size() << " probes in " << std::fixed << std::setprecision(3) << sec << "s ("
+              << std::setprecision(1) << sec * 1e9 / positions.size() << " ns/probe)  win " << counts[TB_WIN]
+              << "  loss " << counts[TB_LOSS] << "  draw " << counts[TB_DRAW] << "\n";
+
+    // 勝ちの局面を、表なし・表ありで同じ深さまで探索して節点数を比べる
+    for(const Position& p : positions){
+        TbValue v;
+        MoveList list;
+        generateMoves(p, list);
+        if(tbs.probe(p, v) && v == TB_WIN && list.size > 3) wins.push_back(p);
+        if(wins.size() == 20) break;
+    }
+    TranspositionTable tt(16);
+    for(int useTb=0;useTb<2;useTb++){
+        uint64_t nodes = 0, hits = 0;
+        int found = 0;
+        auto s0 = std::chrono::steady_clock::now();
+        for(const Position& p : wins){
+            GameHistory history;
+            history.reset(p);
+            SearchLimits limits;
+            limits.maxDepth = 6;
+            limits.timeMs = 0;
+            limits.tablebases = useTb ? &tbs : nullptr;
+            tt.clear();
+            SearchResult r = searchBestMove(tt, p, history, limits);
+            nodes += r.nodes;
+            hits += r.tbHits;
+            Position c = p;
+            makeMove(c, r.best);
+            TbValue cv;
+            if(isGameOver(c) || (tbs.probe(c, cv) && cv == TB_LOSS)) found++;
+        }
+        double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - s0).count();
+        std::cout << (useTb ? "search with tablebases    " : "search without tablebases ") << wins.size()
+                  << " won positions depth 6: nodes " << std::setw(10) << nodes << "  tb hits " << std::setw(8) << hits
+                  << "  winning moves " << found << "/" << wins.size() << "  " << std::setprecision(3) << s << "s\n";
+    }
+    return 0;
+}
+
+int main(int argc, char* argv[]){
+    initAttacks();
+    TbOptions opt;
+    std::string mode = "generate", board;
+    std::vector<TbMaterial> requested;
+    for(int i=1;i<argc;i++){
+        std::string a = argv[i];
+        TbMaterial m;
+        if(a == "--dir" && i+1 < argc) opt.dir = argv[++i];
+        else if(a == "--pieces" && i+1 < argc) opt.pieces = std::atoi(argv[++i]);
+        else if(a == "--threads" && i+1 < argc) opt.threads = std::atoi(argv[++i]);
+        else if(a == "--samples" && i+1 < argc) opt.samples = std::atoi(argv[++i]);
+        else if(a == "--games" && i+1 < argc) opt.games = std::atoi(argv[++i]);
+        else if(a == "--verify" || a == "--bench") mode = a.substr(2);
+        else if(a == "--probe" && i+1 < argc){ mode = "probe"; board = argv[++i]; }
+        else if(a[0] != '-' && TbMaterial::parse(a, m)) requested.push_back(m);
+        else {
+            std::cerr << "usage: tbgen [--dir D] [--pieces N] [--threads T] [material...]\n"
+                         "       tbgen --verify [--dir D] [--samples S] [--games G] | --probe board | --bench\n";
+            return 1;
+        }
+    }
+    if(opt.pieces < 3 || opt.pieces > TB_MAX_EXTRA + 2){
+        std::cerr << "--pieces must be 3.." << TB_MAX_EXTRA + 2 << "\n";
+        return 1;
+    }
+    if(mode == "verify") return verify(opt);
+    if(mode == "probe") return probe(opt, board);
+    if(mode == "bench") return bench(opt);
+    if(requested.empty()) requested = tbMaterials(opt.pieces - 2);
+    return generate(opt, requested);
+}
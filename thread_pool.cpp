@@ -0,0 +1,81 @@
+#include "thread_pool.h"
+
+static thread_local const ThreadPool* tlsPool = nullptr;
+static thread_local int tlsWorker = -1;
+
+ThreadPool::ThreadPool(int n){
+    if(n <= 0) n = (int)std::thread::hardware_concurrency();
+    if(n <= 0) n = 1;
+    for(int i=0;i<n;i++) workers.push_back(std::make_unique<Worker>());
+    for(int i=0;i<n;i++) threads.emplace_back([this,i]{ run(i); });
+}
+
+ThreadPool::~ThreadPool(){
+    wait();
+    quit.store(true);
+    { std::lock_guard<std::mutex> lk(sleepMutex); }
+    workReady.notify_all();
+    for(std::thread& t : threads) t.join();
+}
+
+int ThreadPool::currentWorker(){ return tlsWorker; }
+
+void ThreadPool::submit(std::function<void()> task){
+    int i = tlsPool == this ? tlsWorker : int(nextQueue.fetch_add(1) % workers.size());
+    pending.fetch_add(1);
+    queued.fetch_add(1);
+    {
+        std::lock_guard<std::mutex> lk(workers[i]->m);
+        workers[i]->tasks.push_back(std::move(task));
+    }
+    // 積んだ後にロックを取るので、眠りかけのワーカーを起こし損ねない
+    { std::lock_guard<std::mutex> lk(sleepMutex); }
+    workReady.notify_one();
+}
+
+void ThreadPool::wait(){
+    std::unique_lock<std::mutex> lk(sleepMutex);
+    allDone.wait(lk, [this]{ return pending.load() == 0; });
+}
+
+bool ThreadPool::popLocal(int i, std::function<void()>& out){
+    Worker& w = *workers[i];
+    std::lock_guard<std::mutex> lk(w.m);
+    if(w.tasks.empty()) return false;
+    out = std::move(w.tasks.back());
+    w.tasks.pop_back();
+    return true;
+}
+
+bool ThreadPool::steal(int i, std::function<void()>& out){
+    int n = (int)workers.size();
+    for(int k=1;k<n;k++){
+        Worker& w = *workers[(i + k) % n];
+        std::lock_guard<std::mutex> lk(w.m);
+        if(w.tasks.empty()) continue;
+        out = std::move(w.tasks.front());
+        w.tasks.pop_front();
+        return true;
+    }
+    return false;
+}
+
+void ThreadPool::run(int i){
+    tlsPool = this;
+    tlsWorker = i;
+    for(;;){
+        std::function<void()> task;
+        if(popLocal(i, task) || steal(i, task)){
+            queued.fetch_sub(1);
+            task();
+            if(pending.fetch_sub(1) == 1){
+                { std::lock_guard<std::mutex> lk(sleepMutex); }
+                allDone.notify_all();
+            }
+            continue;
+        }
+        std::unique_lock<std::mutex> lk(sleepMutex);
+        workReady.wait(lk, [this]{ return quit.load() || queued.load() > 0; });
+        if(quit.load() && queued.load() == 0) return;
+    }
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include <functional>
+#include <deque>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+// --- ワークスティーリング型スレッドプール ---
+// ワーカーごとに両端キューを持ち、自分のキューは後ろから（LIFO）、
+// 他のワーカーのキューは前から（FIFO）盗む。
+// ワーカー内から submit したタスクは自分のキューに積まれる。
+class ThreadPool {
+public:
+    explicit ThreadPool(int threads = 0);        // 0 = hardware_concurrency
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void submit(std::function<void()> task);
+    void wait();                                 // 投入済みのタスクがすべて終わるまで待つ
+    int size() const { return (int)threads.size(); }
+    // 実行中のワーカー番号（プール外のスレッドでは -1）
+    static int currentWorker();
+
+private:
+    struct Worker {
+        std::mutex m;
+        std::deque<std::function<void()>> tasks;
+    };
+    bool popLocal(int i, std::function<void()>& out);
+    bool steal(int i, std::function<void()>& out);
+    void run(int i);
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::thread> threads;
+    std::mutex sleepMutex;
+    std::condition_variable workReady, allDone;
+    std::atomic<size_t> queued{0};               // キューに積まれて未着手のタスク
+    std::atomic<size_t> pending{0};              // 未完了のタスク（実行中を含む）
+    std::atomic<unsigned> nextQueue{0};
+    std::atomic<bool> quit{false};
+};
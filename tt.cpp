@@ -0,0 +1,88 @@
+#include "tt.h"
+
+static_assert(MOVE_BITS + 16 + 8 + 2 + 6 <= 64, "TT data must fit in one word");
+const uint64_t MOVE_MASK = (uint64_t(1) << MOVE_BITS) - 1;
+
+static uint64_t packData(Move move, int score, int depth, int bound, int gen){
+    return uint64_t(move) | (uint64_t(uint16_t(int16_t(score))) << MOVE_BITS)
+         | (uint64_t(uint8_t(depth)) << (MOVE_BITS + 16)) | (uint64_t(bound) << (MOVE_BITS + 24))
+         | (uint64_t(gen) << (MOVE_BITS + 26));
+}
+static Move dataMove(uint64_t d){ return Move(d & MOVE_MASK); }
+static int dataScore(uint64_t d){ return int16_t((d >> MOVE_BITS) & 0xFFFF); }
+static int dataDepth(uint64_t d){ return int((d >> (MOVE_BITS + 16)) & 0xFF); }
+static int dataBound(uint64_t d){ return int((d >> (MOVE_BITS + 24)) & 3); }
+static int dataGen(uint64_t d){ return int((d >> (MOVE_BITS + 26)) & 63); }
+
+TranspositionTable::TranspositionTable(size_t megabytes){ resize(megabytes); }
+
+TranspositionTable::~TranspositionTable(){ delete[] buckets; }
+
+void TranspositionTable::resize(size_t megabytes){
+    delete[] buckets;
+    // バケット数は2のべき乗に切り下げる
+    size_t n = 1;
+    while(n * 2 * sizeof(TTBucket) <= megabytes * 1024 * 1024) n *= 2;
+    bucketCount = n;
+    buckets = new TTBucket[n];     // alignas(64) なので C++17 の new が整列してくれる
+    clear();
+}
+
+void TranspositionTable::clear(){
+    for(size_t i=0;i<bucketCount;i++)
+        for(TTEntry& e : buckets[i].entries){
+            e.keyXor.store(0, std::memory_order_relaxed);
+            e.data.store(0, std::memory_order_relaxed);
+        }
+    generation = 0;
+}
+
+bool TranspositionTable::probe(uint64_t key, TTData& out) const {
+    const TTBucket& b = bucketOf(key);
+    for(const TTEntry& e : b.entries){
+        uint64_t d = e.data.load(std::memory_order_relaxed);
+        uint64_t k = e.keyXor.load(std::memory_order_relaxed);
+        if((k ^ d) != key || dataBound(d) == BOUND_NONE) continue;
+        out.move = dataMove(d);
+        out.score = dataScore(d);
+        out.depth = dataDepth(d);
+        out.bound = dataBound(d);
+        return true;
+    }
+    return false;
+}
+
+void TranspositionTable::store(uint64_t key, Move move, int score, int depth, int bound){
+    TTBucket& b = bucketOf(key);
+    TTEntry* replace = &b.entries[0];
+    int worst = 1 << 30;
+    for(TTEntry& e : b.entries){
+        uint64_t d = e.data.load(std::memory_order_relaxed);
+        uint64_t k = e.keyXor.load(std::memory_order_relaxed);
+        if((k ^ d) == key){
+            // 同じ局面: 浅い探索で深い結果を潰さない（ただし手は残す）
+            if(depth < dataDepth(d) - 2 && bound != BOUND_EXACT) return;
+            if(!move) move = dataMove(d);
+            replace = &e;
+            break;
+        }
+        // 古い世代・浅いエントリほど置き換えやすい
+        int age = (generation - dataGen(d)) & 63;
+        int value = dataDepth(d) - 8 * age;
+        if(value < worst){ worst = value; replace = &e; }
+    }
+    uint64_t d = packData(move, score, depth, bound, generation);
+    replace->data.store(d, std::memory_order_relaxed);
+    replace->keyXor.store(key ^ d, std::memory_order_relaxed);
+}
+
+int TranspositionTable::hashfull() const {
+    size_t n = bucketCount < 250 ? bucketCount : 250;
+    int used = 0;
+    for(size_t i=0;i<n;i++)
+        for(const TTEntry& e : buckets[i].entries){
+            uint64_t d = e.data.load(std::memory_order_relaxed);
+            if(dataBound(d) != BOUND_NONE && dataGen(d) == generation) used++;
+        }
+    return n ? int(used * 1000 / (n * 4)) : 0;
+}
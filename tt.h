@@ -0,0 +1,52 @@
+#pragma once
+#include "position.h"
+#include <cstddef>
+#include <atomic>
+
+// --- 置換表 ---
+// 1エントリ16バイト、4エントリで1キャッシュライン。
+// キーは data と XOR して格納するので、別スレッドの書き込みと混ざった
+// エントリは照合に失敗して自然に捨てられる。各ワードは relaxed の atomic で
+// 読み書きし、複数スレッドからロックなしで共有する（Lazy SMP）。
+enum Bound { BOUND_NONE, BOUND_UPPER, BOUND_LOWER, BOUND_EXACT };
+
+struct TTData {
+    Move move;
+    int score;
+    int depth;
+    int bound;
+};
+
+struct TTEntry {
+    std::atomic<uint64_t> keyXor{0};     // key ^ data
+    std::atomic<uint64_t> data{0};       // move 20 | score 16 | depth 8 | bound 2 | generation 6
+};
+
+struct alignas(64) TTBucket {
+    TTEntry entries[4];
+};
+
+class TranspositionTable {
+public:
+    TranspositionTable(size_t megabytes = 16);
+    ~TranspositionTable();
+    TranspositionTable(const TranspositionTable&) = delete;
+    TranspositionTable& operator=(const TranspositionTable&) = delete;
+
+    void resize(size_t megabytes);
+    void clear();
+    void newSearch(){ generation = (generation + 1) & 63; }     // 探索開始前に1スレッドから呼ぶ
+
+    bool probe(uint64_t key, TTData& out) const;
+    void store(uint64_t key, Move move, int score, int depth, int bound);
+
+    // 使用率（1000分率、先頭250バケット = 1000エントリから推定）
+    int hashfull() const;
+
+private:
+    TTBucket* buckets = nullptr;
+    size_t bucketCount = 0;
+    int generation = 0;
+
+    TTBucket& bucketOf(uint64_t key) const { return buckets[key & (bucketCount - 1)]; }
+};
@@ -0,0 +1,38 @@
+#pragma once
+#include "geometry.h"
+
+// --- Zobrist キー（コンパイル時生成、盤の大きさごと） ---
+// 8x8 の並びと種は元のままなので、記録や置換表のキーは変わらない
+template<class G>
+struct BasicZobristKeys {
+    uint64_t piece[2][6][G::SQUARES];    // [Color][PieceType][sq]
+    uint64_t flip[6][G::SQUARES];        // 反転用: 白と黒のキーの XOR（色を入れ替える）
+    uint64_t castling[64];
+    uint64_t ep[G::COLS];                // アンパッサンのマスの列
+    uint64_t side;                       // 黒番
+};
+
+constexpr uint64_t splitmix64(uint64_t& state){
+    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+template<class G>
+constexpr BasicZobristKeys<G> makeZobristKeys(){
+    BasicZobristKeys<G> z{};
+    uint64_t s = 0x4F636865'6C6C6F00ULL;   // "Ochello"
+    for(int c=0;c<2;c++) for(int t=0;t<6;t++) for(int sq=0;sq<G::SQUARES;sq++) z.piece[c][t][sq] = splitmix64(s);
+    for(int t=0;t<6;t++) for(int sq=0;sq<G::SQUARES;sq++) z.flip[t][sq] = z.piece[0][t][sq] ^ z.piece[1][t][sq];
+    for(int i=0;i<64;i++) z.castling[i] = i ? splitmix64(s) : 0;
+    for(int i=0;i<G::COLS;i++) z.ep[i] = splitmix64(s);
+    z.side = splitmix64(s);
+    return z;
+}
+
+template<class G>
+inline constexpr BasicZobristKeys<G> ZOBRIST_KEYS = makeZobristKeys<G>();
+
+typedef BasicZobristKeys<Geometry8> ZobristKeys;
+inline constexpr const ZobristKeys& ZOBRIST = ZOBRIST_KEYS<Geometry8>;